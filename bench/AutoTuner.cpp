@@ -0,0 +1,170 @@
+#include <catch2/catch_all.hpp>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <AutoTuner.h>
+#include <Backends.h>
+#include <Forces.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+/// Cache file for a test, removed again when it's done
+class TemporaryPath
+{
+  public:
+	TemporaryPath()
+		: _path(std::filesystem::temp_directory_path() / ("kinematics-demo-test-" + std::to_string(getpid()) + ".tsv"))
+	{
+		std::filesystem::remove(_path);
+	}
+	~TemporaryPath() { std::filesystem::remove(_path); }
+
+	TemporaryPath(const TemporaryPath &) = delete;
+	TemporaryPath &operator=(const TemporaryPath &) = delete;
+
+	const std::filesystem::path &Get() const { return _path; }
+
+  private:
+	std::filesystem::path _path;
+};
+} // namespace
+
+TEST_CASE("Backends", "[backends]")
+{
+	for (const auto *name : {"VectorOfStructSim", "StructOfVectorSim", "StructOfArraySim", "StructOfPointerSim",
+	                         "StructOfAlignedSim", "StructOfOversizedSim", "OmpSimdSim", "OmpForSim", "ShaderSim"})
+	{
+		const auto *backend = kinematics::FindBackend(name);
+		REQUIRE(backend);
+		CHECK(backend->name == name);
+	}
+	CHECK(kinematics::FindBackend("NotASim") == nullptr);
+
+	// Every CPU backend starts with an exact copy of the bodies, whatever the size
+	auto size = static_cast<size_t>(GENERATE(1, 1'000, 123'456));
+	const kinematics::VectorOfStructSim original(800, 600, size);
+	ForEachCpuBackend(size, [&](const kinematics::Backend &backend) {
+		RequireSameBodies(original.GetBodies(), backend.create(800, 600, original)->GetBodies());
+	});
+}
+
+TEST_CASE("AddBodies", "[backends]")
+{
+	// Every CPU backend adds bodies after its own exactly, from either layout and past whatever room it had
+	const kinematics::VectorOfStructSim original(800, 600, 1'000);
+	const auto added = kinematics::VectorOfStructSim(800, 600, 10'000).GetBodies();
+
+	std::vector<float> x, y, horizontalSpeed, verticalSpeed;
+	std::vector<Color> color;
+	for (const auto &body : added)
+	{
+		x.push_back(body.x);
+		y.push_back(body.y);
+		horizontalSpeed.push_back(body.horizontalSpeed);
+		verticalSpeed.push_back(body.verticalSpeed);
+		color.push_back(body.color);
+	}
+
+	const auto addBoth = [&](kinematics::Simulation &simulation) {
+		simulation.AddBodies(added);
+		simulation.AddBodies(x.data(), y.data(), horizontalSpeed.data(), verticalSpeed.data(), color.data(), 5'000);
+	};
+
+	kinematics::VectorOfStructSim expected(800, 600, original);
+	addBoth(expected);
+	REQUIRE(expected.GetNumBodies() == 16'000);
+
+	ForEachCpuBackend(expected.GetNumBodies(), [&](const kinematics::Backend &backend) {
+		auto simulation = backend.create(800, 600, original);
+		addBoth(*simulation);
+		RequireSameBodies(expected.GetBodies(), simulation->GetBodies());
+
+		// Adding again after removing some reuses the room that's left
+		simulation->SetNumBodies(original.GetNumBodies());
+		addBoth(*simulation);
+		RequireSameBodies(expected.GetBodies(), simulation->GetBodies());
+
+		simulation->AddBodies(std::span<const kinematics::Body>());
+		REQUIRE(simulation->GetNumBodies() == expected.GetNumBodies());
+	});
+}
+
+TEST_CASE("AutoTuner", "[backends]")
+{
+	CHECK(kinematics::AutoTuner::GetBucket(0) == 0);
+	CHECK(kinematics::AutoTuner::GetBucket(1) == 1);
+	CHECK(kinematics::AutoTuner::GetBucket(1'000) == kinematics::AutoTuner::GetBucket(1'023));
+	CHECK(kinematics::AutoTuner::GetBucket(1'023) != kinematics::AutoTuner::GetBucket(1'024));
+
+	const TemporaryPath cache;
+	const kinematics::VectorOfStructSim bodies(800, 600, 10'000);
+
+	kinematics::AutoTuner tuner(cache.Get());
+	const auto &chosen = tuner.Choose(800, 600, bodies);
+	CHECK_FALSE(chosen.requiresOpenGl);
+	CHECK(&tuner.Choose(800, 600, bodies) == &chosen);
+
+	// Change the decision on disk, which a new tuner should use rather than measuring again
+	std::stringstream contents;
+	contents << std::ifstream(cache.Get()).rdbuf();
+	REQUIRE(contents.str().find(chosen.name) != std::string::npos);
+	const auto other = chosen.name == "OmpForSim" ? "StructOfVectorSim" : "OmpForSim";
+	std::ofstream(cache.Get()) << std::regex_replace(contents.str(), std::regex(chosen.name), other);
+
+	kinematics::AutoTuner reloaded(cache.Get());
+	CHECK(reloaded.Choose(800, 600, bodies).name == other);
+
+	// Other buckets are still measured
+	const kinematics::VectorOfStructSim fewerBodies(800, 600, 10);
+	CHECK_FALSE(reloaded.Choose(800, 600, fewerBodies).requiresOpenGl);
+
+	// A backend that doesn't move bodies the same is never chosen, even if it was decided on before
+	std::ofstream(cache.Get()) << std::regex_replace(contents.str(), std::regex(chosen.name), "VariableRadiusSim");
+	kinematics::AutoTuner untunable(cache.Get());
+	CHECK(untunable.Choose(800, 600, bodies).tunable);
+
+	// Decisions for a workload are kept apart from those without one
+	const kinematics::Forces forces;
+	const kinematics::TuningWorkload workload{.forces = &forces, .recordsBounces = true};
+	CHECK(workload.GetName() == "forces, bounce events");
+	CHECK(tuner.Choose(800, 600, bodies, workload).tunable);
+	contents.str("");
+	contents << std::ifstream(cache.Get()).rdbuf();
+	CHECK(contents.str().find(" with forces, bounce events\t") != std::string::npos);
+}
+
+TEST_CASE("AutoTunedSim", "[backends]")
+{
+	const kinematics::VectorOfStructSim original(800, 600, 1'000);
+	kinematics::AutoTunedSim simulation(800, 600, original, kinematics::AutoTuner(""));
+	RequireSameBodies(original.GetBodies(), simulation.GetBodies());
+	CHECK(kinematics::FindBackend(simulation.GetBackendName()));
+
+	// Bodies carry over when crossing into another bucket, whether or not the backend changes
+	simulation.SetNumBodies(100'000);
+	REQUIRE(simulation.GetNumBodies() == 100'000);
+	simulation.SetNumBodies(1'000);
+	RequireSameBodies(original.GetBodies(), simulation.GetBodies());
+
+	// As do bodies added in bulk
+	const auto added = kinematics::VectorOfStructSim(800, 600, 99'000).GetBodies();
+	kinematics::VectorOfStructSim expected(800, 600, original);
+	expected.AddBodies(added);
+	simulation.AddBodies(added);
+	RequireSameBodies(expected.GetBodies(), simulation.GetBodies());
+	simulation.SetNumBodies(1'000);
+
+	kinematics::BodyFrame frame;
+	simulation.Update(1.f / 60.f);
+	simulation.CopyFrame(frame);
+	CHECK(frame.x.size() == 1'000);
+}
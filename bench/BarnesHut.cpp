@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <BarnesHut.h>
+#include <Forces.h>
+#include <NBodySim.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+constexpr float STRENGTH = 1, SOFTENING = kinematics::BODY_RADIUS;
+
+struct Accelerations
+{
+	std::vector<float> x, y;
+};
+
+/// @returns Acceleration of every body of `simulation` from every other, summed directly
+Accelerations Direct(const kinematics::StructOfVectorSim &simulation)
+{
+	kinematics::BodyFrame frame;
+	simulation.CopyFrame(frame);
+	Accelerations accelerations{std::vector<float>(frame.x.size()), std::vector<float>(frame.x.size())};
+	kinematics::AccelerateDirectly(frame.x.data(), frame.y.data(), frame.x.size(), STRENGTH, SOFTENING,
+	                               accelerations.x.data(), accelerations.y.data());
+	return accelerations;
+}
+
+/// @returns Acceleration of every body of `simulation` from every other, approximated with `theta`
+Accelerations Approximate(const kinematics::StructOfVectorSim &simulation, const float theta)
+{
+	kinematics::BodyFrame frame;
+	simulation.CopyFrame(frame);
+	kinematics::BarnesHutTree tree;
+	tree.Build(frame.x.data(), frame.y.data(), frame.x.size());
+	Accelerations accelerations{std::vector<float>(frame.x.size()), std::vector<float>(frame.x.size())};
+	tree.Accelerate(STRENGTH, theta, SOFTENING, accelerations.x.data(), accelerations.y.data());
+	return accelerations;
+}
+
+/// @returns Root mean square error of `approximate` relative to the root mean square of `exact`. Accelerations
+/// largely cancel out for bodies in the middle, so error relative to each of them alone would mostly measure those.
+float GetRelativeError(const Accelerations &approximate, const Accelerations &exact)
+{
+	double errorSquared = 0, exactSquared = 0;
+	for (size_t i = 0; i < exact.x.size(); i++)
+	{
+		const auto dx = approximate.x[i] - exact.x[i], dy = approximate.y[i] - exact.y[i];
+		errorSquared += static_cast<double>(dx * dx + dy * dy);
+		exactSquared += static_cast<double>(exact.x[i] * exact.x[i] + exact.y[i] * exact.y[i]);
+	}
+	return static_cast<float>(std::sqrt(errorSquared / exactSquared));
+}
+} // namespace
+
+TEST_CASE("BarnesHutTree", "[gravity]")
+{
+	const kinematics::StructOfVectorSim simulation(WIDTH, HEIGHT, 10'007);
+	const auto exact = Direct(simulation);
+
+	SECTION("Visiting every body matches summing every pair directly")
+	{
+		CHECK(GetRelativeError(Approximate(simulation, 0), exact) < 1e-5f);
+	}
+
+	SECTION("Approximation gets less accurate as theta grows")
+	{
+		const auto error = GetRelativeError(Approximate(simulation, 0.5f), exact);
+		const auto coarseError = GetRelativeError(Approximate(simulation, 1), exact);
+		INFO("Error with a theta of 0.5: " << error << ", and of 1: " << coarseError);
+		CHECK(error < 0.03f);
+		CHECK(coarseError < 0.15f);
+		CHECK(error < coarseError);
+	}
+
+	SECTION("Two bodies attract each other")
+	{
+		const std::vector<float> x{100, 300}, y{100, 100};
+		kinematics::BarnesHutTree tree;
+		tree.Build(x.data(), y.data(), x.size());
+
+		std::vector<float> accelerationX(2), accelerationY(2);
+		tree.Accelerate(STRENGTH, 0.5f, SOFTENING, accelerationX.data(), accelerationY.data());
+		const auto expected = STRENGTH * 200 / std::pow(200 * 200 + SOFTENING * SOFTENING, 1.5f);
+		REQUIRE_THAT(accelerationX[0], Catch::Matchers::WithinRel(expected, 1e-5f));
+		REQUIRE_THAT(accelerationX[1], Catch::Matchers::WithinRel(-expected, 1e-5f));
+		REQUIRE(accelerationY[0] == 0);
+		REQUIRE(accelerationY[1] == 0);
+	}
+
+	SECTION("Bodies at the same position")
+	{
+		const std::vector<float> x(1'000, 100), y(1'000, 200);
+		kinematics::BarnesHutTree tree;
+		tree.Build(x.data(), y.data(), x.size());
+		REQUIRE(tree.GetNumNodes() > 0);
+
+		std::vector<float> accelerationX(x.size(), 1), accelerationY(x.size(), 1);
+		tree.Accelerate(STRENGTH, 0.5f, SOFTENING, accelerationX.data(), accelerationY.data());
+		REQUIRE(std::ranges::all_of(accelerationX, [](const float acceleration) { return acceleration == 0; }));
+		REQUIRE(std::ranges::all_of(accelerationY, [](const float acceleration) { return acceleration == 0; }));
+	}
+
+	SECTION("Nothing to build")
+	{
+		kinematics::BarnesHutTree tree;
+		tree.Build(nullptr, nullptr, 0);
+		REQUIRE(tree.GetNumNodes() == 0);
+	}
+}
+
+TEST_CASE("NBodySim", "[gravity]")
+{
+	SECTION("Bodies are accelerated by gravity between them, on top of other forces")
+	{
+		constexpr float TOLERANCE = 1e-2f;
+		const kinematics::StructOfVectorSim original(WIDTH, HEIGHT, 10'007);
+		kinematics::NBodySim simulation(WIDTH, HEIGHT, original, 0);
+
+		kinematics::Forces forces;
+		forces.gravity = {0, 100};
+		forces.fields.push_back({WIDTH / 2, HEIGHT / 2, 1'000, 300});
+		simulation.SetForces(&forces);
+
+		// The same step with gravity between bodies given as an acceleration per body
+		auto accelerations = Direct(original);
+		for (auto *axis : {&accelerations.x, &accelerations.y})
+		{
+			for (auto &acceleration : *axis)
+				acceleration *= kinematics::NBodySim::TOTAL_STRENGTH / static_cast<float>(original.GetNumBodies());
+		}
+		forces.accelerationX = accelerations.x.data();
+		forces.accelerationY = accelerations.y.data();
+		kinematics::StructOfVectorSim expected(WIDTH, HEIGHT, original);
+		expected.SetForces(&forces);
+
+		expected.Update(TIME_STEP);
+		forces.accelerationX = forces.accelerationY = nullptr;
+		simulation.Update(TIME_STEP);
+
+		const auto bodies = simulation.GetBodies();
+		const auto expectedBodies = expected.GetBodies();
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			const auto &body = bodies[i], &expectedBody = expectedBodies[i];
+			REQUIRE_THAT(body.horizontalSpeed, Catch::Matchers::WithinAbs(expectedBody.horizontalSpeed, TOLERANCE));
+			REQUIRE_THAT(body.verticalSpeed, Catch::Matchers::WithinAbs(expectedBody.verticalSpeed, TOLERANCE));
+			REQUIRE_THAT(body.x, Catch::Matchers::WithinAbs(expectedBody.x, 1e-3));
+			REQUIRE_THAT(body.y, Catch::Matchers::WithinAbs(expectedBody.y, 1e-3));
+		}
+	}
+}
+
+TEST_CASE("Gravity between bodies", "[gravity]")
+{
+	for (const size_t numBodies : {10'000uz, 100'000uz, 1'000'000uz})
+	{
+		const kinematics::StructOfVectorSim simulation(WIDTH, HEIGHT, numBodies);
+		kinematics::BodyFrame frame;
+		simulation.CopyFrame(frame);
+		std::vector<float> accelerationX(numBodies), accelerationY(numBodies);
+
+		// Summing every pair takes too long past tens of thousands of bodies to be worth timing
+		if (numBodies <= 10'000)
+		{
+			BENCHMARK("Direct: " + std::to_string(numBodies))
+			{
+				return kinematics::AccelerateDirectly(frame.x.data(), frame.y.data(), numBodies, STRENGTH, SOFTENING,
+				                                      accelerationX.data(), accelerationY.data());
+			};
+		}
+
+		kinematics::BarnesHutTree tree;
+		BENCHMARK("Barnes-Hut build: " + std::to_string(numBodies))
+		{
+			return tree.Build(frame.x.data(), frame.y.data(), numBodies);
+		};
+		for (const auto theta : {0.3f, 0.5f, 1.f})
+		{
+			BENCHMARK("Barnes-Hut accelerate, theta " + std::to_string(theta).substr(0, 3) + ": " +
+			          std::to_string(numBodies))
+			{
+				return tree.Accelerate(STRENGTH, theta, SOFTENING, accelerationX.data(), accelerationY.data());
+			};
+		}
+
+		kinematics::NBodySim nBody(WIDTH, HEIGHT, simulation);
+		BENCHMARK("Update NBodySim: " + std::to_string(numBodies)) { return nBody.Update(TIME_STEP); };
+	}
+}
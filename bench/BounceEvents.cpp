@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <BounceEvents.h>
+#include <Backends.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+/// @returns Bounces of a step, found from which speeds changed sign between `before` and `after`
+std::vector<kinematics::BounceEvent> FindBounces(const std::vector<kinematics::Body> &before,
+                                                 const std::vector<kinematics::Body> &after)
+{
+	std::vector<kinematics::BounceEvent> bounces;
+	for (size_t i = 0; i < before.size(); i++)
+	{
+		const auto body = static_cast<uint32_t>(i);
+		if (before[i].horizontalSpeed != after[i].horizontalSpeed)
+			bounces.push_back({body, before[i].horizontalSpeed < 0 ? kinematics::Wall::Left : kinematics::Wall::Right});
+		if (before[i].verticalSpeed != after[i].verticalSpeed)
+			bounces.push_back({body, before[i].verticalSpeed < 0 ? kinematics::Wall::Top : kinematics::Wall::Bottom});
+	}
+	return bounces;
+}
+
+/// @returns `events` in order of body, then wall
+std::vector<kinematics::BounceEvent> Sorted(const std::span<const kinematics::BounceEvent> events)
+{
+	std::vector<kinematics::BounceEvent> sorted(events.begin(), events.end());
+	std::ranges::sort(sorted, {}, [](const auto &event) { return std::pair(event.body, event.wall); });
+	return sorted;
+}
+} // namespace
+
+TEST_CASE("BounceEvents", "[bounce]")
+{
+	// Not a multiple of any register width, so the bodies after the last whole register are covered too
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 10'007);
+
+	ForEachCpuBackend(original.GetNumBodies(), [&](const kinematics::Backend &backend) {
+		auto simulation = backend.create(WIDTH, HEIGHT, original);
+		auto unsubscribed = backend.create(WIDTH, HEIGHT, original);
+
+		kinematics::BounceEvents events;
+		simulation->SetBounceEvents(&events);
+
+		size_t numBounces = 0;
+		for (int step = 0; step < 120; step++)
+		{
+			const auto before = simulation->GetBodies();
+			simulation->Update(TIME_STEP);
+			unsubscribed->Update(TIME_STEP);
+
+			// Every bounce is recorded exactly once, and in order of body apart from within a register
+			const auto recorded = events.Get();
+			const auto expected = FindBounces(before, simulation->GetBodies());
+			REQUIRE(Sorted(recorded) == expected);
+			for (size_t i = 1; i < recorded.size(); i++)
+				REQUIRE(recorded[i].body + 16 > recorded[i - 1].body);
+			numBounces += recorded.size();
+		}
+		CHECK(numBounces > 0);
+
+		// Recording doesn't change how bodies move
+		const auto bodies = simulation->GetBodies();
+		const auto unsubscribedBodies = unsubscribed->GetBodies();
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			REQUIRE_THAT(bodies[i].x, Catch::Matchers::WithinAbs(unsubscribedBodies[i].x, 1e-3));
+			REQUIRE_THAT(bodies[i].y, Catch::Matchers::WithinAbs(unsubscribedBodies[i].y, 1e-3));
+			REQUIRE(bodies[i].horizontalSpeed == unsubscribedBodies[i].horizontalSpeed);
+			REQUIRE(bodies[i].verticalSpeed == unsubscribedBodies[i].verticalSpeed);
+		}
+
+		// Once unsubscribed, events are left as they were
+		simulation->SetBounceEvents(nullptr);
+		const auto last = Sorted(events.Get());
+		for (int step = 0; step < 10; step++)
+			simulation->Update(TIME_STEP);
+		REQUIRE(Sorted(events.Get()) == last);
+	});
+}
+
+TEST_CASE("Update recording bounces", "[bounce]")
+{
+	auto size = static_cast<size_t>(GENERATE(10'000, 1'000'000));
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, size);
+
+	for (const auto *name : {"VectorOfStructSim", "StructOfVectorSim", "OmpForSim"})
+	{
+		const auto *backend = kinematics::FindBackend(name);
+		auto simulation = backend->create(WIDTH, HEIGHT, original);
+		BENCHMARK(std::string("Update ") + name + ": " + std::to_string(size))
+		{
+			return simulation->Update(TIME_STEP);
+		};
+
+		kinematics::BounceEvents events;
+		simulation->SetBounceEvents(&events);
+		BENCHMARK(std::string("Update recording bounces ") + name + ": " + std::to_string(size))
+		{
+			simulation->Update(TIME_STEP);
+			return events.Get().size();
+		};
+	}
+}
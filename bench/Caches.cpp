@@ -0,0 +1,143 @@
+#include "Caches.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+/// @returns Bytes in a size such as "48K" or "32M" as written by the kernel, or 0 if it can't be parsed
+size_t ParseSize(const std::string &text)
+{
+	size_t parsed = 0;
+	size_t value = 0;
+	try
+	{
+		value = std::stoul(text, &parsed);
+	}
+	catch (const std::exception &)
+	{
+		return 0;
+	}
+
+	switch (parsed < text.size() ? text[parsed] : ' ')
+	{
+	case 'K':
+		return value << 10;
+	case 'M':
+		return value << 20;
+	case 'G':
+		return value << 30;
+	default:
+		return value;
+	}
+}
+
+size_t SysconfSize(const int name)
+{
+	const long value = sysconf(name);
+	return value > 0 ? static_cast<size_t>(value) : 0;
+}
+
+CacheSizes ReadCacheSizes()
+{
+	CacheSizes sizes{.l1d = 0, .l2 = 0, .llc = 0};
+	int llcLevel = 0;
+
+	for (int index = 0;; index++)
+	{
+		const std::string directory = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+		std::ifstream levelFile(directory + "level"), typeFile(directory + "type"), sizeFile(directory + "size");
+		if (!levelFile || !typeFile || !sizeFile)
+			break;
+
+		int level = 0;
+		std::string type, size;
+		levelFile >> level;
+		typeFile >> type;
+		sizeFile >> size;
+
+		if (type == "Instruction")
+			continue;
+
+		const auto bytes = ParseSize(size);
+		if (level == 1)
+			sizes.l1d = bytes;
+		else if (level == 2)
+			sizes.l2 = bytes;
+		else if (level > llcLevel)
+		{
+			sizes.llc = bytes;
+			llcLevel = level;
+		}
+	}
+
+	// Without sysfs, such as in some containers, glibc may still know from CPUID
+	if (!sizes.l1d)
+		sizes.l1d = SysconfSize(_SC_LEVEL1_DCACHE_SIZE);
+	if (!sizes.l2)
+		sizes.l2 = SysconfSize(_SC_LEVEL2_CACHE_SIZE);
+	if (!sizes.llc)
+		sizes.llc = SysconfSize(_SC_LEVEL3_CACHE_SIZE);
+
+	return sizes;
+}
+} // namespace
+
+const CacheSizes &GetCacheSizes()
+{
+	static const CacheSizes sizes = ReadCacheSizes();
+	return sizes;
+}
+
+Regime GetRegime(const size_t workingSetBytes)
+{
+	const auto &sizes = GetCacheSizes();
+	if (workingSetBytes <= sizes.l1d)
+		return Regime::L1;
+	if (workingSetBytes <= sizes.l2)
+		return Regime::L2;
+	if (workingSetBytes <= sizes.llc)
+		return Regime::Llc;
+	return Regime::Dram;
+}
+
+const char *GetRegimeName(const Regime regime)
+{
+	constexpr std::array<const char *, NUM_REGIMES> NAMES = {"L1", "L2", "LLC", "DRAM"};
+	return NAMES[static_cast<size_t>(regime)];
+}
+
+std::vector<SweepPoint> CacheSweep(const size_t bytesPerBody)
+{
+	const auto &sizes = GetCacheSizes();
+
+	std::vector<size_t> workingSets;
+	size_t largest = 0;
+	for (const auto level : {sizes.l1d, sizes.l2, sizes.llc})
+	{
+		// Skip a level that's missing, or no larger than the one before, as it has nothing of its own to measure
+		if (level <= largest)
+			continue;
+
+		workingSets.push_back(level / 2);
+		workingSets.push_back(level / 4 * 3);
+		largest = level;
+	}
+
+	// Nothing known about the caches at all still leaves DRAM to measure, past any cache a CPU is likely to have
+	constexpr size_t UNKNOWN_CACHE_BYTES = size_t{64} << 20;
+	const auto dramBoundary = largest ? largest : UNKNOWN_CACHE_BYTES;
+	workingSets.push_back(dramBoundary * 2);
+	workingSets.push_back(dramBoundary * 4);
+
+	std::vector<SweepPoint> points;
+	for (const auto bytes : workingSets)
+	{
+		const auto numBodies = std::max<size_t>(bytes / bytesPerBody, 1);
+		if (points.empty() || points.back().numBodies < numBodies)
+			points.push_back({numBodies, GetRegime(numBodies * bytesPerBody)});
+	}
+	return points;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/// Data cache sizes in bytes of the first CPU, with 0 for a level that doesn't exist or couldn't be found
+struct CacheSizes
+{
+	size_t l1d, l2, llc; // `llc` is the highest level past L2, such as L3
+};
+
+/// Level of the memory hierarchy a working set fits in
+enum class Regime
+{
+	L1,
+	L2,
+	Llc,
+	Dram,
+};
+constexpr size_t NUM_REGIMES = static_cast<size_t>(Regime::Dram) + 1;
+
+/// A number of bodies to benchmark, and where in the memory hierarchy they are expected to live
+struct SweepPoint
+{
+	size_t numBodies;
+	Regime regime;
+};
+
+/// @returns Cache sizes read from `/sys/devices/system/cpu/cpu0/cache`, falling back to what `sysconf` reports
+const CacheSizes &GetCacheSizes();
+
+/// @returns The smallest level that holds `workingSetBytes`
+Regime GetRegime(const size_t workingSetBytes);
+
+const char *GetRegimeName(const Regime regime);
+
+/// @returns Numbers of bodies on either side of every cache boundary, in increasing order: half and three quarters of
+/// each level, then two and four times the last level. Sizes are relative to the memory `Update()` streams through, so
+/// layouts with a different footprint are compared in the same regime rather than at the same count.
+/// @param bytesPerBody Memory used by each body during `Update()`
+std::vector<SweepPoint> CacheSweep(const size_t bytesPerBody);
@@ -0,0 +1,139 @@
+#include "Counters.h"
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+struct EventConfig
+{
+	uint32_t type;
+	uint64_t config;
+};
+
+constexpr uint64_t CacheConfig(const uint64_t cache, const uint64_t operation, const uint64_t result)
+{
+	return cache | (operation << 8) | (result << 16);
+}
+
+// Indexed by `Counter`
+constexpr std::array<EventConfig, NUM_COUNTERS> EVENTS = {{
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{PERF_TYPE_HW_CACHE,
+     CacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+	{PERF_TYPE_HW_CACHE,
+     CacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+	{PERF_TYPE_HW_CACHE,
+     CacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+
+/// Layout of a read with `PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING`
+struct ReadFormat
+{
+	uint64_t value, timeEnabled, timeRunning;
+};
+
+/// @returns File descriptor counting `event` on the calling thread, or -1 if it can't be counted
+int OpenEvent(const EventConfig &event)
+{
+	perf_event_attr attributes;
+	std::memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.type = event.type;
+	attributes.config = event.config;
+	attributes.disabled = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	constexpr pid_t CALLING_THREAD = 0;
+	constexpr int ANY_CPU = -1;
+	constexpr int NO_GROUP = -1;
+	return static_cast<int>(syscall(SYS_perf_event_open, &attributes, CALLING_THREAD, ANY_CPU, NO_GROUP, 0));
+}
+} // namespace
+
+PerfCounters::PerfCounters()
+{
+	// Counters only follow the thread that opened them, so each OpenMP thread opens its own
+#pragma omp parallel
+	{
+		for (size_t i = 0; i < NUM_COUNTERS; i++)
+		{
+			const int fd = OpenEvent(EVENTS[i]);
+			if (fd < 0)
+				continue;
+
+#pragma omp critical
+			_events.push_back({fd, static_cast<Counter>(i)});
+		}
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	for (const auto &event : _events)
+		close(event.fd);
+}
+
+bool PerfCounters::IsAvailable() const { return !_events.empty(); }
+
+void PerfCounters::Start()
+{
+	for (const auto &event : _events)
+		ioctl(event.fd, PERF_EVENT_IOC_RESET, 0);
+	for (const auto &event : _events)
+		ioctl(event.fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+void PerfCounters::Stop()
+{
+	for (const auto &event : _events)
+		ioctl(event.fd, PERF_EVENT_IOC_DISABLE, 0);
+}
+
+CounterValues PerfCounters::Read() const
+{
+	CounterValues values;
+	for (const auto &event : _events)
+	{
+		ReadFormat result;
+		if (read(event.fd, &result, sizeof(result)) != sizeof(result))
+			continue;
+
+		// A counter that never got to run says nothing, rather than zero
+		if (!result.timeRunning)
+			continue;
+
+		const double scale = static_cast<double>(result.timeEnabled) / static_cast<double>(result.timeRunning);
+		auto &value = values[static_cast<size_t>(event.counter)];
+		value = value.value_or(0) + static_cast<double>(result.value) * scale;
+	}
+	return values;
+}
+
+const char *PerfCounters::GetName(const Counter counter)
+{
+	switch (counter)
+	{
+	case Counter::Cycles:
+		return "cycles";
+	case Counter::Instructions:
+		return "instructions";
+	case Counter::L1dMisses:
+		return "l1dMisses";
+	case Counter::LlcMisses:
+		return "llcMisses";
+	case Counter::DtlbMisses:
+		return "dtlbMisses";
+	case Counter::BranchMisses:
+		return "branchMisses";
+	}
+	return "unknown";
+}
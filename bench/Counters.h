@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+/// Hardware events counted by `PerfCounters`
+enum class Counter
+{
+	Cycles,
+	Instructions,
+	L1dMisses,
+	LlcMisses,
+	DtlbMisses,
+	BranchMisses,
+};
+constexpr size_t NUM_COUNTERS = static_cast<size_t>(Counter::BranchMisses) + 1;
+
+/// A value for each `Counter`, or nothing where that counter isn't available
+using CounterValues = std::array<std::optional<double>, NUM_COUNTERS>;
+
+/// Counts hardware events with `perf_event_open`. Events are counted for the calling thread and every OpenMP thread
+/// that exists when constructed, since the threads of the OpenMP pool are reused by every parallel region.
+///
+/// Counters are optional: a kernel, VM or container that doesn't allow some (or any) of them just leaves those out.
+/// Only user space is counted so that the default `perf_event_paranoid` setting is enough.
+class PerfCounters
+{
+  public:
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters &) = delete;
+	PerfCounters &operator=(const PerfCounters &) = delete;
+
+	/// @returns Whether any counter could be opened
+	bool IsAvailable() const;
+
+	/// Reset every counter and start counting
+	void Start();
+
+	/// Stop counting, keeping the counts for `Read()`
+	void Stop();
+
+	/// @returns Counts since the last `Start()`, summed over every thread. Counts are scaled up if the kernel had to
+	/// share hardware counters between events.
+	CounterValues Read() const;
+
+	/// @returns Name of `counter` as used in reports
+	static const char *GetName(const Counter counter);
+
+  private:
+	struct Event
+	{
+		int fd;
+		Counter counter;
+	};
+	std::vector<Event> _events;
+};
@@ -0,0 +1,110 @@
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <DensityRasterizer.h>
+#include <kinematics.h>
+
+TEST_CASE("DensityRasterizer", "[density]")
+{
+	// Height isn't a multiple of the tile size, and bodies straddle the edges of tiles and the image
+	kinematics::DensityRasterizer rasterizer(100, 40);
+	const kinematics::BodyFrame frame{.x = {10.2f, 10.8f, 50, 99.9f, 0, -1, 100, 5},
+	                                  .y = {15.9f, 15.1f, 16, 39.9f, 0, 5, 5, 40},
+	                                  .color = {RED, BLUE, GREEN, WHITE, WHITE, WHITE, WHITE, WHITE}};
+	rasterizer.Rasterize(frame);
+
+	const auto pixels = rasterizer.GetPixels();
+	REQUIRE(pixels.size() == 100 * 40);
+	const auto pixel = [&pixels](const size_t x, const size_t y) { return pixels[y * 100 + x]; };
+
+	// Overlapping bodies average their colors and are more opaque than a single body
+	CHECK(pixel(10, 15).r == (RED.r + BLUE.r) / 2);
+	CHECK(pixel(10, 15).b == (RED.b + BLUE.b) / 2);
+	CHECK(pixel(10, 15).a > pixel(50, 16).a);
+	CHECK(pixel(50, 16).g == GREEN.g);
+	CHECK(pixel(99, 39).r == WHITE.r);
+	CHECK(pixel(0, 0).r == WHITE.r);
+
+	// Bodies outside of the image are ignored
+	size_t numCovered = 0;
+	for (const auto &color : pixels)
+		numCovered += color.a != 0;
+	CHECK(numCovered == 4);
+
+	// Nothing carries over between frames
+	rasterizer.Rasterize(kinematics::BodyFrame{});
+	CHECK(pixel(10, 15).a == 0);
+}
+
+TEST_CASE("DensityRasterizer matches reference", "[density]")
+{
+	constexpr int WIDTH = 800, HEIGHT = 600;
+	kinematics::StructOfVectorSim simulation(WIDTH, HEIGHT, 200'000);
+	kinematics::BodyFrame frame;
+	simulation.CopyFrame(frame);
+
+	kinematics::DensityRasterizer rasterizer(WIDTH, HEIGHT);
+	rasterizer.Rasterize(frame);
+
+	std::vector<uint32_t> counts(WIDTH * HEIGHT), red(WIDTH * HEIGHT);
+	for (size_t i = 0; i < frame.x.size(); i++)
+	{
+		const auto index = static_cast<size_t>(frame.y[i]) * WIDTH + static_cast<size_t>(frame.x[i]);
+		counts[index]++;
+		red[index] += frame.color[i].r;
+	}
+
+	const auto pixels = rasterizer.GetPixels();
+	size_t mismatches = 0;
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		const bool covered = pixels[i].a != 0;
+		mismatches += covered != (counts[i] != 0);
+		if (counts[i])
+			mismatches += pixels[i].r != red[i] / counts[i];
+	}
+	CHECK(mismatches == 0);
+}
+
+TEST_CASE("DensityRasterizer PPM", "[density]")
+{
+	kinematics::DensityRasterizer rasterizer(4, 2);
+	rasterizer.Rasterize(kinematics::BodyFrame{.x = {1}, .y = {1}, .color = {WHITE}});
+
+	const auto path = std::filesystem::temp_directory_path() / "kinematics-density.ppm";
+	REQUIRE(rasterizer.WritePpm(path.string()));
+
+	std::ifstream file(path, std::ios::binary);
+	std::string magic;
+	int width, height, maxValue;
+	file >> magic >> width >> height >> maxValue;
+	file.get();
+	std::vector<char> rgb(4 * 2 * 3);
+	file.read(rgb.data(), static_cast<std::streamsize>(rgb.size()));
+
+	CHECK(magic == "P6");
+	CHECK(width == 4);
+	CHECK(height == 2);
+	CHECK(maxValue == 255);
+	CHECK(file.gcount() == static_cast<std::streamsize>(rgb.size()));
+	CHECK(rgb[0] == 0);
+	CHECK(rgb[(1 * 4 + 1) * 3] != 0);
+
+	file.close();
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("DensityRasterizer benchmark", "[density][!benchmark]")
+{
+	auto size = static_cast<size_t>(GENERATE(1'000'000, 10'000'000));
+	kinematics::StructOfVectorSim simulation(1920, 1080, size);
+	kinematics::BodyFrame frame;
+	simulation.CopyFrame(frame);
+
+	kinematics::DensityRasterizer rasterizer(1920, 1080);
+	BENCHMARK("Rasterize: " + std::to_string(size)) { return rasterizer.Rasterize(frame); };
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <raylib.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Backends.h>
+#include <kinematics.h>
+
+#include "HiddenWindow.h"
+
+namespace
+{
+constexpr int WIDTH = 800, HEIGHT = 600;
+
+using NamedSimulations = std::vector<std::pair<std::string, std::unique_ptr<kinematics::Simulation>>>;
+
+/// @returns A copy of `original` in every registered backend
+/// @param withOpenGl Whether to include backends that need an OpenGL context, rather than only those on the CPU
+NamedSimulations CopyToEveryBackend(const kinematics::Simulation &original, const bool withOpenGl)
+{
+	NamedSimulations simulations;
+	for (const auto &backend : kinematics::GetBackends())
+	{
+		if (withOpenGl || !backend.requiresOpenGl)
+			simulations.emplace_back(backend.name, backend.create(WIDTH, HEIGHT, original));
+	}
+	return simulations;
+}
+
+/// Draw a full frame into `target`, waiting for the GPU to finish so the cost of drawing is measured rather than only
+/// the cost of submitting commands
+void DrawFrame(const kinematics::Simulation &simulation, const RenderTexture2D &target)
+{
+	BeginTextureMode(target);
+	ClearBackground(BEIGE);
+	simulation.Draw();
+	EndTextureMode();
+	glFinish();
+}
+} // namespace
+
+TEST_CASE("Draw", "[draw]")
+{
+	auto size = static_cast<size_t>(GENERATE(1'000, 10'000, 100'000, 1'000'000, 5'000'000));
+
+	// `ShaderSim` sets up its buffers as it's created, so the window has to be opened first
+	HiddenWindow window(WIDTH, HEIGHT);
+	if (!window.IsReady())
+		SKIP("No OpenGL context available");
+
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, size);
+	auto simulations = CopyToEveryBackend(original, true);
+
+	RenderTexture2D target = LoadRenderTexture(WIDTH, HEIGHT);
+
+	constexpr float TIME_CONSTANT = 1.f / 60.f;
+	for (auto &[name, simulation] : simulations)
+	{
+		BENCHMARK("Draw " + name + ": " + std::to_string(size)) { return DrawFrame(*simulation, target); };
+
+		// Everything the application does each frame, other than handling input
+		BENCHMARK("Frame " + name + ": " + std::to_string(size))
+		{
+			simulation->Update(TIME_CONSTANT);
+			return DrawFrame(*simulation, target);
+		};
+	}
+
+	// `ShaderSim` keeps its bodies on the GPU, so even reading them back needs a context
+	const auto isShaderSim = [](const auto &named) { return named.first == "ShaderSim"; };
+	auto &shaderSim = *std::find_if(simulations.cbegin(), simulations.cend(), isShaderSim)->second;
+	BENCHMARK("GetBodies ShaderSim: " + std::to_string(size)) { return shaderSim.GetBodies(); };
+	BENCHMARK("SetNumBodies ShaderSim: " + std::to_string(size))
+	{
+		shaderSim.SetNumBodies(size / 2);
+		return shaderSim.SetNumBodies(size);
+	};
+
+	UnloadRenderTexture(target);
+}
+
+TEST_CASE("Bodies", "[bodies]")
+{
+	auto size = static_cast<size_t>(GENERATE(1'000, 10'000, 100'000, 1'000'000, 5'000'000));
+
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, size);
+	auto simulations = CopyToEveryBackend(original, false);
+
+	// As many bodies as a spawner adds in a frame
+	const auto spawned = kinematics::VectorOfStructSim(WIDTH, HEIGHT, 100'000).GetBodies();
+
+	for (auto &[name, simulation] : simulations)
+	{
+		BENCHMARK("GetBodies " + name + ": " + std::to_string(size)) { return simulation->GetBodies(); };
+
+		// Removing bodies is cheap for every implementation, so this mostly measures adding them back
+		BENCHMARK("SetNumBodies " + name + ": " + std::to_string(size))
+		{
+			simulation->SetNumBodies(size / 2);
+			return simulation->SetNumBodies(size);
+		};
+
+		if (size + spawned.size() <= kinematics::FindBackend(name)->maxBodies)
+		{
+			BENCHMARK("AddBodies " + std::to_string(spawned.size()) + " " + name + ": " + std::to_string(size))
+			{
+				simulation->SetNumBodies(size);
+				return simulation->AddBodies(spawned);
+			};
+		}
+	}
+
+	// Conversions all start from the Array of Structures layout of `original`
+	const auto &source = original;
+	BENCHMARK("Convert VectorOfStructSim: " + std::to_string(size))
+	{
+		return std::make_unique<kinematics::VectorOfStructSim>(WIDTH, HEIGHT, source);
+	};
+	BENCHMARK("Convert StructOfVectorSim: " + std::to_string(size))
+	{
+		return std::make_unique<kinematics::StructOfVectorSim>(WIDTH, HEIGHT, source);
+	};
+	BENCHMARK("Convert StructOfArraySim: " + std::to_string(size))
+	{
+		return std::make_unique<kinematics::StructOfArraySim<5'000'000>>(WIDTH, HEIGHT, source);
+	};
+	BENCHMARK("Convert StructOfPointerSim: " + std::to_string(size))
+	{
+		return std::make_unique<kinematics::StructOfPointerSim>(WIDTH, HEIGHT, source);
+	};
+	BENCHMARK("Convert StructOfAlignedSim: " + std::to_string(size))
+	{
+		return std::make_unique<kinematics::StructOfAlignedSim>(WIDTH, HEIGHT, source);
+	};
+	BENCHMARK("Convert StructOfOversizedSim: " + std::to_string(size))
+	{
+		return std::make_unique<kinematics::StructOfOversizedSim>(WIDTH, HEIGHT, source);
+	};
+}
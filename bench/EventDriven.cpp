@@ -0,0 +1,139 @@
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <vector>
+
+#include <EventDrivenSim.h>
+#include <Forces.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+// Positions are found from the time since each was stored rather than added up a step at a time, so round differently
+constexpr float TOLERANCE = 1e-2f;
+
+/// @returns The number of bodies whose speed changed between `before` and `after`
+size_t CountBounces(const std::vector<kinematics::Body> &before, const std::vector<kinematics::Body> &after)
+{
+	size_t numBounces = 0;
+	for (size_t i = 0; i < before.size(); i++)
+	{
+		numBounces += before[i].horizontalSpeed != after[i].horizontalSpeed ||
+		              before[i].verticalSpeed != after[i].verticalSpeed;
+	}
+	return numBounces;
+}
+} // namespace
+
+TEST_CASE("EventDrivenSim", "[event-driven]")
+{
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 1'009);
+	kinematics::EventDrivenSim simulation(WIDTH, HEIGHT, original);
+
+	SECTION("Steps match moving every body, including past storing every position again")
+	{
+		constexpr auto NUM_STEPS = static_cast<int>(kinematics::EventDrivenSim::REBASE_SECONDS * 60) + 120;
+		for (int step = 0; step < NUM_STEPS; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+	}
+
+	SECTION("Only bodies that bounce are visited")
+	{
+		kinematics::EventDrivenSim many(WIDTH, HEIGHT, 100'003);
+		many.Update(TIME_STEP); // schedules every body
+
+		size_t numVisited = 0, numBounces = 0;
+		for (int step = 0; step < 60; step++)
+		{
+			const auto before = many.GetBodies();
+			many.Update(TIME_STEP);
+			numBounces += CountBounces(before, many.GetBodies());
+			numVisited += many.GetNumVisited();
+		}
+		INFO("Visited " << numVisited << " bodies for " << numBounces << " bounces");
+		CHECK(numBounces > 0);
+		// Bodies that end a step exactly at a wall, which starting at whole numbers makes common, are due but only
+		// bounce the step after
+		CHECK(numVisited >= numBounces);
+		CHECK(numVisited < numBounces + numBounces / 20 + 10);
+		CHECK(numVisited < 60 * many.GetNumBodies() / 10);
+	}
+
+	SECTION("Bodies can be added and removed and bounds changed between steps")
+	{
+		for (int step = 0; step < 30; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+
+		simulation.SetNumBodies(500);
+		for (int step = 0; step < 30; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+
+		simulation.SetNumBodies(2'000);
+		REQUIRE(simulation.GetNumBodies() == 2'000);
+		for (int step = 0; step < 30; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+
+		simulation.SetBounds(WIDTH / 2, HEIGHT / 2);
+		for (int step = 0; step < 120; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+	}
+
+	SECTION("Forces move every body, and bounces are scheduled again once they're gone")
+	{
+		kinematics::Forces forces;
+		forces.gravity = {0, 200};
+		simulation.SetForces(&forces);
+
+		kinematics::StructOfVectorSim expected(WIDTH, HEIGHT, original);
+		expected.SetForces(&forces);
+		for (int step = 0; step < 30; step++)
+		{
+			simulation.Update(TIME_STEP);
+			expected.Update(TIME_STEP);
+			REQUIRE(simulation.GetNumVisited() == simulation.GetNumBodies());
+		}
+
+		const auto bodies = simulation.GetBodies(), expectedBodies = expected.GetBodies();
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			REQUIRE(bodies[i].x == expectedBodies[i].x);
+			REQUIRE(bodies[i].y == expectedBodies[i].y);
+			REQUIRE(bodies[i].horizontalSpeed == expectedBodies[i].horizontalSpeed);
+			REQUIRE(bodies[i].verticalSpeed == expectedBodies[i].verticalSpeed);
+		}
+
+		simulation.SetForces(nullptr);
+		for (int step = 0; step < 120; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+		CHECK(simulation.GetNumVisited() < simulation.GetNumBodies());
+	}
+}
+
+TEST_CASE("Event-driven update", "[event-driven]")
+{
+	constexpr size_t NUM_BODIES = 1'000'000;
+
+	// The same bodies at the same speeds bounce a tenth as often in bounds ten times as wide and high
+	for (const float scale : {1.f, 10.f})
+	{
+		const auto width = WIDTH * scale, height = HEIGHT * scale;
+		const kinematics::VectorOfStructSim original(width, height, NUM_BODIES);
+		const auto suffix = std::to_string(static_cast<int>(width)) + "x" + std::to_string(static_cast<int>(height)) +
+		                    ": " + std::to_string(NUM_BODIES);
+
+		kinematics::StructOfVectorSim sweep(width, height, original);
+		BENCHMARK("Update StructOfVectorSim " + suffix) { return sweep.Update(TIME_STEP); };
+
+		kinematics::EventDrivenSim eventDriven(width, height, original);
+		eventDriven.Update(TIME_STEP); // schedules every body
+		BENCHMARK("Update EventDrivenSim " + suffix) { return eventDriven.Update(TIME_STEP); };
+
+		kinematics::BodyFrame frame;
+		BENCHMARK("Update and copy frame EventDrivenSim " + suffix)
+		{
+			eventDriven.Update(TIME_STEP);
+			return eventDriven.CopyFrame(frame);
+		};
+	}
+}
@@ -0,0 +1,49 @@
+#include "Fixtures.h"
+#include <cmath>
+
+bool IsAtWall(const float position, const float bounds, const float tolerance, const float radius)
+{
+	return std::abs(position - radius) < tolerance || std::abs(position + radius - bounds) < tolerance;
+}
+
+void RequireStepLikeSweep(kinematics::Simulation &simulation, const float tolerance)
+{
+	const auto width = simulation.GetWidth(), height = simulation.GetHeight();
+	const auto before = simulation.GetBodies();
+	const auto radii = simulation.GetRadii();
+	simulation.Update(TIME_STEP);
+	const auto after = simulation.GetBodies();
+	REQUIRE(after.size() == before.size());
+
+	for (size_t i = 0; i < before.size(); i++)
+	{
+		const auto horizontalSpeed = before[i].horizontalSpeed, verticalSpeed = before[i].verticalSpeed;
+		const auto x = before[i].x + horizontalSpeed * TIME_STEP;
+		const auto y = before[i].y + verticalSpeed * TIME_STEP;
+		REQUIRE_THAT(after[i].x, Catch::Matchers::WithinAbs(x, tolerance));
+		REQUIRE_THAT(after[i].y, Catch::Matchers::WithinAbs(y, tolerance));
+
+		const auto radius = radii.empty() ? kinematics::BODY_RADIUS : radii[i];
+		const bool bounceHorizontally =
+			(x - radius < 0 && horizontalSpeed < 0) || (x + radius > width && horizontalSpeed > 0);
+		const bool bounceVertically = (y - radius < 0 && verticalSpeed < 0) || (y + radius > height && verticalSpeed > 0);
+		if (!IsAtWall(x, width, tolerance, radius))
+			REQUIRE(after[i].horizontalSpeed == (bounceHorizontally ? -1 : 1) * horizontalSpeed);
+		if (!IsAtWall(y, height, tolerance, radius))
+			REQUIRE(after[i].verticalSpeed == (bounceVertically ? -1 : 1) * verticalSpeed);
+	}
+}
+
+void RequireSameBodies(const std::vector<kinematics::Body> &expected, const std::vector<kinematics::Body> &actual)
+{
+	REQUIRE(expected.size() == actual.size());
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		REQUIRE(expected[i].x == actual[i].x);
+		REQUIRE(expected[i].y == actual[i].y);
+		REQUIRE(expected[i].horizontalSpeed == actual[i].horizontalSpeed);
+		REQUIRE(expected[i].verticalSpeed == actual[i].verticalSpeed);
+		REQUIRE(expected[i].color.r == actual[i].color.r);
+		REQUIRE(expected[i].color.a == actual[i].color.a);
+	}
+}
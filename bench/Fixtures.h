@@ -0,0 +1,40 @@
+#pragma once
+#include <catch2/catch_all.hpp>
+#include <cstddef>
+#include <vector>
+
+#include <Backends.h>
+#include <kinematics.h>
+
+// Bounds and step of the tests that don't need particular ones
+constexpr float WIDTH = 1920, HEIGHT = 1080;
+constexpr float TIME_STEP = 1.f / 60.f;
+
+/// @returns Whether `position` is within `tolerance` of where a body of `radius` bounces off a wall, so that rounding
+/// differently could bounce it a step earlier or later
+bool IsAtWall(const float position, const float bounds, const float tolerance,
+              const float radius = kinematics::BODY_RADIUS);
+
+/// Update `simulation` by `TIME_STEP`, requiring that every body moved and bounced as `Simulation::UpdateHelper` would,
+/// at its own radius for simulations that have them. Positions may differ by up to `tolerance`, for simulations that
+/// round differently, and bodies within that of a wall may bounce either way.
+void RequireStepLikeSweep(kinematics::Simulation &simulation, const float tolerance);
+
+/// Require that `actual` has exactly the bodies of `expected`, in the same order
+void RequireSameBodies(const std::vector<kinematics::Body> &expected, const std::vector<kinematics::Body> &actual);
+
+/// Run `test(backend)` in a section of its own for every registered backend that runs on the CPU and can hold
+/// `numBodies`
+template <typename Test> void ForEachCpuBackend(const size_t numBodies, const Test &test)
+{
+	for (const auto &backend : kinematics::GetBackends())
+	{
+		if (backend.requiresOpenGl || numBodies > backend.maxBodies)
+			continue;
+
+		DYNAMIC_SECTION(backend.name)
+		{
+			test(backend);
+		}
+	}
+}
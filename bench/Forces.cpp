@@ -0,0 +1,128 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <Backends.h>
+#include <BounceEvents.h>
+#include <Forces.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+/// @returns Gravity, drag and `numFields` fields alternating between attracting and repelling, spread across the bounds
+kinematics::Forces GetForces(const size_t numFields)
+{
+	kinematics::Forces forces;
+	forces.gravity = {10, 200};
+	forces.drag = 0.1f;
+	for (size_t i = 0; i < numFields; i++)
+	{
+		const auto fraction = static_cast<float>(i + 1) / static_cast<float>(numFields + 1);
+		forces.fields.push_back({WIDTH * fraction, HEIGHT * (1 - fraction), i % 2 ? -3'000.f : 3'000.f, 400});
+	}
+	return forces;
+}
+} // namespace
+
+TEST_CASE("Forces in every backend", "[forces]")
+{
+	constexpr size_t NUM_BODIES = 10'007;
+	auto forces = GetForces(4);
+	std::vector<float> accelerationX, accelerationY;
+	for (size_t i = 0; i < NUM_BODIES; i++)
+	{
+		accelerationX.push_back(static_cast<float>(GetRandomValue(-50, 50)));
+		accelerationY.push_back(static_cast<float>(GetRandomValue(-50, 50)));
+	}
+
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, NUM_BODIES);
+	ForEachCpuBackend(original.GetNumBodies(), [&](const kinematics::Backend &backend) {
+		auto simulation = backend.create(WIDTH, HEIGHT, original);
+		simulation->SetForces(&forces);
+		auto radii = simulation->GetRadii();
+		radii.resize(NUM_BODIES, kinematics::BODY_RADIUS);
+
+		// Half of the steps have per body acceleration, and half record bounces, which moves bodies with a separate
+		// loop
+		kinematics::BounceEvents events;
+		for (int step = 0; step < 120; step++)
+		{
+			if (step == 30)
+			{
+				forces.accelerationX = accelerationX.data();
+				forces.accelerationY = accelerationY.data();
+			}
+			if (step == 60)
+				simulation->SetBounceEvents(&events);
+			if (step == 90)
+			{
+				forces.accelerationX = nullptr;
+				forces.accelerationY = nullptr;
+			}
+
+			const auto before = simulation->GetBodies();
+			simulation->Update(TIME_STEP);
+			const auto after = simulation->GetBodies();
+
+			// Accelerated one body at a time, then moved and bounced the same as `Simulation::BounceCheck`
+			for (size_t i = 0; i < before.size(); i++)
+			{
+				auto horizontalSpeed = before[i].horizontalSpeed, verticalSpeed = before[i].verticalSpeed;
+				kinematics::Accelerate(forces, TIME_STEP, before[i].x, before[i].y, horizontalSpeed, verticalSpeed,
+				                       i);
+				const auto x = before[i].x + horizontalSpeed * TIME_STEP;
+				const auto y = before[i].y + verticalSpeed * TIME_STEP;
+				REQUIRE_THAT(after[i].x, Catch::Matchers::WithinAbs(x, 1e-3));
+				REQUIRE_THAT(after[i].y, Catch::Matchers::WithinAbs(y, 1e-3));
+
+				const bool bounceHorizontally = (x - radii[i] < 0 && horizontalSpeed < 0) ||
+				                                (x + radii[i] > WIDTH && horizontalSpeed > 0);
+				const bool bounceVertically = (y - radii[i] < 0 && verticalSpeed < 0) ||
+				                              (y + radii[i] > HEIGHT && verticalSpeed > 0);
+				REQUIRE_THAT(after[i].horizontalSpeed,
+				             Catch::Matchers::WithinAbs((bounceHorizontally ? -1 : 1) * horizontalSpeed, 1e-3));
+				REQUIRE_THAT(after[i].verticalSpeed,
+				             Catch::Matchers::WithinAbs((bounceVertically ? -1 : 1) * verticalSpeed, 1e-3));
+			}
+		}
+
+		// Without forces bodies go back to moving in straight lines
+		simulation->SetForces(nullptr);
+		const auto before = simulation->GetBodies();
+		simulation->Update(TIME_STEP);
+		const auto after = simulation->GetBodies();
+		for (size_t i = 0; i < before.size(); i++)
+			REQUIRE(std::abs(after[i].horizontalSpeed) == std::abs(before[i].horizontalSpeed));
+	});
+}
+
+TEST_CASE("Update with forces", "[forces]")
+{
+	constexpr size_t NUM_BODIES = 1'000'000;
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, NUM_BODIES);
+
+	kinematics::Forces gravity;
+	gravity.gravity = {0, 200};
+	const auto oneField = GetForces(1), fourFields = GetForces(4);
+
+	for (const auto *name : {"StructOfVectorSim", "OmpSimdSim", "OmpForSim"})
+	{
+		const auto *backend = kinematics::FindBackend(name);
+		auto simulation = backend->create(WIDTH, HEIGHT, original);
+
+		const auto suffix = std::string(name) + ": " + std::to_string(NUM_BODIES);
+		BENCHMARK("Update without forces " + suffix) { return simulation->Update(TIME_STEP); };
+
+		simulation->SetForces(&gravity);
+		BENCHMARK("Update with gravity " + suffix) { return simulation->Update(TIME_STEP); };
+
+		simulation->SetForces(&oneField);
+		BENCHMARK("Update with gravity, drag and 1 field " + suffix) { return simulation->Update(TIME_STEP); };
+
+		simulation->SetForces(&fourFields);
+		BENCHMARK("Update with gravity, drag and 4 fields " + suffix) { return simulation->Update(TIME_STEP); };
+	}
+}
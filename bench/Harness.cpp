@@ -0,0 +1,336 @@
+#include "Harness.h"
+#include "Caches.h"
+#include <AutoTuner.h>
+#include <Backends.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <omp.h>
+#include <optional>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+constexpr float TIME_CONSTANT = 1.f / 60.f;
+
+std::vector<UpdateResult> results;
+
+#if defined(__clang__)
+constexpr const char *COMPILER = "clang " __clang_version__;
+#elif defined(__GNUC__)
+constexpr const char *COMPILER = "gcc " __VERSION__;
+#else
+constexpr const char *COMPILER = "unknown";
+#endif
+
+/// @returns Two-sided 95% critical value of Student's t-distribution
+double StudentT95(const size_t degreesOfFreedom)
+{
+	constexpr std::array<double, 30> TABLE = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	                                          2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	                                          2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+	if (degreesOfFreedom == 0)
+		return 0;
+	return degreesOfFreedom <= TABLE.size() ? TABLE[degreesOfFreedom - 1] : 1.96;
+}
+
+/// Counters are opened once, by `PinThreads()`, while every OpenMP thread they need to follow is in use
+PerfCounters &GetCounters()
+{
+	static PerfCounters counters;
+	return counters;
+}
+
+double TimeUpdates(kinematics::Simulation &simulation, const size_t numUpdates)
+{
+	const auto start = Clock::now();
+	for (size_t i = 0; i < numUpdates; i++)
+		simulation.Update(TIME_CONSTANT);
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// @returns `value` as JSON, which has no representation for a missing number other than `null`
+std::string JsonNumber(const std::optional<double> &value)
+{
+	if (!value)
+		return "null";
+
+	std::ostringstream stream;
+	stream.precision(9);
+	stream << *value;
+	return stream.str();
+}
+
+std::string HostName()
+{
+	std::array<char, 256> name{};
+	return gethostname(name.data(), name.size() - 1) == 0 ? name.data() : "unknown";
+}
+
+/// @returns Name of the binding policy the OpenMP runtime is using, as `OMP_PROC_BIND` would set it
+std::string ProcBindName()
+{
+	switch (omp_get_proc_bind())
+	{
+	case omp_proc_bind_false:
+		return "false";
+	case omp_proc_bind_true:
+		return "true";
+	case omp_proc_bind_master:
+		return "master";
+	case omp_proc_bind_close:
+		return "close";
+	case omp_proc_bind_spread:
+		return "spread";
+	}
+	return "unknown";
+}
+
+/// @returns Place each OpenMP thread is bound to, by thread number, or -1 for threads that aren't bound
+std::vector<int> ThreadPlaces()
+{
+	std::vector<int> places(static_cast<size_t>(omp_get_max_threads()), -1);
+#pragma omp parallel
+	places[static_cast<size_t>(omp_get_thread_num())] = omp_get_place_num();
+	return places;
+}
+
+/// @returns `text` as a quoted JSON string
+std::string Quote(const std::string &text)
+{
+	std::string quoted = "\"";
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+			quoted += '\\';
+		if (static_cast<unsigned char>(c) >= 0x20)
+			quoted += c;
+	}
+	return quoted + "\"";
+}
+} // namespace
+
+double UpdateResult::BodiesPerSecond() const { return static_cast<double>(numBodies) / mean; }
+
+double UpdateResult::GigabytesPerSecond() const
+{
+	return BodiesPerSecond() * static_cast<double>(bytesMovedPerBody) / 1e9;
+}
+
+const std::vector<Implementation> &GetImplementations()
+{
+	static const auto implementations = [] {
+		std::vector<Implementation> cpuBackends;
+		for (const auto &backend : kinematics::GetBackends())
+		{
+			if (backend.requiresOpenGl)
+				continue;
+
+			const auto create = [&backend](const kinematics::Simulation &toCopy) {
+				return backend.create(800, 600, toCopy);
+			};
+			cpuBackends.push_back({backend.name, create, backend.bytesPerBody, backend.maxBodies});
+		}
+		return cpuBackends;
+	}();
+	return implementations;
+}
+
+HarnessOptions &GetHarnessOptions()
+{
+	static HarnessOptions options;
+	return options;
+}
+
+void PinThreads(char *argv[])
+{
+	// The OpenMP runtime reads its environment when it's loaded, so setting it here only takes effect in a new process
+	if (!std::getenv("OMP_PROC_BIND") || !std::getenv("OMP_PLACES"))
+	{
+		constexpr int KEEP_EXISTING = 0;
+		setenv("OMP_PROC_BIND", "close", KEEP_EXISTING);
+		setenv("OMP_PLACES", "cores", KEEP_EXISTING);
+		execv("/proc/self/exe", argv);
+		std::perror("Failed to restart with OpenMP threads bound to cores");
+	}
+
+	// The calling thread is bound, and the other threads started, the first time the runtime starts threads
+#pragma omp parallel
+	{
+	}
+
+	if (omp_get_proc_bind() == omp_proc_bind_false || omp_get_num_places() == 0)
+		std::fprintf(stderr, "OpenMP threads are not bound, so results may depend on where the OS moves them\n");
+
+	GetCounters();
+}
+
+UpdateResult MeasureUpdate(const std::string &implementation, const SimulationFactory &create,
+                           const kinematics::Simulation &snapshot, const size_t bytesPerBody)
+{
+	const auto &options = GetHarnessOptions();
+	UpdateResult result{.implementation = implementation,
+	                    .numBodies = snapshot.GetNumBodies(),
+	                    .regime = {},
+	                    .threads = omp_get_max_threads(),
+	                    .bytesMovedPerBody = 2 * bytesPerBody,
+	                    .updatesPerSample = 1,
+	                    .samples = {},
+	                    .mean = 0,
+	                    .median = 0,
+	                    .standardDeviation = 0,
+	                    .confidenceLow = 0,
+	                    .confidenceHigh = 0,
+	                    .counters = {}};
+
+	// Find how many updates make a sample long enough to time accurately. Each attempt starts from the snapshot too,
+	// so the chosen count covers the same updates the samples will run.
+	while (true)
+	{
+		auto simulation = create(snapshot);
+		if (TimeUpdates(*simulation, result.updatesPerSample) >= options.minSampleSeconds)
+			break;
+		result.updatesPerSample *= 2;
+	}
+
+	auto &counters = GetCounters();
+	for (size_t sample = 0; sample < options.samples; sample++)
+	{
+		auto simulation = create(snapshot);
+
+		counters.Start();
+		const auto seconds = TimeUpdates(*simulation, result.updatesPerSample);
+		counters.Stop();
+
+		result.samples.push_back(seconds / static_cast<double>(result.updatesPerSample));
+
+		const auto counts = counters.Read();
+		for (size_t i = 0; i < NUM_COUNTERS; i++)
+		{
+			if (counts[i])
+				result.counters[i] = result.counters[i].value_or(0) + *counts[i];
+		}
+	}
+
+	const auto totalUpdates = static_cast<double>(result.updatesPerSample * options.samples);
+	for (auto &counter : result.counters)
+	{
+		if (counter)
+			*counter /= totalUpdates;
+	}
+
+	const auto numSamples = static_cast<double>(result.samples.size());
+	result.mean = std::accumulate(result.samples.cbegin(), result.samples.cend(), 0.0) / numSamples;
+
+	double sumSquares = 0;
+	for (const auto sample : result.samples)
+		sumSquares += (sample - result.mean) * (sample - result.mean);
+	result.standardDeviation = result.samples.size() > 1 ? std::sqrt(sumSquares / (numSamples - 1)) : 0;
+
+	const double margin = StudentT95(result.samples.size() - 1) * result.standardDeviation / std::sqrt(numSamples);
+	result.confidenceLow = result.mean - margin;
+	result.confidenceHigh = result.mean + margin;
+
+	auto sorted = result.samples;
+	std::sort(sorted.begin(), sorted.end());
+	const auto middle = sorted.size() / 2;
+	result.median = sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+
+	return result;
+}
+
+void Report(const UpdateResult &result)
+{
+	constexpr double SECONDS_TO_MICROS = 1e6;
+	std::printf("%-28s %10zu %-4s %12.2f us +/- %-9.2f %10.1f M bodies/s %8.2f GB/s\n",
+	            ("Update " + result.implementation + ":").c_str(), result.numBodies, result.regime.c_str(),
+	            result.mean * SECONDS_TO_MICROS,
+	            (result.confidenceHigh - result.mean) * SECONDS_TO_MICROS, result.BodiesPerSecond() / 1e6,
+	            result.GigabytesPerSecond());
+
+	// Normalized per body so sizes can be compared, with the ratios that are most telling about the difference
+	// between layouts
+	const auto perBody = [&result](const Counter counter) {
+		const auto &value = result.counters[static_cast<size_t>(counter)];
+		return value ? *value / static_cast<double>(result.numBodies) : std::nan("");
+	};
+	if (GetCounters().IsAvailable())
+	{
+		std::printf("%-28s %10s %-4s %8.2f cycles %6.2f IPC %8.4f L1d %8.4f LLC %8.4f dTLB %8.4f branch misses / body\n",
+		            "", "", "", perBody(Counter::Cycles), perBody(Counter::Instructions) / perBody(Counter::Cycles),
+		            perBody(Counter::L1dMisses), perBody(Counter::LlcMisses), perBody(Counter::DtlbMisses),
+		            perBody(Counter::BranchMisses));
+	}
+	std::fflush(stdout);
+
+	results.push_back(result);
+}
+
+bool WriteResults()
+{
+	const auto &options = GetHarnessOptions();
+	if (options.jsonPath.empty())
+		return true;
+
+	std::ofstream file(options.jsonPath);
+	if (!file)
+		return false;
+
+	file.precision(9);
+	file << "{\n";
+	file << "  \"host\": {\n";
+	file << "    \"name\": " << Quote(HostName()) << ",\n";
+	file << "    \"cpu\": " << Quote(kinematics::GetCpuModel()) << ",\n";
+	file << "    \"compiler\": " << Quote(COMPILER) << ",\n";
+	file << "    \"threads\": " << omp_get_max_threads() << ",\n";
+	// The binding in effect, which may differ from the environment if the runtime couldn't apply it
+	file << "    \"ompProcBind\": " << Quote(ProcBindName()) << ",\n";
+	file << "    \"ompNumPlaces\": " << omp_get_num_places() << ",\n";
+	file << "    \"ompThreadPlaces\": [";
+	const auto places = ThreadPlaces();
+	for (size_t thread = 0; thread < places.size(); thread++)
+		file << (thread ? ", " : "") << places[thread];
+	file << "],\n";
+	file << "    \"counters\": " << (GetCounters().IsAvailable() ? "true" : "false") << ",\n";
+	const auto &caches = GetCacheSizes();
+	file << "    \"cacheBytes\": {\"l1d\": " << caches.l1d << ", \"l2\": " << caches.l2 << ", \"llc\": " << caches.llc
+	     << "}\n";
+	file << "  },\n";
+	file << "  \"options\": {\"samples\": " << options.samples << ", \"minSampleSeconds\": " << options.minSampleSeconds
+	     << "},\n";
+	file << "  \"results\": [";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const auto &result = results[i];
+		file << (i ? ",\n" : "\n");
+		file << "    {\"benchmark\": \"update\", \"implementation\": " << Quote(result.implementation)
+		     << ", \"numBodies\": " << result.numBodies << ", \"regime\": " << Quote(result.regime)
+		     << ", \"threads\": " << result.threads << ", \"bytesMovedPerBody\": " << result.bytesMovedPerBody
+		     << ", \"updatesPerSample\": " << result.updatesPerSample
+		     << ", \"meanSeconds\": " << result.mean << ", \"medianSeconds\": " << result.median
+		     << ", \"standardDeviationSeconds\": " << result.standardDeviation
+		     << ", \"confidenceLowSeconds\": " << result.confidenceLow
+		     << ", \"confidenceHighSeconds\": " << result.confidenceHigh
+		     << ", \"bodiesPerSecond\": " << result.BodiesPerSecond()
+		     << ", \"gigabytesPerSecond\": " << result.GigabytesPerSecond() << ", \"countersPerUpdate\": {";
+		for (size_t counter = 0; counter < NUM_COUNTERS; counter++)
+		{
+			file << (counter ? ", " : "") << Quote(PerfCounters::GetName(static_cast<Counter>(counter))) << ": "
+			     << JsonNumber(result.counters[counter]);
+		}
+		file << "}, \"samples\": [";
+		for (size_t sample = 0; sample < result.samples.size(); sample++)
+			file << (sample ? ", " : "") << result.samples[sample];
+		file << "]}";
+	}
+	file << "\n  ]\n}\n";
+
+	return static_cast<bool>(file);
+}
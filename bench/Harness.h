@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kinematics.h>
+
+#include "Counters.h"
+
+/// Settings for `MeasureUpdate`, which can be changed from the command line
+struct HarnessOptions
+{
+	size_t samples = 20;           // number of times to restore the snapshot and time updates
+	double minSampleSeconds = 0.01; // updates are repeated within a sample until it takes at least this long
+	std::string jsonPath;          // file to write every result to as JSON, if any
+	size_t maxBodies = 0;          // largest size of the cache sweep, or 0 for no limit
+};
+
+/// Time taken by `Update()` of a single implementation at a single size
+struct UpdateResult
+{
+	std::string implementation;
+	size_t numBodies;
+	std::string regime; // level of the memory hierarchy the bodies fit in, if known
+	int threads; // OpenMP threads available to `Update()`
+	size_t bytesMovedPerBody; // memory read plus written for each body by an update
+	size_t updatesPerSample;
+	std::vector<double> samples; // average seconds per update within each sample
+
+	// Seconds per update, with a 95% confidence interval for the mean
+	double mean, median, standardDeviation, confidenceLow, confidenceHigh;
+
+	CounterValues counters; // hardware events per update, over every sample, where available
+
+	/// @returns Bodies updated per second, based on the mean
+	double BodiesPerSecond() const;
+
+	/// @returns Rate at which bodies are read and written, based on the mean and `bytesMovedPerBody`
+	double GigabytesPerSecond() const;
+};
+
+/// Creates a simulation that starts with the same bodies as the given one
+using SimulationFactory = std::function<std::unique_ptr<kinematics::Simulation>(const kinematics::Simulation &)>;
+
+/// A CPU implementation for the benchmarks to compare
+struct Implementation
+{
+	std::string name;
+	SimulationFactory create;
+	size_t bytesPerBody;                                   // memory `Update()` streams through for each body
+	size_t maxBodies = std::numeric_limits<size_t>::max(); // largest number of bodies it can hold
+};
+
+/// @returns Every registered backend that runs on the CPU, for the benchmarks to compare
+const std::vector<Implementation> &GetImplementations();
+
+/// Options used by every measurement
+HarnessOptions &GetHarnessOptions();
+
+/// Bind OpenMP threads, including the main thread, to cores so results don't depend on where the OS moves them. Any
+/// placement already set through `OMP_PROC_BIND` or `OMP_PLACES` is kept. The runtime only reads them as it's loaded,
+/// so unless both are set this sets them and restarts the bench in place with the same arguments.
+/// Must be called at the start of `main()`, before anything uses OpenMP or lowers the number of OpenMP threads.
+/// @param argv Arguments of `main()`, to restart with
+void PinThreads(char *argv[]);
+
+/// Time `Update()` of the simulation created by `create`. Every sample starts from a fresh copy of `snapshot`, so
+/// each one times the same sequence of updates rather than whatever state previous samples left behind. Hardware
+/// events are counted alongside the time, where the system allows it.
+/// @param implementation Name to report the results under
+/// @param create Creates the simulation to measure, and isn't timed
+/// @param snapshot Initial state of each sample
+/// @param bytesPerBody Memory `Update()` streams through for each body, which it both reads and writes back
+UpdateResult MeasureUpdate(const std::string &implementation, const SimulationFactory &create,
+                           const kinematics::Simulation &snapshot, const size_t bytesPerBody);
+
+/// Print `result` and keep it to be written out by `WriteResults()`
+void Report(const UpdateResult &result);
+
+/// Write every reported result, along with a description of the host, as JSON to `GetHarnessOptions().jsonPath`
+/// @returns Whether the results were written, which is trivially true if no path was given
+bool WriteResults();
@@ -0,0 +1,26 @@
+#pragma once
+#include <raylib.h>
+
+/// Opens a hidden window, and with it an OpenGL context, for the lifetime of the object. This works without a GPU
+/// through a software rasterizer such as Mesa's llvmpipe, and without a display through a virtual one such as Xvfb.
+class HiddenWindow
+{
+  public:
+	HiddenWindow(const int width, const int height)
+	{
+		SetConfigFlags(FLAG_WINDOW_HIDDEN);
+		InitWindow(width, height, "kinematics-demo-bench");
+	}
+
+	~HiddenWindow()
+	{
+		if (IsWindowReady())
+			CloseWindow();
+	}
+
+	HiddenWindow(const HiddenWindow &) = delete;
+	HiddenWindow &operator=(const HiddenWindow &) = delete;
+
+	/// @returns Whether a window, and so an OpenGL context, could be created
+	bool IsReady() const { return IsWindowReady(); }
+};
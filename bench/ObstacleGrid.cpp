@@ -0,0 +1,176 @@
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+#include <Backends.h>
+#include <BounceEvents.h>
+#include <ObstacleGrid.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+// Large enough that every obstacle is in the one cell, so every body is tested against all of them
+constexpr float SINGLE_CELL = 1e6f;
+
+/// @returns `count` small boxes scattered across the bounds, like crates or pillars
+std::vector<Rectangle> Scattered(const int count)
+{
+	std::vector<Rectangle> obstacles;
+	for (int i = 0; i < count; i++)
+	{
+		const auto size = static_cast<float>(GetRandomValue(8, 32));
+		obstacles.push_back({static_cast<float>(GetRandomValue(0, static_cast<int>(WIDTH) - 32)),
+		                     static_cast<float>(GetRandomValue(0, static_cast<int>(HEIGHT) - 32)), size, size});
+	}
+	return obstacles;
+}
+
+/// @returns `count` thin walls, each either horizontal or vertical, like the corridors of a maze
+std::vector<Rectangle> Walls(const int count)
+{
+	std::vector<Rectangle> obstacles;
+	for (int i = 0; i < count; i++)
+	{
+		const auto length = static_cast<float>(GetRandomValue(40, 160));
+		const auto x = static_cast<float>(GetRandomValue(0, static_cast<int>(WIDTH) - 160));
+		const auto y = static_cast<float>(GetRandomValue(0, static_cast<int>(HEIGHT) - 160));
+		if (i % 2)
+			obstacles.push_back({x, y, length, 4});
+		else
+			obstacles.push_back({x, y, 4, length});
+	}
+	return obstacles;
+}
+} // namespace
+
+TEST_CASE("ObstacleGrid", "[obstacles]")
+{
+	SECTION("Bounce")
+	{
+		// Grown by `BODY_RADIUS` to span 90 to 160 on both axes
+		const kinematics::ObstacleGrid grid({{100, 100, 50, 50}});
+
+		// Moving in through the left side
+		float horizontalSpeed = 10, verticalSpeed = 10;
+		grid.Collide(95, 125, horizontalSpeed, verticalSpeed);
+		REQUIRE(horizontalSpeed == -10);
+		REQUIRE(verticalSpeed == 10);
+
+		// Already moving back out of the left side
+		grid.Collide(95, 125, horizontalSpeed, verticalSpeed);
+		REQUIRE(horizontalSpeed == -10);
+
+		// Moving in through the bottom side
+		grid.Collide(130, 158, horizontalSpeed, verticalSpeed = -10);
+		REQUIRE(horizontalSpeed == -10);
+		REQUIRE(verticalSpeed == 10);
+
+		// Outside the obstacle, and outside the grid entirely
+		grid.Collide(85, 125, horizontalSpeed = 10, verticalSpeed);
+		grid.Collide(500, 500, horizontalSpeed, verticalSpeed);
+		grid.Collide(-500, -500, horizontalSpeed, verticalSpeed);
+		REQUIRE(horizontalSpeed == 10);
+		REQUIRE(verticalSpeed == 10);
+	}
+
+	SECTION("Grid matches testing every obstacle")
+	{
+		for (const auto &obstacles : {Scattered(1'000), Walls(1'000)})
+		{
+			const kinematics::ObstacleGrid grid(obstacles), everything(obstacles, SINGLE_CELL);
+			REQUIRE(grid.GetObstacles().size() == obstacles.size());
+			REQUIRE(grid.GetNumEntries() >= obstacles.size());
+			REQUIRE(everything.GetNumEntries() == obstacles.size());
+
+			std::vector<float> x, y, horizontalSpeed, verticalSpeed;
+			for (int i = 0; i < 100'000; i++)
+			{
+				x.push_back(static_cast<float>(GetRandomValue(-100, static_cast<int>(WIDTH) + 100)) + 0.5f);
+				y.push_back(static_cast<float>(GetRandomValue(-100, static_cast<int>(HEIGHT) + 100)) + 0.5f);
+				horizontalSpeed.push_back(static_cast<float>(GetRandomValue(-100, 100)));
+				verticalSpeed.push_back(static_cast<float>(GetRandomValue(-100, 100)));
+			}
+
+			const auto originalHorizontalSpeed = horizontalSpeed, originalVerticalSpeed = verticalSpeed;
+			auto expectedHorizontalSpeed = horizontalSpeed, expectedVerticalSpeed = verticalSpeed;
+			everything.Collide(x.data(), y.data(), expectedHorizontalSpeed.data(), expectedVerticalSpeed.data(), 0,
+			                   x.size());
+			grid.Collide(x.data(), y.data(), horizontalSpeed.data(), verticalSpeed.data(), 0, x.size());
+
+			REQUIRE(horizontalSpeed == expectedHorizontalSpeed);
+			REQUIRE(verticalSpeed == expectedVerticalSpeed);
+			REQUIRE(horizontalSpeed != originalHorizontalSpeed); // some bodies did bounce
+			REQUIRE(verticalSpeed != originalVerticalSpeed);
+		}
+	}
+}
+
+TEST_CASE("Obstacles in every backend", "[obstacles]")
+{
+	const auto obstacles = Scattered(200);
+	const kinematics::ObstacleGrid grid(obstacles), everything(obstacles, SINGLE_CELL);
+
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 10'007);
+	ForEachCpuBackend(original.GetNumBodies(), [&](const kinematics::Backend &backend) {
+		auto simulation = backend.create(WIDTH, HEIGHT, original);
+		auto expected = backend.create(WIDTH, HEIGHT, original);
+		auto withoutObstacles = backend.create(WIDTH, HEIGHT, original);
+		simulation->SetObstacles(&grid);
+		expected->SetObstacles(&everything);
+
+		// Half of the steps also record bounces, which moves bodies with a separate loop
+		kinematics::BounceEvents events, expectedEvents;
+		for (int step = 0; step < 60; step++)
+		{
+			if (step == 30)
+			{
+				simulation->SetBounceEvents(&events);
+				expected->SetBounceEvents(&expectedEvents);
+			}
+			simulation->Update(TIME_STEP);
+			expected->Update(TIME_STEP);
+			withoutObstacles->Update(TIME_STEP);
+		}
+
+		const auto bodies = simulation->GetBodies();
+		const auto expectedBodies = expected->GetBodies();
+		const auto unobstructedBodies = withoutObstacles->GetBodies();
+		size_t numObstructed = 0;
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			REQUIRE(bodies[i].x == expectedBodies[i].x);
+			REQUIRE(bodies[i].y == expectedBodies[i].y);
+			REQUIRE(bodies[i].horizontalSpeed == expectedBodies[i].horizontalSpeed);
+			REQUIRE(bodies[i].verticalSpeed == expectedBodies[i].verticalSpeed);
+			numObstructed += bodies[i].x != unobstructedBodies[i].x || bodies[i].y != unobstructedBodies[i].y;
+		}
+		CHECK(numObstructed > 0);
+	});
+}
+
+TEST_CASE("Update with obstacles", "[obstacles]")
+{
+	constexpr size_t NUM_BODIES = 1'000'000;
+	constexpr int NUM_OBSTACLES = 1'000;
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, NUM_BODIES);
+
+	const kinematics::ObstacleGrid scattered(Scattered(NUM_OBSTACLES)), walls(Walls(NUM_OBSTACLES));
+	for (const auto *name : {"StructOfVectorSim", "OmpSimdSim", "OmpForSim"})
+	{
+		const auto *backend = kinematics::FindBackend(name);
+		auto simulation = backend->create(WIDTH, HEIGHT, original);
+
+		const auto suffix = std::string(name) + ": " + std::to_string(NUM_BODIES);
+		BENCHMARK("Update without obstacles " + suffix) { return simulation->Update(TIME_STEP); };
+
+		simulation->SetObstacles(&scattered);
+		BENCHMARK("Update with scattered obstacles " + suffix) { return simulation->Update(TIME_STEP); };
+
+		simulation->SetObstacles(&walls);
+		BENCHMARK("Update with walls " + suffix) { return simulation->Update(TIME_STEP); };
+	}
+}
@@ -0,0 +1,41 @@
+#include <catch2/catch_all.hpp>
+#include <raylib.h>
+#include <vector>
+
+#include <PointRenderer.h>
+#include <kinematics.h>
+
+#include "HiddenWindow.h"
+
+TEST_CASE("PointRenderer", "[render]")
+{
+	HiddenWindow window(800, 600);
+	if (!window.IsReady())
+		SKIP("No OpenGL context available");
+
+	kinematics::PointRenderer renderer;
+	RenderTexture2D target = LoadRenderTexture(800, 600);
+
+	const kinematics::BodyFrame frame{.x = {100, 700}, .y = {100, 500}, .color = {RED, BLUE}};
+	BeginTextureMode(target);
+	ClearBackground(BLACK);
+	renderer.Draw(frame);
+	EndTextureMode();
+
+	// Render textures are stored upside down
+	Image image = LoadImageFromTexture(target.texture);
+	ImageFlipVertical(&image);
+
+	// Each body should be a filled circle of `BODY_RADIUS` around its center, leaving everything else untouched
+	const auto pixel = [&image](const int x, const int y) { return GetImageColor(image, x, y); };
+	CHECK(pixel(100, 100).r == RED.r);
+	CHECK(pixel(100, 100).b == RED.b);
+	CHECK(pixel(100 + kinematics::BODY_RADIUS / 2, 100).r == RED.r);
+	CHECK(pixel(700, 500).b == BLUE.b);
+	CHECK(pixel(700, 500).r == BLUE.r);
+	CHECK(pixel(400, 300).r == 0);
+	CHECK(pixel(100 + kinematics::BODY_RADIUS + 2, 100).r == 0);
+
+	UnloadImage(image);
+	UnloadRenderTexture(target);
+}
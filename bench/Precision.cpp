@@ -0,0 +1,134 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <kinematics.h>
+
+#include "Caches.h"
+#include "Fixtures.h"
+#include "Harness.h"
+
+namespace
+{
+// Widest SIMD register the build targets, which holds half as many `double` as `float`
+#if defined(__AVX512F__)
+constexpr size_t REGISTER_BYTES = 64;
+#elif defined(__AVX__)
+constexpr size_t REGISTER_BYTES = 32;
+#else
+constexpr size_t REGISTER_BYTES = 16;
+#endif
+
+// Positions are stored as `double`, so only rounding them to `float` to read them back differs from exact steps
+constexpr float TOLERANCE = 1e-3f;
+
+/// Positions and speeds, in both directions
+template <typename Scalar> constexpr size_t BYTES_PER_BODY = 4 * sizeof(Scalar);
+
+template <typename Scalar> UpdateResult Measure(const std::string &name, const kinematics::Simulation &snapshot)
+{
+	const auto create = [](const kinematics::Simulation &toCopy) {
+		return std::make_unique<kinematics::PrecisionSim<Scalar>>(WIDTH, HEIGHT, toCopy);
+	};
+	auto result = MeasureUpdate(name, create, snapshot, BYTES_PER_BODY<Scalar>);
+	result.regime = GetRegimeName(GetRegime(result.numBodies * BYTES_PER_BODY<Scalar>));
+	Report(result);
+	return result;
+}
+} // namespace
+
+TEST_CASE("PrecisionSim", "[precision]")
+{
+	SECTION("`float` moves bodies exactly as StructOfVectorSim does")
+	{
+		const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 10'007);
+		kinematics::PrecisionSim<float> simulation(WIDTH, HEIGHT, original);
+		kinematics::StructOfVectorSim expected(WIDTH, HEIGHT, original);
+		for (int step = 0; step < 120; step++)
+		{
+			simulation.Update(TIME_STEP);
+			expected.Update(TIME_STEP);
+		}
+
+		RequireSameBodies(expected.GetBodies(), simulation.GetBodies());
+	}
+
+	SECTION("`double` moves and bounces bodies the same, apart from rounding")
+	{
+		const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 10'007);
+		kinematics::PrecisionSim<double> simulation(WIDTH, HEIGHT, original);
+		for (int step = 0; step < 120; step++)
+			RequireStepLikeSweep(simulation, TOLERANCE);
+	}
+
+	SECTION("`double` keeps long runs from drifting")
+	{
+		// Bounds large enough that few bodies reach a wall, and where `float` positions are only exact to a few
+		// hundredths of a unit
+		constexpr float SIZE = 1'000'000;
+		constexpr int NUM_STEPS = 6'000;
+		const kinematics::VectorOfStructSim original(SIZE, SIZE, 1'000);
+		kinematics::PrecisionSim<float> single(SIZE, SIZE, original);
+		kinematics::PrecisionSim<double> precise(SIZE, SIZE, original);
+		for (int step = 0; step < NUM_STEPS; step++)
+		{
+			single.Update(TIME_STEP);
+			precise.Update(TIME_STEP);
+		}
+
+		// Compared against where each body would be with exact arithmetic, for the bodies that didn't bounce
+		const auto start = original.GetBodies(), singleBodies = single.GetBodies(), preciseBodies = precise.GetBodies();
+		double singleError = 0, preciseError = 0;
+		for (size_t i = 0; i < start.size(); i++)
+		{
+			if (preciseBodies[i].horizontalSpeed != start[i].horizontalSpeed)
+				continue;
+			const auto exact = static_cast<double>(start[i].x) + NUM_STEPS * static_cast<double>(TIME_STEP) *
+			                                                         static_cast<double>(start[i].horizontalSpeed);
+			singleError = std::max(singleError, std::abs(static_cast<double>(singleBodies[i].x) - exact));
+			preciseError = std::max(preciseError, std::abs(static_cast<double>(preciseBodies[i].x) - exact));
+		}
+		INFO("Largest error of float: " << singleError << ", and of double: " << preciseError);
+		CHECK(singleError > 1);
+		CHECK(preciseError < 0.1); // only what rounding the result to `float` adds
+	}
+}
+
+TEST_CASE("Update by precision", "[precision]")
+{
+	// Sizes on either side of each cache level for `float`, at which `double` has twice the working set
+	std::printf("\nWidest SIMD register: %zu bytes, holding %zu float or %zu double\n", REGISTER_BYTES,
+	            REGISTER_BYTES / sizeof(float), REGISTER_BYTES / sizeof(double));
+
+	struct Row
+	{
+		size_t numBodies;
+		UpdateResult single, precise;
+	};
+	std::vector<Row> rows;
+	const auto maxBodies = GetHarnessOptions().maxBodies;
+	for (const auto &point : CacheSweep(4 * sizeof(float)))
+	{
+		if (maxBodies && point.numBodies > maxBodies)
+			continue;
+
+		const kinematics::VectorOfStructSim snapshot(WIDTH, HEIGHT, point.numBodies);
+		rows.push_back({point.numBodies, Measure<float>("PrecisionSim<float>", snapshot),
+		                Measure<double>("PrecisionSim<double>", snapshot)});
+	}
+
+	std::printf("\n%10s %6s %16s %10s %6s %17s %10s %10s\n", "Bodies", "Fits", "float M bodies/s", "GB/s", "Fits",
+	            "double M bodies/s", "GB/s", "Slowdown");
+	for (const auto &[numBodies, single, precise] : rows)
+	{
+		std::printf("%10zu %6s %16.1f %10.2f %6s %17.1f %10.2f %9.2fx\n", numBodies, single.regime.c_str(),
+		            single.BodiesPerSecond() / 1e6, single.GigabytesPerSecond(), precise.regime.c_str(),
+		            precise.BodiesPerSecond() / 1e6, precise.GigabytesPerSecond(), precise.mean / single.mean);
+	}
+	std::printf("\n");
+
+	REQUIRE(rows.size() > 0);
+}
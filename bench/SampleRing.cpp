@@ -0,0 +1,71 @@
+#include <catch2/catch_all.hpp>
+#include <thread>
+#include <vector>
+
+#include <SampleRing.h>
+
+TEST_CASE("SampleRing", "[ring]")
+{
+	kinematics::SampleRing<float, 4> ring;
+	std::vector<float> samples;
+	ring.Copy(samples);
+	REQUIRE(samples.empty());
+
+	ring.Push(1);
+	ring.Push(2);
+	ring.Copy(samples);
+	REQUIRE(samples == std::vector<float>{1, 2});
+
+	// Once full the oldest samples are replaced, and copies stay oldest first
+	for (float value = 3; value <= 6; value++)
+		ring.Push(value);
+	ring.Copy(samples);
+	REQUIRE(samples == std::vector<float>{3, 4, 5, 6});
+	REQUIRE(ring.GetCount() == 6);
+}
+
+TEST_CASE("SampleRing concurrent", "[ring]")
+{
+	constexpr size_t NUM_SAMPLES = 200'000;
+
+	// Each sample is its own count, so a copy must never see a slot that wasn't written yet or one older than what the
+	// ring retained when the copy started. Newer samples can appear where the writer lapped the reader mid-copy.
+	kinematics::SampleRing<size_t, 256> ring;
+	std::jthread writer([&ring] {
+		for (size_t sample = 1; sample <= NUM_SAMPLES; sample++)
+			ring.Push(sample);
+	});
+
+	std::vector<size_t> samples;
+	while (ring.GetCount() != NUM_SAMPLES)
+	{
+		const auto countBefore = ring.GetCount();
+		ring.Copy(samples);
+		for (const auto sample : samples)
+		{
+			REQUIRE(sample > 0);
+			REQUIRE(sample + ring.GetCapacity() > countBefore);
+		}
+	}
+
+	writer.join();
+	ring.Copy(samples);
+	REQUIRE(samples.back() == NUM_SAMPLES);
+	REQUIRE(samples.front() == NUM_SAMPLES - ring.GetCapacity() + 1);
+}
+
+TEST_CASE("SampleStats", "[ring]")
+{
+	std::vector<float> samples;
+	for (int value = 100; value >= 1; value--)
+		samples.push_back(static_cast<float>(value));
+
+	const auto stats = kinematics::SampleStats::Compute(samples);
+	CHECK(stats.p50 == 50);
+	CHECK(stats.p95 == 95);
+	CHECK(stats.p99 == 99);
+	CHECK(stats.max == 100);
+
+	std::vector<float> none;
+	CHECK(kinematics::SampleStats::Compute(none).max == 0);
+}
@@ -0,0 +1,142 @@
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <omp.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <kinematics.h>
+
+#include "Caches.h"
+#include "Harness.h"
+
+namespace
+{
+// Positions and speeds, as laid out by both `OmpForSim` and `StructOfVectorSim`
+constexpr size_t BYTES_PER_BODY = 4 * sizeof(float);
+
+/// Sets the number of OpenMP threads for as long as it's in scope
+class ScopedThreads
+{
+  public:
+	explicit ScopedThreads(const int threads) : _previous(omp_get_max_threads()) { omp_set_num_threads(threads); }
+	~ScopedThreads() { omp_set_num_threads(_previous); }
+
+	ScopedThreads(const ScopedThreads &) = delete;
+	ScopedThreads &operator=(const ScopedThreads &) = delete;
+
+  private:
+	int _previous;
+};
+
+/// @returns Every count from one up to the number of threads OpenMP would use by default, so a knee at a count that
+/// isn't a power of two, such as where threads start sharing cores or sockets, isn't skipped over.
+/// Respects `OMP_NUM_THREADS`, such as to match the CPU limit of a container.
+std::vector<int> ThreadCounts()
+{
+	std::vector<int> counts(static_cast<size_t>(omp_get_max_threads()));
+	std::iota(counts.begin(), counts.end(), 1);
+	return counts;
+}
+
+std::unique_ptr<kinematics::Simulation> CreateParallel(const kinematics::Simulation &toCopy)
+{
+	return std::make_unique<kinematics::OmpForSim>(800, 600, toCopy);
+}
+
+/// Same layout and loop as `OmpForSim`, without the threads
+std::unique_ptr<kinematics::Simulation> CreateSerial(const kinematics::Simulation &toCopy)
+{
+	return std::make_unique<kinematics::StructOfVectorSim>(800, 600, toCopy);
+}
+
+UpdateResult Measure(const std::string &implementation, const SimulationFactory &create,
+                     const kinematics::Simulation &snapshot)
+{
+	auto result = MeasureUpdate(implementation, create, snapshot, BYTES_PER_BODY);
+	result.regime = GetRegimeName(GetRegime(result.numBodies * BYTES_PER_BODY));
+	Report(result);
+	return result;
+}
+
+UpdateResult MeasureWithThreads(const int threads, const kinematics::Simulation &snapshot)
+{
+	ScopedThreads scope(threads);
+	return Measure("OmpForSim (" + std::to_string(threads) + " threads)", CreateParallel, snapshot);
+}
+} // namespace
+
+TEST_CASE("Strong scaling", "[scaling]")
+{
+	// The same amount of work split over more threads, ideally taking `1 / threads` as long
+	auto size = static_cast<size_t>(GENERATE(100'000, 1'000'000, 5'000'000));
+	const kinematics::VectorOfStructSim snapshot(800, 600, size);
+
+	std::vector<UpdateResult> results;
+	for (const auto threads : ThreadCounts())
+		results.push_back(MeasureWithThreads(threads, snapshot));
+
+	std::printf("\nStrong scaling of OmpForSim with %zu bodies\n", size);
+	std::printf("%8s %10s %10s %14s\n", "Threads", "Speedup", "Efficiency", "GB/s / thread");
+	for (const auto &result : results)
+	{
+		const double speedup = results.front().mean / result.mean;
+		std::printf("%8d %9.2fx %9.0f%% %14.2f\n", result.threads, speedup, 100 * speedup / result.threads,
+		            result.GigabytesPerSecond() / result.threads);
+	}
+	std::printf("\n");
+
+	REQUIRE(results.size() == ThreadCounts().size());
+}
+
+TEST_CASE("Weak scaling", "[scaling]")
+{
+	// Work grows with the threads, ideally taking the same time at every count
+	auto bodiesPerThread = static_cast<size_t>(GENERATE(100'000, 1'000'000));
+
+	std::vector<UpdateResult> results;
+	for (const auto threads : ThreadCounts())
+	{
+		const kinematics::VectorOfStructSim snapshot(800, 600, bodiesPerThread * static_cast<size_t>(threads));
+		results.push_back(MeasureWithThreads(threads, snapshot));
+	}
+
+	std::printf("\nWeak scaling of OmpForSim with %zu bodies per thread\n", bodiesPerThread);
+	std::printf("%8s %10s %10s %14s\n", "Threads", "Bodies", "Efficiency", "GB/s / thread");
+	for (const auto &result : results)
+	{
+		std::printf("%8d %10zu %9.0f%% %14.2f\n", result.threads, result.numBodies,
+		            100 * results.front().mean / result.mean, result.GigabytesPerSecond() / result.threads);
+	}
+	std::printf("\n");
+
+	REQUIRE(results.size() == ThreadCounts().size());
+}
+
+TEST_CASE("Serial crossover", "[scaling]")
+{
+	// Starting and joining threads has a fixed cost, so below some size a single thread wins
+	std::optional<size_t> crossover;
+	for (size_t size = 1'000; size <= 1'024'000; size *= 2)
+	{
+		const kinematics::VectorOfStructSim snapshot(800, 600, size);
+
+		const auto serial = Measure("StructOfVectorSim", CreateSerial, snapshot);
+		const auto parallel = Measure("OmpForSim", CreateParallel, snapshot);
+
+		// Only count it as a crossover once it's clear the parallel version wins, and keep winning at larger sizes
+		if (parallel.confidenceHigh < serial.confidenceLow)
+			crossover = crossover.value_or(size);
+		else
+			crossover.reset();
+	}
+
+	if (crossover)
+		std::printf("\nOmpForSim with %d threads is faster from %zu bodies\n\n", omp_get_max_threads(), *crossover);
+	else
+		std::printf("\nOmpForSim with %d threads wasn't faster at any size\n\n", omp_get_max_threads());
+
+	SUCCEED();
+}
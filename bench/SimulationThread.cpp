@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <Backends.h>
+#include <SimulationThread.h>
+#include <kinematics.h>
+
+namespace
+{
+/// Poll the frames `simulation` publishes until one satisfies `isReady`, rather than guess how long the thread takes
+/// @returns Whether one did before a generous timeout, for a loaded machine
+template <typename Predicate> bool WaitForFrame(kinematics::SimulationThread &simulation, Predicate isReady)
+{
+	const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (!isReady(simulation.AcquireFrame()))
+	{
+		if (std::chrono::steady_clock::now() > timeout)
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+} // namespace
+
+TEST_CASE("SimulationThread", "[thread]")
+{
+	constexpr float TIME_STEP = 1.f / 120.f;
+
+	kinematics::SimulationThread simulation(std::make_unique<kinematics::StructOfVectorSim>(800, 600, 1'000), TIME_STEP);
+	REQUIRE(WaitForFrame(simulation, [](const kinematics::SteppedFrame &published) { return published.step > 0; }));
+
+	kinematics::BodyFrame frame;
+	const auto &stepped = simulation.Interpolate(frame, std::chrono::steady_clock::now());
+	REQUIRE(stepped.step > 0);
+	REQUIRE(stepped.current.x.size() == 1'000);
+	REQUIRE(stepped.previous.x.size() == 1'000);
+	REQUIRE(frame.x.size() == 1'000);
+
+	// Interpolated positions must lie between the two most recent steps
+	for (size_t i = 0; i < frame.x.size(); i++)
+	{
+		REQUIRE(frame.x[i] >= std::min(stepped.previous.x[i], stepped.current.x[i]));
+		REQUIRE(frame.x[i] <= std::max(stepped.previous.x[i], stepped.current.x[i]));
+	}
+
+	// Requests are applied between steps, even while paused. Pausing takes effect at once, so no step follows the change.
+	simulation.SetPaused(true);
+	simulation.SetNumBodies(10);
+	const auto hasTenBodies = [](const kinematics::SteppedFrame &published) { return published.current.x.size() == 10; };
+	REQUIRE(WaitForFrame(simulation, hasTenBodies));
+	const auto pausedStep = simulation.AcquireFrame().step;
+
+	// Swapping backends carries the bodies over exactly, so the paused frame looks the same from the new backend
+	const auto before = simulation.AcquireFrame().current;
+	const auto *backend = kinematics::FindBackend("VectorOfStructSim");
+	simulation.SetBackend(backend->name, backend->create);
+	const auto isSwapped = [](const kinematics::SteppedFrame &published) {
+		return published.backend == "VectorOfStructSim";
+	};
+	REQUIRE(WaitForFrame(simulation, isSwapped));
+
+	// No steps were taken while paused, however long the swap took to be applied
+	const auto &swapped = simulation.AcquireFrame();
+	REQUIRE(swapped.step == pausedStep);
+	REQUIRE(swapped.swapMilliseconds >= 0);
+	REQUIRE(swapped.current.x == before.x);
+	REQUIRE(swapped.current.y == before.y);
+
+	// A backend with a fixed capacity keeps as many bodies as it can hold when asked for more
+	const auto *fixed = kinematics::FindBackend("StructOfArraySim");
+	simulation.SetBackend(fixed->name, fixed->create);
+	simulation.SetNumBodies(fixed->maxBodies + 1);
+	const auto isFull = [fixed](const kinematics::SteppedFrame &published) {
+		return published.backend == fixed->name && published.current.x.size() == fixed->maxBodies;
+	};
+	REQUIRE(WaitForFrame(simulation, isFull));
+}
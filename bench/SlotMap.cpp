@@ -0,0 +1,217 @@
+#include <catch2/catch_all.hpp>
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+#include <SlotMap.h>
+#include <SlotMapSim.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+/// Require that `handles` are exactly the handles in `map`, each at the index `map` gives for it
+void RequireConsistent(const kinematics::SlotMap &map, const std::vector<kinematics::BodyHandle> &handles)
+{
+	REQUIRE(map.GetSize() == handles.size());
+	for (const auto handle : handles)
+	{
+		REQUIRE(map.Contains(handle));
+		REQUIRE(map.GetHandle(map.GetIndex(handle)) == handle);
+	}
+}
+
+/// @returns Index of a random body of `simulation`, which must have at least one
+size_t GetRandomIndex(const kinematics::Simulation &simulation)
+{
+	return static_cast<size_t>(GetRandomValue(0, static_cast<int>(simulation.GetNumBodies()) - 1));
+}
+
+void RequireSameBody(const kinematics::Body &body, const kinematics::Body &expected)
+{
+	REQUIRE(body.x == expected.x);
+	REQUIRE(body.y == expected.y);
+	REQUIRE(body.horizontalSpeed == expected.horizontalSpeed);
+	REQUIRE(body.verticalSpeed == expected.verticalSpeed);
+}
+} // namespace
+
+TEST_CASE("SlotMap", "[slot-map]")
+{
+	kinematics::SlotMap map;
+	std::vector<kinematics::BodyHandle> handles;
+	for (int i = 0; i < 10; i++)
+		handles.push_back(map.Add());
+	RequireConsistent(map, handles);
+
+	SECTION("Removing moves the last element into the removed one's index")
+	{
+		REQUIRE(map.Remove(handles[3]) == 3);
+		REQUIRE(map.GetIndex(handles[9]) == 3);
+		REQUIRE(!map.Contains(handles[3]));
+
+		handles.erase(handles.begin() + 3);
+		RequireConsistent(map, handles);
+
+		// Removing the last element moves nothing
+		const auto last = map.GetHandle(map.GetSize() - 1);
+		REQUIRE(map.Remove(last) == 8);
+		std::erase(handles, last);
+		RequireConsistent(map, handles);
+	}
+
+	SECTION("Handles of removed elements stay stale once their slot is reused")
+	{
+		const auto removed = handles[5];
+		map.Remove(removed);
+		const auto added = map.Add();
+		REQUIRE(added.slot == removed.slot);
+		REQUIRE(added != removed);
+		REQUIRE(map.Contains(added));
+		REQUIRE(!map.Contains(removed));
+	}
+
+	SECTION("Handles that were never given out aren't contained")
+	{
+		REQUIRE(!map.Contains({10, 0}));
+		REQUIRE(!map.Contains({0, 1}));
+	}
+
+	SECTION("Resizing adds or removes elements at the end")
+	{
+		map.Resize(4);
+		for (size_t i = 0; i < handles.size(); i++)
+			REQUIRE(map.Contains(handles[i]) == (i < 4));
+
+		map.Resize(12);
+		REQUIRE(map.GetSize() == 12);
+		for (size_t i = 0; i < 4; i++)
+			REQUIRE(map.GetIndex(handles[i]) == i);
+	}
+
+	SECTION("Many adds and removes in any order")
+	{
+		SetRandomSeed(49);
+		for (int i = 0; i < 10'000; i++)
+		{
+			if (handles.empty() || GetRandomValue(0, 2) == 0)
+			{
+				handles.push_back(map.Add());
+			}
+			else
+			{
+				const auto remove = static_cast<size_t>(GetRandomValue(0, static_cast<int>(handles.size()) - 1));
+				const auto handle = handles[remove];
+				map.Remove(handle);
+				REQUIRE(!map.Contains(handle));
+				handles[remove] = handles.back();
+				handles.pop_back();
+			}
+		}
+		RequireConsistent(map, handles);
+	}
+}
+
+TEST_CASE("SlotMapSim", "[slot-map]")
+{
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 1'009);
+	kinematics::SlotMapSim simulation(WIDTH, HEIGHT, original);
+
+	// Every body with the handle it started with, for following them through removals
+	const auto start = original.GetBodies();
+	std::vector<kinematics::BodyHandle> handles;
+	for (size_t i = 0; i < start.size(); i++)
+		handles.push_back(simulation.GetHandle(i));
+
+	SECTION("Removing a body keeps every other body, which its handle still finds")
+	{
+		SetRandomSeed(49);
+		std::vector<bool> isRemoved(start.size());
+		for (int i = 0; i < 500; i++)
+		{
+			const auto handle = simulation.GetHandle(GetRandomIndex(simulation));
+			isRemoved[handle.slot] = true; // slots aren't reused without adding
+			REQUIRE(simulation.RemoveBody(handle));
+			REQUIRE(!simulation.RemoveBody(handle));
+		}
+		REQUIRE(simulation.GetNumBodies() == start.size() - 500);
+
+		for (size_t i = 0; i < start.size(); i++)
+		{
+			REQUIRE(simulation.Contains(handles[i]) == !isRemoved[i]);
+			if (!isRemoved[i])
+				RequireSameBody(simulation.GetBody(handles[i]), start[i]);
+		}
+	}
+
+	SECTION("Bodies move as in StructOfVectorSim between removals and adds")
+	{
+		SetRandomSeed(49);
+		for (int step = 0; step < 120; step++)
+		{
+			for (int i = 0; i < 10; i++)
+				simulation.RemoveBody(simulation.GetHandle(GetRandomIndex(simulation)));
+			for (int i = 0; i < 5; i++)
+				simulation.AddBody({WIDTH / 2, HEIGHT / 2, static_cast<float>(i), -static_cast<float>(i), RED});
+
+			kinematics::StructOfVectorSim expected(WIDTH, HEIGHT, simulation);
+			simulation.Update(TIME_STEP);
+			expected.Update(TIME_STEP);
+
+			RequireSameBodies(expected.GetBodies(), simulation.GetBodies());
+		}
+		REQUIRE(simulation.GetNumBodies() == start.size() - 600);
+	}
+
+	SECTION("Changing the number of bodies makes handles of the removed ones stale")
+	{
+		simulation.SetNumBodies(500);
+		for (size_t i = 0; i < start.size(); i++)
+			REQUIRE(simulation.Contains(handles[i]) == (i < 500));
+
+		simulation.SetNumBodies(2'000);
+		REQUIRE(simulation.GetNumBodies() == 2'000);
+		REQUIRE(!simulation.Contains(handles[500]));
+		REQUIRE(simulation.GetIndex(simulation.GetHandle(1'999)) == 1'999);
+	}
+}
+
+TEST_CASE("Update with removals", "[slot-map]")
+{
+	constexpr size_t NUM_BODIES = 1'000'000;
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, NUM_BODIES);
+	const auto suffix = ": " + std::to_string(NUM_BODIES);
+
+	kinematics::StructOfVectorSim dense(WIDTH, HEIGHT, original);
+	BENCHMARK("Update StructOfVectorSim" + suffix) { return dense.Update(TIME_STEP); };
+
+	// The loop is the same, so this shows that handles cost nothing while bodies aren't being removed
+	kinematics::SlotMapSim simulation(WIDTH, HEIGHT, original);
+	BENCHMARK("Update SlotMapSim" + suffix) { return simulation.Update(TIME_STEP); };
+
+	// Replacing a hundredth of the bodies each step, which leaves the arrays dense for the update
+	constexpr int NUM_REPLACED = 10'000;
+	SetRandomSeed(49);
+	BENCHMARK("Replace " + std::to_string(NUM_REPLACED) + " bodies and update SlotMapSim" + suffix)
+	{
+		for (int i = 0; i < NUM_REPLACED; i++)
+		{
+			const auto body = simulation.GetBody(simulation.GetHandle(GetRandomIndex(simulation)));
+			simulation.RemoveBody(simulation.GetHandle(GetRandomIndex(simulation)));
+			simulation.AddBody(body);
+		}
+		return simulation.Update(TIME_STEP);
+	};
+
+	std::vector<kinematics::BodyHandle> handles;
+	for (size_t i = 0; i < NUM_BODIES; i += 97)
+		handles.push_back(simulation.GetHandle(i));
+	BENCHMARK("Look up " + std::to_string(handles.size()) + " handles SlotMapSim" + suffix)
+	{
+		float sum = 0;
+		for (const auto handle : handles)
+			sum += simulation.GetBody(handle).x;
+		return sum;
+	};
+}
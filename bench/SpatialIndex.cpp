@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <limits>
+#include <raylib.h>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <Backends.h>
+#include <SpatialIndex.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+namespace
+{
+/// @returns `results`, sorted so queries can be compared regardless of the order bodies are found in
+std::vector<uint32_t> Sorted(std::span<const uint32_t> results)
+{
+	std::vector<uint32_t> sorted(results.begin(), results.end());
+	std::ranges::sort(sorted);
+	return sorted;
+}
+
+/// @returns Indices of every body of `bodies` inside `area`, found by testing every one of them
+std::vector<uint32_t> ScanRectangle(const std::vector<kinematics::Body> &bodies, const Rectangle &area)
+{
+	std::vector<uint32_t> found;
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		if (bodies[i].x >= area.x && bodies[i].x <= area.x + area.width && bodies[i].y >= area.y &&
+		    bodies[i].y <= area.y + area.height)
+			found.push_back(static_cast<uint32_t>(i));
+	}
+	return found;
+}
+
+float GetDistanceSquared(const kinematics::Body &body, const Vector2 point)
+{
+	const auto dx = body.x - point.x, dy = body.y - point.y;
+	return dx * dx + dy * dy;
+}
+
+/// @returns Random points across the bounds and a little outside of them
+std::vector<Vector2> RandomPoints(const int count)
+{
+	std::vector<Vector2> points;
+	for (int i = 0; i < count; i++)
+	{
+		points.push_back({static_cast<float>(GetRandomValue(-50, static_cast<int>(WIDTH) + 50)),
+		                  static_cast<float>(GetRandomValue(-50, static_cast<int>(HEIGHT) + 50))});
+	}
+	return points;
+}
+} // namespace
+
+TEST_CASE("SpatialIndex", "[spatial]")
+{
+	kinematics::StructOfVectorSim simulation(WIDTH, HEIGHT, 100'003);
+	simulation.Update(TIME_STEP); // some bodies end up slightly outside the bounds
+	const auto bodies = simulation.GetBodies();
+	kinematics::SpatialIndex index;
+	index.Build(std::span(bodies), WIDTH, HEIGHT);
+	REQUIRE(index.GetNumBodies() == bodies.size());
+
+	std::vector<uint32_t> results(bodies.size());
+	const auto points = RandomPoints(200);
+
+	SECTION("Rectangles and radii match testing every body")
+	{
+		for (const auto &point : points)
+		{
+			const Rectangle area{point.x - 40, point.y - 25, 80, 50};
+			REQUIRE(Sorted(index.QueryRectangle(area, results)) == ScanRectangle(bodies, area));
+
+			constexpr float RADIUS = 30;
+			std::vector<uint32_t> expected;
+			for (size_t i = 0; i < bodies.size(); i++)
+			{
+				if (GetDistanceSquared(bodies[i], point) <= RADIUS * RADIUS)
+					expected.push_back(static_cast<uint32_t>(i));
+			}
+			REQUIRE(Sorted(index.QueryRadius(point, RADIUS, results)) == expected);
+		}
+
+		// Everything, including bodies outside the bounds
+		REQUIRE(index.QueryRectangle({-100, -100, WIDTH + 200, HEIGHT + 200}, results).size() == bodies.size());
+		REQUIRE(index.QueryRectangle({10, 10, -1, 5}, results).empty());
+	}
+
+	SECTION("Queries stop once the results are full")
+	{
+		std::vector<uint32_t> few(10);
+		const auto found = index.QueryRectangle({0, 0, WIDTH, HEIGHT}, few);
+		REQUIRE(found.size() == few.size());
+		for (const auto body : found)
+			REQUIRE(bodies[body].x >= 0);
+	}
+
+	SECTION("Nearest bodies match sorting every body by distance")
+	{
+		std::vector<uint32_t> byDistance(bodies.size());
+		for (const auto &point : points)
+		{
+			for (const size_t k : {1uz, 16uz, 100uz})
+			{
+				const auto found = index.FindNearest(point, std::span(results).first(k));
+				REQUIRE(found.size() == k);
+
+				for (uint32_t i = 0; i < byDistance.size(); i++)
+					byDistance[i] = i;
+				std::ranges::nth_element(byDistance, byDistance.begin() + static_cast<ptrdiff_t>(k - 1), {},
+				                         [&](const uint32_t i) { return GetDistanceSquared(bodies[i], point); });
+
+				// Compared by distance, as bodies the same distance away could be found in either order
+				const auto furthest = GetDistanceSquared(bodies[byDistance[k - 1]], point);
+				for (size_t i = 0; i < k; i++)
+				{
+					REQUIRE(GetDistanceSquared(bodies[found[i]], point) <= furthest);
+					if (i > 0)
+						REQUIRE(GetDistanceSquared(bodies[found[i - 1]], point) <=
+						        GetDistanceSquared(bodies[found[i]], point));
+				}
+			}
+		}
+
+		// Asking for more than there are finds every body
+		kinematics::SpatialIndex small;
+		small.Build(std::span(bodies).first(5), WIDTH, HEIGHT);
+		REQUIRE(Sorted(small.FindNearest({0, 0}, results)) == std::vector<uint32_t>{0, 1, 2, 3, 4});
+	}
+
+	SECTION("Batches match single queries")
+	{
+		constexpr size_t SHARE = 64;
+		std::vector<Rectangle> areas;
+		for (const auto &point : points)
+			areas.push_back({point.x, point.y, 50, 50});
+		std::vector<uint32_t> batchResults(points.size() * SHARE);
+		std::vector<std::span<const uint32_t>> found(points.size());
+		std::vector<uint32_t> single(SHARE);
+
+		index.QueryRectangles(areas, batchResults, found);
+		for (size_t i = 0; i < areas.size(); i++)
+			REQUIRE(Sorted(found[i]) == Sorted(index.QueryRectangle(areas[i], single)));
+
+		index.QueryRadii(points, 20, batchResults, found);
+		for (size_t i = 0; i < points.size(); i++)
+			REQUIRE(Sorted(found[i]) == Sorted(index.QueryRadius(points[i], 20, single)));
+
+		index.FindNearest(points, batchResults, found);
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			REQUIRE(found[i].size() == SHARE);
+			REQUIRE(Sorted(found[i]) == Sorted(index.FindNearest(points[i], single)));
+		}
+	}
+
+	SECTION("Positions far outside the bounds are kept in the nearest cell")
+	{
+		constexpr float FAR = 1e20f;
+		const std::vector<kinematics::Body> farBodies = {{-FAR, -FAR, 0, 0, RED}, {FAR, HEIGHT / 2, 0, 0, RED},
+		                                                 {WIDTH / 2, std::numeric_limits<float>::infinity(), 0, 0, RED}};
+		kinematics::SpatialIndex far;
+		far.Build(std::span(farBodies), WIDTH, HEIGHT);
+		REQUIRE(Sorted(far.QueryRectangle({-2 * FAR, -2 * FAR, 4 * FAR, 4 * FAR}, results)) ==
+		        std::vector<uint32_t>{0, 1});
+		REQUIRE(far.QueryRectangle({0, 0, WIDTH, HEIGHT}, results).empty());
+		REQUIRE(Sorted(far.QueryRadius({-FAR, -FAR}, 1, results)) == std::vector<uint32_t>{0});
+		REQUIRE(far.FindNearest({-FAR, -FAR}, std::span(results).first(1)).front() == 0);
+	}
+
+	SECTION("Nothing to find")
+	{
+		kinematics::SpatialIndex empty;
+		REQUIRE(empty.QueryRectangle({0, 0, WIDTH, HEIGHT}, results).empty());
+		REQUIRE(empty.FindNearest({0, 0}, results).empty());
+		empty.Build(nullptr, nullptr, 0, WIDTH, HEIGHT);
+		REQUIRE(empty.QueryRadius({0, 0}, 1'000, results).empty());
+		REQUIRE(empty.FindNearest({0, 0}, results).empty());
+	}
+}
+
+TEST_CASE("Spatial index in every backend", "[spatial]")
+{
+	const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 10'007);
+	const Rectangle area{WIDTH / 4, HEIGHT / 4, WIDTH / 2, HEIGHT / 2};
+	std::vector<uint32_t> results(original.GetNumBodies());
+
+	ForEachCpuBackend(original.GetNumBodies(), [&](const kinematics::Backend &backend) {
+		auto simulation = backend.create(WIDTH, HEIGHT, original);
+		kinematics::SpatialIndex index;
+		simulation->SetSpatialIndex(&index);
+		REQUIRE(Sorted(index.QueryRectangle(area, results)) == ScanRectangle(simulation->GetBodies(), area));
+
+		for (int step = 0; step < 30; step++)
+			simulation->Update(TIME_STEP);
+		REQUIRE(Sorted(index.QueryRectangle(area, results)) == ScanRectangle(simulation->GetBodies(), area));
+
+		// Bodies added or removed between steps are in the index straight away, so it never answers with indices of
+		// bodies that are gone
+		simulation->SetNumBodies(original.GetNumBodies() / 2);
+		REQUIRE(Sorted(index.QueryRectangle(area, results)) == ScanRectangle(simulation->GetBodies(), area));
+		simulation->AddBodies(original.GetBodies());
+		REQUIRE(Sorted(index.QueryRectangle(area, results)) == ScanRectangle(simulation->GetBodies(), area));
+
+		// Unsubscribed, the index keeps answering for the last step it saw
+		const auto before = Sorted(index.QueryRectangle(area, results));
+		simulation->SetSpatialIndex(nullptr);
+		simulation->Update(TIME_STEP);
+		REQUIRE(Sorted(index.QueryRectangle(area, results)) == before);
+	});
+}
+
+TEST_CASE("Spatial queries", "[spatial]")
+{
+	constexpr size_t NUM_BODIES = 1'000'000;
+	constexpr size_t NUM_QUERIES = 1'000;
+	kinematics::StructOfVectorSim simulation(WIDTH, HEIGHT, NUM_BODIES);
+	kinematics::BodyFrame frame;
+	simulation.CopyFrame(frame);
+
+	kinematics::SpatialIndex index;
+	BENCHMARK("Build: " + std::to_string(NUM_BODIES))
+	{
+		return index.Build(frame.x.data(), frame.y.data(), NUM_BODIES, WIDTH, HEIGHT);
+	};
+
+	simulation.SetSpatialIndex(&index);
+	BENCHMARK("Update with spatial index: " + std::to_string(NUM_BODIES)) { return simulation.Update(TIME_STEP); };
+	simulation.SetSpatialIndex(nullptr);
+
+	const auto points = RandomPoints(static_cast<int>(NUM_QUERIES));
+	std::vector<uint32_t> results(NUM_BODIES);
+	BENCHMARK("Rectangle of 40 by 40: " + std::to_string(NUM_BODIES))
+	{
+		return index.QueryRectangle({WIDTH / 2, HEIGHT / 2, 40, 40}, results);
+	};
+	BENCHMARK("Radius of 20: " + std::to_string(NUM_BODIES))
+	{
+		return index.QueryRadius({WIDTH / 2, HEIGHT / 2}, 20, results);
+	};
+	for (const size_t k : {1uz, 16uz})
+	{
+		BENCHMARK("Nearest " + std::to_string(k) + ": " + std::to_string(NUM_BODIES))
+		{
+			return index.FindNearest({WIDTH / 2, HEIGHT / 2}, std::span(results).first(k));
+		};
+	}
+
+	std::vector<std::span<const uint32_t>> found(NUM_QUERIES);
+	BENCHMARK("Batch of " + std::to_string(NUM_QUERIES) + " radii of 20: " + std::to_string(NUM_BODIES))
+	{
+		return index.QueryRadii(points, 20, results, found);
+	};
+	BENCHMARK("Batch of " + std::to_string(NUM_QUERIES) + " nearest 16: " + std::to_string(NUM_BODIES))
+	{
+		return index.FindNearest(points, std::span(results).first(16 * NUM_QUERIES), found);
+	};
+}
@@ -0,0 +1,191 @@
+#include <arpa/inet.h>
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <netinet/in.h>
+#include <raylib.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <FrameStream.h>
+#include <kinematics.h>
+
+TEST_CASE("Stream", "[stream]")
+{
+	const auto address = GENERATE(kinematics::StreamAddress::Tcp("127.0.0.1", 0),
+	                              kinematics::StreamAddress::Unix("kinematics-demo-test-" + std::to_string(getpid())));
+	constexpr int VIEW_LEFT = 100, VIEW_TOP = 100, VIEW_RIGHT = 400, VIEW_BOTTOM = 300;
+	const Rectangle viewport{.x = VIEW_LEFT, .y = VIEW_TOP, .width = VIEW_RIGHT - VIEW_LEFT, .height = VIEW_BOTTOM - VIEW_TOP};
+
+	auto simulation = std::make_unique<kinematics::VectorOfStructSim>(800, 600, 10'000);
+	kinematics::FrameServer server(address, 30);
+	kinematics::FrameClient client(
+		address.kind == kinematics::StreamAddress::Kind::Tcp ? kinematics::StreamAddress::Tcp("127.0.0.1", server.GetPort())
+		                                                     : address,
+		viewport);
+
+	for (int i = 0; i < 1000 && server.GetNumSubscribers() == 0; i++)
+	{
+		server.Poll();
+		usleep(1000);
+	}
+	REQUIRE(server.GetNumSubscribers() == 1);
+
+	constexpr float TIME_CONSTANT = 1.f / 60.f;
+	constexpr uint32_t NUM_FRAMES = 100;
+	for (uint32_t frame = 1; frame <= NUM_FRAMES; frame++)
+	{
+		simulation->Update(TIME_CONSTANT);
+		const auto bodies = simulation->GetBodies();
+		server.Publish(bodies);
+
+		for (int i = 0; i < 1000 && client.GetFrameIndex() != frame; i++)
+		{
+			server.Poll();
+			client.Receive(1);
+		}
+		REQUIRE(client.GetFrameIndex() == frame);
+
+		// The client should see exactly the quantized bodies overlapping its viewport
+		size_t numVisible = 0;
+		const auto received = client.GetBodies();
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			const auto x = static_cast<int>(bodies[i].x);
+			const auto y = static_cast<int>(bodies[i].y);
+			if (x + kinematics::BODY_RADIUS < VIEW_LEFT || x - kinematics::BODY_RADIUS >= VIEW_RIGHT ||
+			    y + kinematics::BODY_RADIUS < VIEW_TOP || y - kinematics::BODY_RADIUS >= VIEW_BOTTOM)
+				continue;
+
+			REQUIRE(numVisible < received.size());
+			REQUIRE(received[numVisible].index == i);
+			REQUIRE(received[numVisible].x == x);
+			REQUIRE(received[numVisible].y == y);
+			REQUIRE(received[numVisible].color.r == bodies[i].color.r);
+			numVisible++;
+		}
+		REQUIRE(numVisible == received.size());
+	}
+
+	// Keyframes cost 12 bytes per body and deltas roughly 2, so the average should sit well between them
+	CHECK(server.GetStats().keyframes == NUM_FRAMES / 30 + 1);
+	CHECK(client.GetStats().bytes == server.GetStats().bytes);
+	CHECK(client.GetStats().BytesPerBodyPerFrame() < 4);
+	WARN("Bytes per body per frame: " << client.GetStats().BytesPerBodyPerFrame());
+}
+
+TEST_CASE("Stream backpressure", "[stream]")
+{
+	const auto address = kinematics::StreamAddress::Tcp("127.0.0.1", 0);
+	const Rectangle viewport{.x = 0, .y = 0, .width = 800, .height = 600};
+
+	auto simulation = std::make_unique<kinematics::VectorOfStructSim>(800, 600, 500'000);
+	kinematics::FrameServer server(address, 120, 64 * 1024);
+	kinematics::FrameClient client(kinematics::StreamAddress::Tcp("127.0.0.1", server.GetPort()), viewport);
+
+	for (int i = 0; i < 1000 && server.GetNumSubscribers() == 0; i++)
+	{
+		server.Poll();
+		usleep(1000);
+	}
+	REQUIRE(server.GetNumSubscribers() == 1);
+
+	// A client that isn't reading can't take a full keyframe, so the following frames should be dropped rather than
+	// queued
+	constexpr float TIME_CONSTANT = 1.f / 60.f;
+	for (int frame = 0; frame < 10; frame++)
+	{
+		simulation->Update(TIME_CONSTANT);
+		server.Publish(simulation->GetBodies());
+	}
+	REQUIRE(server.GetStats().droppedFrames > 0);
+
+	// Once it catches up it should be resynchronized with a keyframe of the latest state
+	for (int i = 0; i < 1000 && client.GetFrameIndex() != 1; i++)
+	{
+		server.Poll();
+		client.Receive(1);
+	}
+	REQUIRE(client.GetFrameIndex() == 1);
+
+	const auto keyframes = client.GetStats().keyframes;
+	simulation->Update(TIME_CONSTANT);
+	server.Publish(simulation->GetBodies());
+	for (int i = 0; i < 1000 && client.GetFrameIndex() != 11; i++)
+	{
+		server.Poll();
+		client.Receive(1);
+	}
+	REQUIRE(client.GetFrameIndex() == 11);
+	REQUIRE(client.GetStats().keyframes == keyframes + 1);
+	REQUIRE(client.GetBodies().size() == 500'000);
+}
+
+TEST_CASE("Stream rejects oversized messages", "[stream]")
+{
+	kinematics::FrameServer server(kinematics::StreamAddress::Tcp("127.0.0.1", 0));
+
+	const int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+	REQUIRE(socket >= 0);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(server.GetPort());
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	REQUIRE(connect(socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+
+	// Only the header of a Subscribe claiming far more than a viewport, which the server shouldn't wait for the rest of
+	const uint32_t header[] = {1, 1u << 30};
+	REQUIRE(send(socket, header, sizeof(header), 0) == sizeof(header));
+
+	ssize_t received = -1;
+	char byte;
+	for (int i = 0; i < 1000 && received != 0; i++)
+	{
+		server.Poll();
+		usleep(1000);
+		received = recv(socket, &byte, 1, MSG_DONTWAIT);
+	}
+	CHECK(received == 0);
+	CHECK(server.GetNumSubscribers() == 0);
+	close(socket);
+}
+
+TEST_CASE("Stream rejects deltas that move more bodies than they hold", "[stream]")
+{
+	const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+	REQUIRE(listener >= 0);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	REQUIRE(bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+	REQUIRE(listen(listener, 1) == 0);
+	socklen_t length = sizeof(address);
+	REQUIRE(getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) == 0);
+
+	kinematics::FrameClient client(kinematics::StreamAddress::Tcp("127.0.0.1", ntohs(address.sin_port)),
+	                               Rectangle{.x = 0, .y = 0, .width = 100, .height = 100});
+	const int socket = accept(listener, nullptr, nullptr);
+	REQUIRE(socket >= 0);
+
+	// A keyframe with two bodies, then a delta removing an index that isn't one of them, which leaves two retained
+	// bodies but only a single move to apply
+	const uint32_t keyframe[] = {2, 2 * sizeof(uint32_t) + 2 * sizeof(kinematics::StreamedBody), 1, 2};
+	const kinematics::StreamedBody bodies[] = {{.index = 0, .x = 10, .y = 10, .color = RED},
+	                                           {.index = 1, .x = 20, .y = 20, .color = RED}};
+	const uint32_t delta[] = {3, 5 * sizeof(uint32_t) + 2, 2, 1, 0, 1, 5};
+	const int8_t moves[] = {1, 1};
+	REQUIRE(send(socket, keyframe, sizeof(keyframe), 0) == sizeof(keyframe));
+	REQUIRE(send(socket, bodies, sizeof(bodies), 0) == sizeof(bodies));
+	REQUIRE(client.Receive(1000));
+	REQUIRE(client.GetBodies().size() == 2);
+
+	REQUIRE(send(socket, delta, sizeof(delta), 0) == sizeof(delta));
+	REQUIRE(send(socket, moves, sizeof(moves), 0) == sizeof(moves));
+	CHECK_FALSE(client.Receive(1000));
+	CHECK_FALSE(client.IsConnected());
+	CHECK(client.GetFrameIndex() == 1);
+	CHECK(client.GetBodies().size() == 2);
+
+	close(socket);
+	close(listener);
+}
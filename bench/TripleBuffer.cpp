@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <TripleBuffer.h>
+#include <kinematics.h>
+
+TEST_CASE("TripleBuffer", "[triple]")
+{
+	kinematics::TripleBuffer<int> buffer;
+	buffer.Back() = 1;
+	REQUIRE_FALSE(buffer.HasNew());
+
+	buffer.Publish();
+	REQUIRE(buffer.HasNew());
+	REQUIRE(buffer.Acquire() == 1);
+	REQUIRE_FALSE(buffer.HasNew());
+
+	// Reader only sees the latest of multiple publishes and keeps it until something newer arrives
+	buffer.Back() = 2;
+	buffer.Publish();
+	buffer.Back() = 3;
+	buffer.Publish();
+	REQUIRE(buffer.Acquire() == 3);
+	REQUIRE(buffer.Acquire() == 3);
+}
+
+TEST_CASE("TripleBuffer concurrent", "[triple]")
+{
+	constexpr size_t FRAME_SIZE = 10'000;
+	constexpr int NUM_FRAMES = 2'000;
+
+	kinematics::TripleBuffer<std::vector<int>> buffer;
+	std::jthread writer([&buffer] {
+		for (int frame = 1; frame <= NUM_FRAMES; frame++)
+		{
+			buffer.Back().assign(FRAME_SIZE, frame);
+			buffer.Publish();
+		}
+	});
+
+	// Every acquired frame must be complete (a single value throughout) and never older than the last one seen
+	int lastFrame = 0;
+	while (lastFrame != NUM_FRAMES)
+	{
+		const auto &frame = buffer.Acquire();
+		if (frame.empty())
+			continue;
+
+		const auto value = frame.front();
+		REQUIRE(value >= lastFrame);
+		REQUIRE(std::ranges::all_of(frame, [value](const int element) { return element == value; }));
+		lastFrame = value;
+	}
+}
+
+TEST_CASE("CopyFrame", "[triple]")
+{
+	auto original = std::make_unique<kinematics::VectorOfStructSim>(800, 600, 1'000);
+	const auto bodies = original->GetBodies();
+
+	std::vector<std::unique_ptr<kinematics::Simulation>> simulations;
+	simulations.push_back(std::make_unique<kinematics::VectorOfStructSim>(800, 600, *original.get()));
+	simulations.push_back(std::make_unique<kinematics::StructOfVectorSim>(800, 600, *original.get()));
+	simulations.push_back(std::make_unique<kinematics::StructOfArraySim<1'000'000>>(800, 600, *original.get()));
+	simulations.push_back(std::make_unique<kinematics::StructOfPointerSim>(800, 600, *original.get()));
+	simulations.push_back(std::make_unique<kinematics::StructOfAlignedSim>(800, 600, *original.get()));
+	simulations.push_back(std::make_unique<kinematics::StructOfOversizedSim>(800, 600, *original.get()));
+
+	kinematics::TripleBuffer<kinematics::BodyFrame> frames;
+	for (const auto &simulation : simulations)
+	{
+		simulation->PublishFrame(frames);
+		const auto &frame = frames.Acquire();
+
+		REQUIRE(frame.x.size() == bodies.size());
+		REQUIRE(frame.y.size() == bodies.size());
+		REQUIRE(frame.color.size() == bodies.size());
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			REQUIRE(frame.x[i] == bodies[i].x);
+			REQUIRE(frame.y[i] == bodies[i].y);
+			REQUIRE(frame.color[i].r == bodies[i].color.r);
+		}
+	}
+}
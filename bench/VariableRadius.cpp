@@ -0,0 +1,96 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Backends.h>
+#include <kinematics.h>
+
+#include "Fixtures.h"
+
+TEST_CASE("VariableRadiusSim", "[radius]")
+{
+	SECTION("Random bodies have radii of their own")
+	{
+		const kinematics::VariableRadiusSim<float> simulation(WIDTH, HEIGHT, 1'000);
+		const auto radii = simulation.GetRadii();
+		REQUIRE(radii.size() == 1'000);
+
+		bool anyDifferent = false;
+		for (const auto radius : radii)
+		{
+			REQUIRE(radius >= kinematics::VariableRadiusSim<float>::MIN_RADIUS);
+			REQUIRE(radius <= kinematics::VariableRadiusSim<float>::MAX_RADIUS);
+			anyDifferent |= radius != radii.front();
+		}
+		CHECK(anyDifferent);
+	}
+
+	SECTION("Radii carry over when copying, rounded to whole units when quantized")
+	{
+		const kinematics::VariableRadiusSim<float> original(WIDTH, HEIGHT, 1'000);
+		const kinematics::VariableRadiusSim<uint8_t> quantized(WIDTH, HEIGHT, original);
+		const kinematics::VariableRadiusSim<float> copy(WIDTH, HEIGHT, quantized);
+		REQUIRE(copy.GetRadii() == original.GetRadii()); // random radii are already whole units
+
+		// Simulations without radii of their own have every body at `BODY_RADIUS`, and keep none when copied to
+		const kinematics::StructOfVectorSim uniform(WIDTH, HEIGHT, original);
+		REQUIRE(uniform.GetRadii().empty());
+		for (const auto radius : kinematics::VariableRadiusSim<uint8_t>(WIDTH, HEIGHT, uniform).GetRadii())
+			REQUIRE(radius == kinematics::BODY_RADIUS);
+	}
+
+	SECTION("Bodies bounce off the bounds at their own radius")
+	{
+		for (const auto *name : {"VariableRadiusSim", "QuantizedRadiusSim"})
+		{
+			const kinematics::VariableRadiusSim<float> original(WIDTH, HEIGHT, 10'000);
+			auto simulation = kinematics::FindBackend(name)->create(WIDTH, HEIGHT, original);
+			REQUIRE(simulation->GetRadii().size() == original.GetNumBodies());
+
+			for (int step = 0; step < 120; step++)
+				RequireStepLikeSweep(*simulation, 1e-3f);
+		}
+	}
+
+	SECTION("Bodies of `BODY_RADIUS` move the same as without a radius per body")
+	{
+		const kinematics::VectorOfStructSim original(WIDTH, HEIGHT, 10'007);
+		for (const auto *name : {"VariableRadiusSim", "QuantizedRadiusSim"})
+		{
+			auto simulation = kinematics::FindBackend(name)->create(WIDTH, HEIGHT, original);
+			kinematics::StructOfVectorSim expected(WIDTH, HEIGHT, original);
+			for (int step = 0; step < 120; step++)
+			{
+				simulation->Update(TIME_STEP);
+				expected.Update(TIME_STEP);
+			}
+
+			const auto bodies = simulation->GetBodies();
+			const auto expectedBodies = expected.GetBodies();
+			for (size_t i = 0; i < bodies.size(); i++)
+			{
+				REQUIRE_THAT(bodies[i].x, Catch::Matchers::WithinAbs(expectedBodies[i].x, 1e-3));
+				REQUIRE_THAT(bodies[i].y, Catch::Matchers::WithinAbs(expectedBodies[i].y, 1e-3));
+				REQUIRE(bodies[i].horizontalSpeed == expectedBodies[i].horizontalSpeed);
+				REQUIRE(bodies[i].verticalSpeed == expectedBodies[i].verticalSpeed);
+			}
+		}
+	}
+}
+
+TEST_CASE("Update with a radius per body", "[radius]")
+{
+	constexpr size_t NUM_BODIES = 1'000'000;
+	const kinematics::VariableRadiusSim<float> original(WIDTH, HEIGHT, NUM_BODIES);
+
+	for (const auto *name : {"StructOfVectorSim", "VariableRadiusSim", "QuantizedRadiusSim"})
+	{
+		auto simulation = kinematics::FindBackend(name)->create(WIDTH, HEIGHT, original);
+		BENCHMARK(std::string("Update ") + name + ": " + std::to_string(NUM_BODIES))
+		{
+			return simulation->Update(TIME_STEP);
+		};
+	}
+}
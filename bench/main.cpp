@@ -1,36 +1,76 @@
+#include <array>
 #include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <map>
 #include <memory>
+#include <numeric>
 #include <raylib.h>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <kinematics.h>
 
+#include "Caches.h"
+#include "Harness.h"
+
 TEST_CASE("Update", "[update]")
 {
-	auto size = static_cast<size_t>(GENERATE(1'000, 10'000, 100'000, 1'000'000, 5'000'000));
+	// Each implementation is measured at sizes around every cache boundary for its own footprint, so sizes are
+	// gathered up front to create every snapshot once
+	const auto &options = GetHarnessOptions();
+	std::map<size_t, std::vector<std::pair<const Implementation *, Regime>>> sizes;
+	for (const auto &implementation : GetImplementations())
+	{
+		for (const auto &point : CacheSweep(implementation.bytesPerBody))
+		{
+			const bool fits = point.numBodies <= implementation.maxBodies;
+			const bool allowed = !options.maxBodies || point.numBodies <= options.maxBodies;
+			if (fits && allowed)
+				sizes[point.numBodies].emplace_back(&implementation, point.regime);
+		}
+	}
 
-	auto vectorOfStructSim = std::make_unique<kinematics::VectorOfStructSim>(800, 600, size);
-	auto structOfVectorSim = std::make_unique<kinematics::StructOfVectorSim>(800, 600, *vectorOfStructSim.get());
-	auto structOfArraySim =
-		std::make_unique<kinematics::StructOfArraySim<5'000'000>>(800, 600, *vectorOfStructSim.get());
-	auto structOfPointerSim = std::make_unique<kinematics::StructOfPointerSim>(800, 600, *vectorOfStructSim.get());
-	auto structOfAlignedSim = std::make_unique<kinematics::StructOfAlignedSim>(800, 600, *vectorOfStructSim.get());
-	auto structOfOversizedSim = std::make_unique<kinematics::StructOfOversizedSim>(800, 600, *vectorOfStructSim.get());
-	auto ompSimdSim = std::make_unique<kinematics::OmpSimdSim>(800, 600, *vectorOfStructSim.get());
-	auto ompForSim = std::make_unique<kinematics::OmpForSim>(800, 600, *vectorOfStructSim.get());
-
-	// `Update()` has obvious side-effects so it isn't ideal to reuse simulations, but may be accurate enough for
-	// this benchmark
-
-	constexpr float TIME_CONSTANT = 1.f / 60.f;
-	BENCHMARK("Update VectorOfStructSim: " + std::to_string(size)) { return vectorOfStructSim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update StructOfVectorSim: " + std::to_string(size)) { return structOfVectorSim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update StructOfArraySim: " + std::to_string(size)) { return structOfArraySim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update StructOfPointerSim: " + std::to_string(size)) { return structOfPointerSim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update StructOfAlignedSim: " + std::to_string(size)) { return structOfAlignedSim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update StructOfOversizedSim: " + std::to_string(size)) { return structOfOversizedSim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update OmpSimdSim: " + std::to_string(size)) { return ompSimdSim->Update(TIME_CONSTANT); };
-	BENCHMARK("Update OmpForSim: " + std::to_string(size)) { return ompForSim->Update(TIME_CONSTANT); };
+	// Average bodies per second of each implementation in each regime
+	std::map<std::string, std::array<std::vector<double>, NUM_REGIMES>> byRegime;
+	for (const auto &[size, measurements] : sizes)
+	{
+		// Every implementation starts each sample from a copy of the same bodies
+		const kinematics::VectorOfStructSim snapshot(800, 600, size);
+
+		for (const auto &[implementation, regime] : measurements)
+		{
+			auto result =
+				MeasureUpdate(implementation->name, implementation->create, snapshot, implementation->bytesPerBody);
+			REQUIRE(result.samples.size() == options.samples);
+
+			result.regime = GetRegimeName(regime);
+			Report(result);
+			byRegime[implementation->name][static_cast<size_t>(regime)].push_back(result.BodiesPerSecond());
+		}
+	}
+
+	const auto &caches = GetCacheSizes();
+	std::printf("\nUpdate by regime in M bodies/s, with L1d %zu KiB, L2 %zu KiB and LLC %zu KiB\n", caches.l1d >> 10,
+	            caches.l2 >> 10, caches.llc >> 10);
+	std::printf("%-24s", "");
+	for (size_t regime = 0; regime < NUM_REGIMES; regime++)
+		std::printf(" %10s", GetRegimeName(static_cast<Regime>(regime)));
+	std::printf("\n");
+	for (const auto &implementation : GetImplementations())
+	{
+		std::printf("%-24s", implementation.name.c_str());
+		for (const auto &rates : byRegime[implementation.name])
+		{
+			if (rates.empty())
+				std::printf(" %10s", "-");
+			else
+				std::printf(" %10.1f",
+				            std::accumulate(rates.cbegin(), rates.cend(), 0.0) / static_cast<double>(rates.size()) / 1e6);
+		}
+		std::printf("\n");
+	}
+	std::printf("\n");
 }
 
 // TODO: This should be split into proper tests, but gives good confidence for benchmark as-is
@@ -126,9 +166,20 @@ TEST_CASE("Copy", "[copy]")
 /// Ensures environment is setup before running benchmark, such as by setting the RNG seed used by raylib
 int main(int argc, char *argv[])
 {
+	PinThreads(argv);
+
 	Catch::Session session;
 	session.configData();
 
+	auto &options = GetHarnessOptions();
+	session.cli(session.cli() |
+	            Catch::Clara::Opt(options.jsonPath, "file")["--json"]("write Update results as JSON to this file") |
+	            Catch::Clara::Opt(options.samples, "samples")["--update-samples"]("number of samples per Update result") |
+	            Catch::Clara::Opt(options.minSampleSeconds, "seconds")["--update-sample-time"](
+					"minimum time of each Update sample") |
+	            Catch::Clara::Opt(options.maxBodies, "bodies")["--update-max-bodies"](
+					"largest number of bodies to sweep Update over"));
+
 	// Let Catch process the command line as normal
 	int catchInitResult = session.applyCommandLine(argc, argv);
 	if (catchInitResult != 0)
@@ -141,5 +192,10 @@ int main(int argc, char *argv[])
 
 	// Let Catch run as usual and return the number of failed tests
 	int catchRunResult = session.run();
+	if (!WriteResults())
+	{
+		std::fprintf(stderr, "Failed to write results to %s\n", options.jsonPath.c_str());
+		return catchRunResult ? catchRunResult : 1;
+	}
 	return catchRunResult;
 }
@@ -1,74 +1,278 @@
+#include <AutoTuner.h>
+#include <Backends.h>
+#include <NBodySim.h>
+#include <Tracing.h>
+#include <array>
 #include <chrono>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <raylib.h>
+#include <string>
+#include <utility>
 
 #include "App.h"
 
 App::App(const float width, const float height, const size_t initialNumBodies)
-	: _simulation(std::make_unique<kinematics::ShaderSim>(width, height, initialNumBodies))
+	: _density(static_cast<int>(width), static_cast<int>(height)), _numBodies(initialNumBodies), _frameTimeSeconds(0),
+	  _stepMicroseconds(0), _stepsPerSecond(0), _drawMicroseconds(0), _swapMilliseconds(0)
 {
+	// `ShaderSim` needs the OpenGL context of this thread, so the simulation thread runs whichever CPU backend is
+	// fastest on this machine for the current number of bodies. Any other CPU backend can be swapped to while running.
+	const auto createAutoTuned = [](const float newWidth, const float newHeight, const kinematics::Simulation &toCopy) {
+		return std::make_unique<kinematics::AutoTunedSim>(newWidth, newHeight, toCopy);
+	};
+	_backends.emplace_back("AutoTunedSim", createAutoTuned);
+	for (const auto &backend : kinematics::GetBackends())
+	{
+		if (!backend.requiresOpenGl)
+			_backends.emplace_back(backend.name, backend.create);
+	}
+
+	constexpr float TIME_STEP = 1.f / 60.f;
+	_simulation = std::make_unique<kinematics::SimulationThread>(
+		std::make_unique<kinematics::AutoTunedSim>(width, height, initialNumBodies), TIME_STEP,
+		_backends.front().first);
+
 	if (initialNumBodies >= 1'000'000)
 	{
-		_renderBodies = false;
+		_renderDensity = true;
 		_renderStats = true;
 	}
 }
 
+App::~App()
+{
+	if (_densityTexture.id)
+		UnloadTexture(_densityTexture);
+}
+
 void App::Update()
 {
+	KINEMATICS_TRACE_SCOPE("App::Update");
+
+	const auto startUpdateTime = std::chrono::steady_clock::now();
 	_frameTimeSeconds = GetFrameTime();
 	HandleInput();
 
 	if (IsWindowResized())
 	{
 		_simulation->SetBounds(static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight()));
+		_density.Resize(GetScreenWidth(), GetScreenHeight());
 	}
 
-	if (_updateBodies)
-	{
-		auto startUpdateTime = std::chrono::steady_clock::now();
-		_simulation->Update(_frameTimeSeconds);
-		auto endUpdateTime = std::chrono::steady_clock::now();
+	// Only pay for interpolating positions when they will be drawn
+	const auto &stepped = _renderBodies ? _simulation->Interpolate(_frame, std::chrono::steady_clock::now())
+	                                    : _simulation->AcquireFrame();
 
-		_updateMicroseconds =
-			std::chrono::duration_cast<std::chrono::microseconds>(endUpdateTime - startUpdateTime).count();
-	}
+	_numBodies = stepped.current.x.size();
+	_stepMicroseconds = stepped.stepMicroseconds;
+	_stepsPerSecond = stepped.stepsPerSecond;
+	_backend = stepped.backend;
+	_swapMilliseconds = stepped.swapMilliseconds;
+
+	// The frame time from raylib covers all of the previous frame, while the draw time of that frame has been pushed
+	// already, so all three rings stay in step
+	constexpr float SECONDS_TO_MICROS = 1'000'000;
+	_frameTimes.Push(_frameTimeSeconds * SECONDS_TO_MICROS);
+	_updateTimes.Push(
+		std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - startUpdateTime).count());
 }
 
-void App::DrawFrame() const
+void App::DrawFrame()
 {
+	KINEMATICS_TRACE_SCOPE("App::DrawFrame");
+
 	BeginDrawing();
 	ClearBackground(BEIGE);
 
 	if (_renderBodies)
 	{
-		_simulation->Draw();
+		auto startDrawTime = std::chrono::steady_clock::now();
+		if (_renderDensity)
+			DrawDensity();
+		else
+			_renderer.Draw(_frame);
+		auto endDrawTime = std::chrono::steady_clock::now();
+
+		_drawMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(endDrawTime - startDrawTime).count();
 	}
+	_drawTimes.Push(_renderBodies ? static_cast<float>(_drawMicroseconds) : 0);
 
 	if (_renderStats)
 	{
 		constexpr int SECONDS_TO_MICROS = 1'000'000;
+		const float stepBudgetMicroseconds = _simulation->GetTimeStep() * SECONDS_TO_MICROS;
 
-		DrawRectangle(10, 10, 400, 150, DARKGRAY);
-		DrawText(TextFormat("Bodies:\t%d\nFrame  Time (us):\t%.0f\nUpdate Time (us):\t%ld\nRender "
-		                    "Bodies:\t%d\nUpdate Bodies:\t%d",
-		                    _simulation->GetNumBodies(), static_cast<double>(_frameTimeSeconds * SECONDS_TO_MICROS),
-		                    _updateMicroseconds, _renderBodies, _updateBodies),
+		DrawRectangle(10, 10, 400, 285, DARKGRAY);
+		DrawText(TextFormat("Bodies:\t%zu\nBackend:\t%s\nSwap Time (ms):\t%.1f\nFrame  Time (us):\t%.0f\n"
+		                    "Draw Time (us):\t%ld\nStep Time (us):\t%.0f / %.0f\nSteps / Second:\t%.1f\n"
+		                    "Render Bodies:\t%d\nRender Density:\t%d\nUpdate Bodies:\t%d",
+		                    _numBodies, _backend.c_str(), static_cast<double>(_swapMilliseconds),
+		                    static_cast<double>(_frameTimeSeconds * SECONDS_TO_MICROS), _drawMicroseconds,
+		                    static_cast<double>(_stepMicroseconds), static_cast<double>(stepBudgetMicroseconds),
+		                    static_cast<double>(_stepsPerSecond), _renderBodies, _renderDensity, _updateBodies),
 		         20, 40, 20, WHITE);
+
+		DrawTimes(10, 305);
 	}
 
 	DrawFPS(15, 15);
 	EndDrawing();
 }
 
+void App::DrawDensity()
+{
+	_density.Rasterize(_frame);
+
+	if (_densityTexture.width != _density.GetWidth() || _densityTexture.height != _density.GetHeight())
+	{
+		if (_densityTexture.id)
+			UnloadTexture(_densityTexture);
+
+		Image image = GenImageColor(_density.GetWidth(), _density.GetHeight(), BLANK);
+		_densityTexture = LoadTextureFromImage(image);
+		UnloadImage(image);
+	}
+
+	UpdateTexture(_densityTexture, _density.GetPixels().data());
+	DrawTexture(_densityTexture, 0, 0, WHITE);
+}
+
+void App::DrawTimes(const int x, const int y)
+{
+	constexpr int WIDTH = 400, HEIGHT = 215, ROW_HEIGHT = 22, COLUMN_WIDTH = 70, FONT_SIZE = 20;
+	DrawRectangle(x, y, WIDTH, HEIGHT, DARKGRAY);
+
+	// The first column holds the names, which are wider than the numbers
+	const auto columnX = [x](const int column) { return x + 10 + (column ? 50 + column * COLUMN_WIDTH : 0); };
+
+	const std::array<const char *, 5> headings = {"Time (us)", "p50", "p95", "p99", "max"};
+	for (int column = 0; column < static_cast<int>(headings.size()); column++)
+		DrawText(headings[static_cast<size_t>(column)], columnX(column), y + 10, FONT_SIZE, WHITE);
+
+	const auto drawRow = [&](const int row, const char *name, const kinematics::SampleStats &stats) {
+		const int rowY = y + 10 + row * ROW_HEIGHT;
+		DrawText(name, columnX(0), rowY, FONT_SIZE, WHITE);
+
+		int column = 1;
+		for (const auto value : {stats.p50, stats.p95, stats.p99, stats.max})
+			DrawText(TextFormat("%.0f", static_cast<double>(value)), columnX(column++), rowY, FONT_SIZE, WHITE);
+	};
+
+	// Frame times are kept for the histogram below
+	_updateTimes.Copy(_samples);
+	drawRow(2, "Update", kinematics::SampleStats::Compute(_samples));
+	_drawTimes.Copy(_samples);
+	drawRow(3, "Draw", kinematics::SampleStats::Compute(_samples));
+	_simulation->GetStepTimes().Copy(_samples);
+	drawRow(4, "Step", kinematics::SampleStats::Compute(_samples));
+	_frameTimes.Copy(_samples);
+	drawRow(1, "Frame", kinematics::SampleStats::Compute(_samples));
+
+	// Frame times in buckets that double in width, from under 1 ms to 64 ms and more
+	constexpr std::array<const char *, 8> LABELS = {"<1", "1", "2", "4", "8", "16", "32", "64+"};
+	std::array<size_t, LABELS.size()> counts{};
+	for (const auto microseconds : _samples)
+	{
+		size_t bucket = 0;
+		for (float upper = 1'000; bucket < counts.size() - 1 && microseconds >= upper; upper *= 2)
+			bucket++;
+		counts[bucket]++;
+	}
+
+	// Buckets up to 16 ms fit within a frame at 60 Hz
+	constexpr size_t WITHIN_BUDGET = 5;
+	constexpr int BAR_WIDTH = 40, BAR_HEIGHT = 60;
+	const int barsY = y + 10 + 5 * ROW_HEIGHT + 5;
+	const auto largest = std::max<size_t>(*std::max_element(counts.cbegin(), counts.cend()), 1);
+	for (size_t bucket = 0; bucket < counts.size(); bucket++)
+	{
+		const int barX = x + 10 + static_cast<int>(bucket) * (BAR_WIDTH + 8);
+		const int height = static_cast<int>(counts[bucket] * BAR_HEIGHT / largest);
+		DrawRectangle(barX, barsY + BAR_HEIGHT - height, BAR_WIDTH, height, bucket < WITHIN_BUDGET ? LIME : ORANGE);
+		DrawText(LABELS[bucket], barX, barsY + BAR_HEIGHT + 2, 10, WHITE);
+	}
+}
+
+void App::WriteTimes()
+{
+	const auto seconds =
+		std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	const auto path = "frame-times-" + std::to_string(seconds) + ".csv";
+
+	// One row per sample, which keeps step times, taken at their own rate, in the same file as the per-frame times
+	std::ofstream file(path);
+	file << "series,sample,microseconds\n";
+	const auto writeSeries = [&](const char *name) {
+		for (size_t i = 0; i < _samples.size(); i++)
+			file << name << ',' << i << ',' << _samples[i] << '\n';
+	};
+	_frameTimes.Copy(_samples);
+	writeSeries("frame");
+	_updateTimes.Copy(_samples);
+	writeSeries("update");
+	_drawTimes.Copy(_samples);
+	writeSeries("draw");
+	_simulation->GetStepTimes().Copy(_samples);
+	writeSeries("step");
+
+	if (file)
+		TraceLog(LOG_INFO, "Wrote frame times to %s", path.c_str());
+	else
+		TraceLog(LOG_WARNING, "Failed to write frame times to %s", path.c_str());
+}
+
 void App::HandleInput()
 {
 	if (IsKeyPressed(KEY_R))
 		_renderBodies = !_renderBodies;
+	if (IsKeyPressed(KEY_D))
+		_renderDensity = !_renderDensity;
 	if (IsKeyPressed(KEY_S))
 		_renderStats = !_renderStats;
+	if (IsKeyPressed(KEY_C))
+		WriteTimes();
 	if (IsKeyPressed(KEY_U))
+	{
 		_updateBodies = !_updateBodies;
+		_simulation->SetPaused(!_updateBodies);
+	}
+	if (IsKeyPressed(KEY_B))
+	{
+		// Cycle forwards through the backends, or backwards while holding shift, skipping any that can't hold the
+		// current bodies. `AutoTunedSim` holds any number, so there is always one to stop at.
+		const bool backwards = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+		const auto holdsBodies = [this](const std::string &name) {
+			const auto *backend = kinematics::FindBackend(name);
+			return !backend || _numBodies <= backend->maxBodies;
+		};
+		do
+			_backendIndex = (_backendIndex + (backwards ? _backends.size() - 1 : 1)) % _backends.size();
+		while (!holdsBodies(_backends[_backendIndex].first));
+
+		const auto &[name, create] = _backends[_backendIndex];
+		_simulation->SetBackend(name, create);
+		_nBody = false;
+	}
+	if (IsKeyPressed(KEY_N))
+	{
+		// Gravity between bodies needs `NBodySim`, and turning it off goes back to the backend it replaced
+		_nBody = !_nBody;
+		if (_nBody)
+		{
+			_simulation->SetBackend("NBodySim", [](const float width, const float height,
+			                                       const kinematics::Simulation &toCopy) {
+				return std::make_unique<kinematics::NBodySim>(width, height, toCopy);
+			});
+		}
+		else
+		{
+			const auto &[name, create] = _backends[_backendIndex];
+			_simulation->SetBackend(name, create);
+		}
+	}
+	UpdateForces();
 
 	constexpr size_t SMALL_COUNT = 1;
 	constexpr size_t MEDIUM_COUNT = 100'000;
@@ -140,3 +344,34 @@ void App::HandleInput()
 	else if (IsKeyPressed(KEY_F10))
 		_simulation->SetNumBodies(10 * LARGE_COUNT);
 }
+
+void App::UpdateForces()
+{
+	const bool toggleGravity = IsKeyPressed(KEY_G);
+	const bool attract = IsMouseButtonDown(MOUSE_BUTTON_LEFT), repel = IsMouseButtonDown(MOUSE_BUTTON_RIGHT);
+	const bool mouseField = attract != repel;
+
+	// The field follows the mouse, so it's sent every frame it's held
+	if (!toggleGravity && !mouseField && !_mouseField)
+		return;
+	_gravity ^= toggleGravity;
+	_mouseField = mouseField;
+
+	if (!_gravity && !_mouseField)
+	{
+		// No forces at all keeps the simulation on its plain update loop
+		_simulation->SetForces(std::nullopt);
+		return;
+	}
+
+	constexpr float GRAVITY = 200, FIELD_STRENGTH = 2'000, FIELD_RANGE = 300;
+	kinematics::Forces forces;
+	if (_gravity)
+		forces.gravity = {0, GRAVITY};
+	if (_mouseField)
+	{
+		const auto mouse = GetMousePosition();
+		forces.fields.push_back({mouse.x, mouse.y, attract ? FIELD_STRENGTH : -FIELD_STRENGTH, FIELD_RANGE});
+	}
+	_simulation->SetForces(std::move(forces));
+}
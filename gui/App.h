@@ -1,28 +1,79 @@
 #pragma once
+#include <Backends.h>
+#include <DensityRasterizer.h>
+#include <PointRenderer.h>
+#include <SampleRing.h>
+#include <SimulationThread.h>
 #include <kinematics.h>
 #include <memory>
+#include <raylib.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 class App
 {
   public:
 	App(const float width, const float height, const size_t initialNumBodies);
+	~App();
 
+	App(const App &) = delete;
+	App &operator=(const App &) = delete;
+
+	/// Handle input and collect the positions of bodies to draw. The simulation itself is updated on its own thread.
 	void Update();
 
 	/// Top level draw function for the entire scene.
 	/// Includes: Background, FPS counter, statistics and `Simulation` contents.
-	void DrawFrame() const;
+	void DrawFrame();
 
   private:
-	bool _renderBodies = true, _renderStats = false;
+	bool _renderBodies = true, _renderDensity = false, _renderStats = false;
 	bool _updateBodies = true;
-	std::unique_ptr<kinematics::Simulation> _simulation;
+	bool _gravity = false, _mouseField = false; // forces last sent to the simulation
+	bool _nBody = false;                        // bodies attract each other, using `NBodySim`
+	std::unique_ptr<kinematics::SimulationThread> _simulation;
+
+	// Backends that can be swapped between while running, starting with the one chosen by `AutoTuner`
+	std::vector<std::pair<std::string, kinematics::BackendFactory>> _backends;
+	size_t _backendIndex = 0;
+
+	kinematics::BodyFrame _frame; // positions interpolated for the current frame
+	kinematics::PointRenderer _renderer;
 
+	// When there are more bodies than pixels they are instead rasterized on the CPU and uploaded as a single texture
+	kinematics::DensityRasterizer _density;
+	Texture2D _densityTexture{};
+
+	size_t _numBodies;
 	float _frameTimeSeconds;
-	long _updateMicroseconds;
+	float _stepMicroseconds, _stepsPerSecond;
+	long _drawMicroseconds;
+	std::string _backend;
+	float _swapMilliseconds;
+
+	// Microseconds taken by each of the most recent frames, with every ring written once per frame so the same
+	// position in each is the same frame
+	static constexpr size_t FRAME_HISTORY = 1024;
+	kinematics::SampleRing<float, FRAME_HISTORY> _updateTimes, _drawTimes, _frameTimes;
+	std::vector<float> _samples; // reused for copies of a ring
 
   private:
 	/// Update the simulation according to user input.
-	/// Includes: Toggle for rendering bodies, toggle for updating bodies, setting number of bodies
+	/// Includes: Toggle for rendering bodies, toggle for density rendering, toggle for updating bodies, setting number
+	/// of bodies, swapping backends, gravity between bodies, writing frame times, gravity and a force field following
+	/// the mouse
 	void HandleInput();
+
+	/// Send the forces for the current input to the simulation when they've changed, or while the mouse field is held
+	void UpdateForces();
+
+	/// Rasterize `_frame` and draw it as a single texture covering the window
+	void DrawDensity();
+
+	/// Draw percentiles of recent frame, update, draw and step times, and a histogram of frame times
+	void DrawTimes(const int x, const int y);
+
+	/// Write every retained frame, update, draw and step time to a CSV file in the working directory
+	void WriteTimes();
 };
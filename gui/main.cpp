@@ -1,3 +1,4 @@
+#include <Tracing.h>
 #include <raylib.h>
 
 #include "App.h"
@@ -14,6 +15,8 @@ void Run(const size_t startingNumBodies)
 
 int main(int argc, char **argv)
 {
+	KINEMATICS_TRACE_THREAD("main");
+
 	SetConfigFlags(FLAG_WINDOW_RESIZABLE); //| FLAG_VSYNC_HINT);
 	InitWindow(800, 600, "Kinematics Demo");
 
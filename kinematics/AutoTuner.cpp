@@ -0,0 +1,325 @@
+#include "AutoTuner.h"
+#include "BounceEvents.h"
+#include "Tracing.h"
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <omp.h>
+#include <sstream>
+
+namespace kinematics
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr float TIME_STEP = 1.f / 60.f;
+
+// Each candidate is timed over a few rounds, keeping the fastest, so a single interruption doesn't decide the winner
+constexpr int ROUNDS = 3;
+constexpr double MIN_ROUND_SECONDS = 0.01;
+
+// Used while moving to a backend that can hold more bodies than the current one, as it has no limit of its own
+constexpr std::string_view UNLIMITED_BACKEND = "StructOfVectorSim";
+
+/// @returns Seconds per update of `simulation` and copy of its frame, the fastest of a few rounds. Every step is copied
+/// out to be drawn, which is where backends that only find positions when they're read pay for them.
+double TimeUpdate(Simulation &simulation)
+{
+	// Once untimed, to fault in any memory touched for the first time
+	BodyFrame frame;
+	simulation.Update(TIME_STEP);
+	simulation.CopyFrame(frame);
+
+	double fastest = std::numeric_limits<double>::max();
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		size_t numUpdates = 0;
+		const auto start = Clock::now();
+		std::chrono::duration<double> elapsed{};
+		do
+		{
+			simulation.Update(TIME_STEP);
+			simulation.CopyFrame(frame);
+			numUpdates++;
+			elapsed = Clock::now() - start;
+		} while (elapsed.count() < MIN_ROUND_SECONDS);
+
+		fastest = std::min(fastest, elapsed.count() / static_cast<double>(numUpdates));
+	}
+	return fastest;
+}
+} // namespace
+
+std::string TuningWorkload::GetName() const
+{
+	std::string name;
+	const auto add = [&name](const char *work) { name += (name.empty() ? "" : ", ") + std::string(work); };
+	if (forces)
+		add("forces");
+	if (obstacles)
+		add("obstacles");
+	if (recordsBounces)
+		add("bounce events");
+	return name;
+}
+
+std::string GetCpuModel()
+{
+	std::ifstream cpuInfo("/proc/cpuinfo");
+	std::string line;
+	while (std::getline(cpuInfo, line))
+	{
+		if (line.starts_with("model name"))
+			return line.substr(line.find(':') + 2);
+	}
+	return "unknown";
+}
+
+AutoTuner::AutoTuner(std::filesystem::path cachePath)
+	: _cachePath(std::move(cachePath)),
+	  _host(GetCpuModel() + " (" + std::to_string(omp_get_max_threads()) + " threads)")
+{
+	Load();
+}
+
+unsigned AutoTuner::GetBucket(const size_t numBodies) { return static_cast<unsigned>(std::bit_width(numBodies)); }
+
+std::filesystem::path AutoTuner::GetDefaultCachePath()
+{
+	std::filesystem::path directory;
+	if (const char *cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+		directory = cacheHome;
+	else if (const char *home = std::getenv("HOME"); home && *home)
+		directory = std::filesystem::path(home) / ".cache";
+	else
+		return {};
+
+	return directory / "kinematics-demo" / "backends.tsv";
+}
+
+const Backend &AutoTuner::Choose(const float width, const float height, const Simulation &current,
+                                 const TuningWorkload &workload)
+{
+	const auto numBodies = current.GetNumBodies();
+	const auto workloadName = workload.GetName();
+	const auto host = workloadName.empty() ? _host : _host + " with " + workloadName;
+	const auto key = std::make_pair(host, GetBucket(numBodies));
+	const auto decision = _decisions.find(key);
+
+	// A backend may have been renamed, not registered in this run or no longer be tunable
+	const auto *decided = decision != _decisions.end() ? FindBackend(decision->second) : nullptr;
+	if (decided && !decided->tunable)
+		decided = nullptr;
+	if (decided && numBodies <= decided->maxBodies)
+		return *decided;
+
+	const auto &fastest = Measure(width, height, current, workload);
+
+	// A backend with a limit can win a bucket it only partly fits in, so its decision is kept for the sizes it can hold
+	if (!decided)
+	{
+		_decisions[key] = fastest.name;
+		Save();
+	}
+	return fastest;
+}
+
+const Backend &AutoTuner::Measure(const float width, const float height, const Simulation &current,
+                                  const TuningWorkload &workload) const
+{
+	const Backend *fastest = FindBackend(UNLIMITED_BACKEND);
+	double fastestSeconds = std::numeric_limits<double>::max();
+	BounceEvents bounces;
+
+	for (const auto &backend : GetBackends())
+	{
+		if (!backend.tunable || backend.requiresOpenGl || current.GetNumBodies() > backend.maxBodies)
+			continue;
+
+		auto candidate = backend.create(width, height, current);
+		candidate->SetForces(workload.forces);
+		candidate->SetObstacles(workload.obstacles);
+		candidate->SetBounceEvents(workload.recordsBounces ? &bounces : nullptr);
+		const auto seconds = TimeUpdate(*candidate);
+		if (seconds < fastestSeconds)
+		{
+			fastest = &backend;
+			fastestSeconds = seconds;
+		}
+	}
+
+	return *fastest;
+}
+
+void AutoTuner::Load()
+{
+	if (_cachePath.empty())
+		return;
+
+	// One decision per line: host, bucket and backend separated by tabs, as a CPU model may contain spaces
+	std::ifstream file(_cachePath);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string host, bucket, backend;
+		if (!std::getline(fields, host, '\t') || !std::getline(fields, bucket, '\t') || !std::getline(fields, backend))
+			continue;
+
+		try
+		{
+			_decisions[{host, static_cast<unsigned>(std::stoul(bucket))}] = backend;
+		}
+		catch (const std::exception &)
+		{
+			// Skip anything that isn't a decision, rather than give up on the rest of the file
+		}
+	}
+}
+
+void AutoTuner::Save() const
+{
+	if (_cachePath.empty())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(_cachePath.parent_path(), error);
+
+	// Written in full to a temporary file first, so another process never reads half a file
+	auto temporaryPath = _cachePath;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath);
+		for (const auto &[key, backend] : _decisions)
+			file << key.first << '\t' << key.second << '\t' << backend << '\n';
+		if (!file)
+			return;
+	}
+	std::filesystem::rename(temporaryPath, _cachePath, error);
+}
+
+AutoTunedSim::AutoTunedSim(const float width, const float height, const size_t numBodies, AutoTuner tuner)
+	: Simulation(width, height), _tuner(std::move(tuner)), _backend(FindBackend(UNLIMITED_BACKEND)),
+	  _simulation(std::make_unique<StructOfVectorSim>(width, height, numBodies)), _bucket(0)
+{
+	Tune();
+}
+
+AutoTunedSim::AutoTunedSim(const float width, const float height, const Simulation &toCopy, AutoTuner tuner)
+	: Simulation(width, height), _tuner(std::move(tuner)), _backend(FindBackend(UNLIMITED_BACKEND)),
+	  _simulation(std::make_unique<StructOfVectorSim>(width, height, toCopy)), _bucket(0)
+{
+	Tune();
+}
+
+void AutoTunedSim::Update(const float deltaTime) { _simulation->Update(deltaTime); }
+
+void AutoTunedSim::Draw() const { _simulation->Draw(); }
+
+void AutoTunedSim::SetNumBodies(const size_t totalNumBodies)
+{
+	MakeRoom(totalNumBodies);
+	_simulation->SetNumBodies(totalNumBodies);
+	if (AutoTuner::GetBucket(totalNumBodies) != _bucket)
+		Tune();
+}
+
+size_t AutoTunedSim::GetNumBodies() const { return _simulation->GetNumBodies(); }
+
+std::vector<Body> AutoTunedSim::GetBodies() const { return _simulation->GetBodies(); }
+
+std::vector<float> AutoTunedSim::GetRadii() const { return _simulation->GetRadii(); }
+
+void AutoTunedSim::CopyFrame(BodyFrame &frame) const { _simulation->CopyFrame(frame); }
+
+void AutoTunedSim::SetBounds(const float width, const float height)
+{
+	Simulation::SetBounds(width, height);
+	_simulation->SetBounds(width, height);
+}
+
+void AutoTunedSim::SetBounceEvents(BounceEvents *events)
+{
+	const bool changesWorkload = (events == nullptr) != (_bounceEvents == nullptr);
+	Simulation::SetBounceEvents(events);
+	_simulation->SetBounceEvents(events);
+	if (changesWorkload)
+		Tune();
+}
+
+void AutoTunedSim::SetObstacles(const ObstacleGrid *obstacles)
+{
+	const bool changesWorkload = (obstacles == nullptr) != (_obstacles == nullptr);
+	Simulation::SetObstacles(obstacles);
+	_simulation->SetObstacles(obstacles);
+	if (changesWorkload)
+		Tune();
+}
+
+void AutoTunedSim::SetForces(const Forces *forces)
+{
+	const bool changesWorkload = (forces == nullptr) != (_forces == nullptr);
+	Simulation::SetForces(forces);
+	_simulation->SetForces(forces);
+	if (changesWorkload)
+		Tune();
+}
+
+void AutoTunedSim::SetSpatialIndex(SpatialIndex *index)
+{
+	// Only the backend builds the index, rather than building it from a copy here as well
+	_spatialIndex = index;
+	_simulation->SetSpatialIndex(index);
+}
+
+const std::string &AutoTunedSim::GetBackendName() const { return _backend->name; }
+
+void AutoTunedSim::RebuildSpatialIndex() {}
+
+void AutoTunedSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+                                const Color *__restrict__ color, const size_t numBodies)
+{
+	const auto totalNumBodies = GetNumBodies() + numBodies;
+	MakeRoom(totalNumBodies);
+	_simulation->AddBodies(x, y, horizontalSpeed, verticalSpeed, color, numBodies);
+	if (AutoTuner::GetBucket(totalNumBodies) != _bucket)
+		Tune();
+}
+
+void AutoTunedSim::MakeRoom(const size_t totalNumBodies)
+{
+	// Bodies have to fit before the tuner can time anything with them
+	if (totalNumBodies > _backend->maxBodies)
+	{
+		_backend = FindBackend(UNLIMITED_BACKEND);
+		_simulation = _backend->create(_width, _height, *_simulation);
+		_simulation->SetBounceEvents(_bounceEvents);
+		_simulation->SetObstacles(_obstacles);
+		_simulation->SetForces(_forces);
+		_simulation->SetSpatialIndex(_spatialIndex);
+	}
+}
+
+void AutoTunedSim::Tune()
+{
+	KINEMATICS_TRACE_SCOPE("AutoTunedSim::Tune");
+
+	_bucket = AutoTuner::GetBucket(GetNumBodies());
+
+	const TuningWorkload workload{.forces = _forces, .obstacles = _obstacles, .recordsBounces = _bounceEvents != nullptr};
+	const auto &fastest = _tuner.Choose(_width, _height, *_simulation, workload);
+	if (&fastest != _backend)
+	{
+		_simulation = fastest.create(_width, _height, *_simulation);
+		_simulation->SetBounceEvents(_bounceEvents);
+		_simulation->SetObstacles(_obstacles);
+		_simulation->SetForces(_forces);
+		_simulation->SetSpatialIndex(_spatialIndex);
+		_backend = &fastest;
+	}
+}
+} // namespace kinematics
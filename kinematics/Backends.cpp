@@ -0,0 +1,79 @@
+#include "Backends.h"
+#include "EventDrivenSim.h"
+#include <algorithm>
+
+namespace kinematics
+{
+namespace
+{
+template <typename T>
+std::unique_ptr<Simulation> Create(const float width, const float height, const Simulation &toCopy)
+{
+	return std::make_unique<T>(width, height, toCopy);
+}
+
+/// Bodies live on the GPU, so only the number of them carries over
+std::unique_ptr<Simulation> CreateShaderSim(const float width, const float height, const Simulation &toCopy)
+{
+	return std::make_unique<ShaderSim>(width, height, toCopy.GetNumBodies());
+}
+
+std::deque<Backend> &Registry()
+{
+	// Structure of Arrays layouts only touch positions and speeds, while an array of `Body` drags colors along too
+	constexpr size_t ARRAY_OF_STRUCT_BYTES = sizeof(Body);
+	constexpr size_t STRUCT_OF_ARRAY_BYTES = 4 * sizeof(float);
+
+	static std::deque<Backend> backends = {
+		{"VectorOfStructSim", Create<VectorOfStructSim>, ARRAY_OF_STRUCT_BYTES},
+		{"StructOfVectorSim", Create<StructOfVectorSim>, STRUCT_OF_ARRAY_BYTES},
+		{"StructOfArraySim", Create<StructOfArraySim<5'000'000>>, STRUCT_OF_ARRAY_BYTES, 5'000'000},
+		{"StructOfPointerSim", Create<StructOfPointerSim>, STRUCT_OF_ARRAY_BYTES},
+		{"StructOfAlignedSim", Create<StructOfAlignedSim>, STRUCT_OF_ARRAY_BYTES},
+		{"StructOfOversizedSim", Create<StructOfOversizedSim>, STRUCT_OF_ARRAY_BYTES},
+		{"OmpSimdSim", Create<OmpSimdSim>, STRUCT_OF_ARRAY_BYTES},
+		{"OmpForSim", Create<OmpForSim>, STRUCT_OF_ARRAY_BYTES},
+		// Bodies have their own radii, round differently or only move when read, so these aren't swapped in by tuning
+		{.name = "VariableRadiusSim",
+		 .create = Create<VariableRadiusSim<float>>,
+		 .bytesPerBody = STRUCT_OF_ARRAY_BYTES + sizeof(float),
+		 .tunable = false},
+		{.name = "QuantizedRadiusSim",
+		 .create = Create<VariableRadiusSim<uint8_t>>,
+		 .bytesPerBody = STRUCT_OF_ARRAY_BYTES + sizeof(uint8_t),
+		 .tunable = false},
+		{.name = "DoublePrecisionSim",
+		 .create = Create<PrecisionSim<double>>,
+		 .bytesPerBody = 4 * sizeof(double),
+		 .tunable = false},
+		// Only bodies that bounce are touched, but each holds the time its position was stored too
+		{.name = "EventDrivenSim",
+		 .create = Create<EventDrivenSim>,
+		 .bytesPerBody = STRUCT_OF_ARRAY_BYTES + sizeof(float),
+		 .tunable = false},
+		{"ShaderSim", CreateShaderSim, STRUCT_OF_ARRAY_BYTES, std::numeric_limits<size_t>::max(), true, false}};
+	return backends;
+}
+} // namespace
+
+const std::deque<Backend> &GetBackends() { return Registry(); }
+
+void RegisterBackend(Backend backend)
+{
+	auto &backends = Registry();
+	const auto isSameName = [&](const Backend &other) { return other.name == backend.name; };
+	const auto existing = std::find_if(backends.begin(), backends.end(), isSameName);
+	if (existing != backends.end())
+		*existing = std::move(backend);
+	else
+		backends.push_back(std::move(backend));
+}
+
+const Backend *FindBackend(const std::string_view name)
+{
+	const auto &backends = Registry();
+	const auto found =
+		std::find_if(backends.cbegin(), backends.cend(), [&](const Backend &backend) { return backend.name == name; });
+	return found != backends.cend() ? &*found : nullptr;
+}
+} // namespace kinematics
@@ -0,0 +1,373 @@
+#include "BarnesHut.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <omp.h>
+
+namespace kinematics
+{
+namespace
+{
+// Morton codes interleave 16 bits of each coordinate, which is a level of the tree for each pair of bits
+constexpr unsigned MAX_LEVEL = 16;
+constexpr uint32_t CELLS_PER_AXIS = 1u << MAX_LEVEL;
+
+// Subtrees from this level down are built in parallel, with up to 4^level of them to spread across threads
+constexpr unsigned PARALLEL_LEVEL = 3;
+constexpr unsigned NO_STOP_LEVEL = MAX_LEVEL + 1;
+
+/// @returns The lower 16 bits of `value` spread out to every other bit
+inline uint32_t SpreadBits(uint32_t value)
+{
+	value &= 0xffff;
+	value = (value | (value << 8)) & 0x00ff00ff;
+	value = (value | (value << 4)) & 0x0f0f0f0f;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+	return value;
+}
+
+/// Add the attraction of `count` bodies, each of `mass` times the strength of a single body or of 1 without
+/// `WEIGHTED`, on a body at `x`, `y` to `accelerationX` and `accelerationY`. A body attracting itself adds nothing, as
+/// it's no distance away.
+template <bool WEIGHTED>
+void Attract(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const float *__restrict__ mass,
+             const size_t count, const float x, const float y, const float softeningSquared, float &accelerationX,
+             float &accelerationY)
+{
+	float sumX = 0, sumY = 0;
+#pragma omp simd reduction(+ : sumX, sumY)
+	for (size_t i = 0; i < count; i++)
+	{
+		const auto dx = bodiesX[i] - x, dy = bodiesY[i] - y;
+		const auto inverseDistance = 1 / std::sqrt(dx * dx + dy * dy + softeningSquared);
+		auto scale = inverseDistance * inverseDistance * inverseDistance;
+		if constexpr (WEIGHTED)
+			scale *= mass[i];
+		sumX += dx * scale;
+		sumY += dy * scale;
+	}
+	accelerationX += sumX;
+	accelerationY += sumY;
+}
+
+/// Call `function` with the range of each non-empty child of `range`, in order
+template <typename Function>
+void ForEachChild(const std::vector<uint32_t> &codes, const uint32_t first, const uint32_t last, const unsigned level,
+                  const Function &function)
+{
+	// Bodies are sorted by code, so the children of a node are consecutive runs of the two bits for the next level
+	const auto shift = 2 * (MAX_LEVEL - 1 - level);
+	auto childFirst = first;
+	for (uint32_t quadrant = 0; quadrant < 4 && childFirst < last; quadrant++)
+	{
+		const auto childLast = static_cast<uint32_t>(
+			std::partition_point(codes.begin() + childFirst, codes.begin() + last,
+		                         [&](const uint32_t code) { return ((code >> shift) & 3) <= quadrant; }) -
+			codes.begin());
+		if (childLast != childFirst)
+			function(childFirst, childLast);
+		childFirst = childLast;
+	}
+}
+
+/// @returns Whether a node of `numBodies` at `level` is a leaf
+bool IsLeaf(const uint32_t numBodies, const unsigned level)
+{
+	return numBodies <= BarnesHutTree::LEAF_SIZE || level == MAX_LEVEL;
+}
+} // namespace
+
+void BarnesHutTree::Build(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies)
+{
+	KINEMATICS_TRACE_SCOPE("BarnesHutTree::Build");
+	assert(numBodies < std::numeric_limits<uint32_t>::max());
+
+	_nodes.clear();
+	if (!numBodies)
+		return;
+
+	SortByMortonCode(bodiesX, bodiesY, numBodies);
+
+	// Subtrees below the top few levels are independent of each other, so they're built in parallel then copied
+	// into place by a sequential pass over the top of the tree
+	const Range root{0, static_cast<uint32_t>(numBodies), 0};
+	_ranges.clear();
+	FindSubtrees(root, PARALLEL_LEVEL);
+
+	_subtrees.resize(_ranges.size());
+#pragma omp parallel for schedule(dynamic)
+	for (size_t i = 0; i < _ranges.size(); i++)
+	{
+		_subtrees[i].clear();
+		Build(_subtrees[i], _ranges[i], NO_STOP_LEVEL);
+	}
+
+	_nextSubtree = 0;
+	Build(_nodes, root, PARALLEL_LEVEL);
+	assert(_nextSubtree == _subtrees.size());
+
+	_leaves.clear();
+	for (uint32_t index = 0; index < _nodes.size(); index++)
+	{
+		if (_nodes[index].next == index + 1)
+			_leaves.push_back(index);
+	}
+}
+
+void BarnesHutTree::SortByMortonCode(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY,
+                                     const size_t numBodies)
+{
+	KINEMATICS_TRACE_SCOPE("BarnesHutTree::SortByMortonCode");
+
+	// Bodies may be slightly outside the bounds of the simulation, so the root is fit to where they actually are
+	float minX = std::numeric_limits<float>::max(), minY = minX;
+	float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+#pragma omp parallel for simd reduction(min : minX, minY) reduction(max : maxX, maxY)
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		minX = std::min(minX, bodiesX[i]);
+		minY = std::min(minY, bodiesY[i]);
+		maxX = std::max(maxX, bodiesX[i]);
+		maxY = std::max(maxY, bodiesY[i]);
+	}
+	_size = std::max({maxX - minX, maxY - minY, std::numeric_limits<float>::min()});
+
+	_codes.resize(numBodies);
+	_order.resize(numBodies);
+	_scratchCodes.resize(numBodies);
+	_scratchOrder.resize(numBodies);
+	// Bodies that all share a position have no extent, which would scale by infinity and turn every offset into NaN
+	const auto scale = std::min(static_cast<float>(CELLS_PER_AXIS) / _size, std::numeric_limits<float>::max());
+	uint32_t *__restrict__ codes = _codes.data();
+	uint32_t *__restrict__ order = _order.data();
+#pragma omp parallel for simd
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		// Clamped before converting, as converting a float outside the range of the integer is undefined
+		constexpr auto LAST_CELL = static_cast<float>(CELLS_PER_AXIS - 1);
+		const auto column = static_cast<uint32_t>(std::fmax(0.f, std::fmin((bodiesX[i] - minX) * scale, LAST_CELL)));
+		const auto row = static_cast<uint32_t>(std::fmax(0.f, std::fmin((bodiesY[i] - minY) * scale, LAST_CELL)));
+		codes[i] = SpreadBits(column) | (SpreadBits(row) << 1);
+		order[i] = static_cast<uint32_t>(i);
+	}
+
+	// Least significant digit radix sort, a byte at a time. Each thread counts the digits of its own range of bodies,
+	// which gives every thread its own place to scatter to for each digit.
+	constexpr size_t RADIX = 256;
+	std::vector<std::array<size_t, RADIX>> offsets(static_cast<size_t>(omp_get_max_threads()));
+	for (unsigned shift = 0; shift < 32; shift += 8)
+	{
+#pragma omp parallel
+		{
+			const auto thread = static_cast<size_t>(omp_get_thread_num());
+			const auto numThreads = static_cast<size_t>(omp_get_num_threads());
+			const auto begin = numBodies * thread / numThreads;
+			const auto end = numBodies * (thread + 1) / numThreads;
+
+			auto &counts = offsets[thread];
+			counts.fill(0);
+			for (auto i = begin; i < end; i++)
+				counts[(_codes[i] >> shift) & (RADIX - 1)]++;
+
+#pragma omp barrier
+#pragma omp single
+			{
+				size_t offset = 0;
+				for (size_t digit = 0; digit < RADIX; digit++)
+				{
+					for (size_t other = 0; other < numThreads; other++)
+					{
+						const auto count = offsets[other][digit];
+						offsets[other][digit] = offset;
+						offset += count;
+					}
+				}
+			}
+
+			for (auto i = begin; i < end; i++)
+			{
+				const auto destination = counts[(_codes[i] >> shift) & (RADIX - 1)]++;
+				_scratchCodes[destination] = _codes[i];
+				_scratchOrder[destination] = _order[i];
+			}
+		}
+		_codes.swap(_scratchCodes);
+		_order.swap(_scratchOrder);
+	}
+
+	// Positions in sorted order, so the bodies of each node are contiguous
+	_x.resize(numBodies);
+	_y.resize(numBodies);
+#pragma omp parallel for
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		_x[i] = bodiesX[_order[i]];
+		_y[i] = bodiesY[_order[i]];
+	}
+}
+
+void BarnesHutTree::FindSubtrees(const Range range, const unsigned stopLevel)
+{
+	if (IsLeaf(range.last - range.first, range.level))
+		return;
+	if (range.level == stopLevel)
+	{
+		_ranges.push_back(range);
+		return;
+	}
+	ForEachChild(_codes, range.first, range.last, range.level, [&](const uint32_t first, const uint32_t last) {
+		FindSubtrees({first, last, range.level + 1}, stopLevel);
+	});
+}
+
+void BarnesHutTree::Build(std::vector<Node> &nodes, const Range range, const unsigned stopLevel)
+{
+	const auto numBodies = range.last - range.first;
+	const bool leaf = IsLeaf(numBodies, range.level);
+	if (!leaf && range.level == stopLevel)
+	{
+		AppendSubtree(nodes);
+		return;
+	}
+
+	const auto index = nodes.size();
+	nodes.emplace_back();
+
+	const auto size = std::ldexp(_size, -static_cast<int>(range.level));
+	Node node{.x = 0,
+	          .y = 0,
+	          .count = static_cast<float>(numBodies),
+	          .sizeSquared = size * size,
+	          .next = 0,
+	          .first = range.first,
+	          .numBodies = numBodies};
+
+	// Center of mass, as the average position of the bodies of a leaf or of the children weighted by their bodies
+	float sumX = 0, sumY = 0;
+	if (leaf)
+	{
+		for (auto i = range.first; i < range.last; i++)
+		{
+			sumX += _x[i];
+			sumY += _y[i];
+		}
+	}
+	else
+	{
+		ForEachChild(_codes, range.first, range.last, range.level, [&](const uint32_t first, const uint32_t last) {
+			const auto child = nodes.size();
+			Build(nodes, {first, last, range.level + 1}, stopLevel);
+			sumX += nodes[child].x * nodes[child].count;
+			sumY += nodes[child].y * nodes[child].count;
+		});
+	}
+
+	node.x = sumX / node.count;
+	node.y = sumY / node.count;
+	node.next = static_cast<uint32_t>(nodes.size());
+	nodes[index] = node;
+}
+
+void BarnesHutTree::AppendSubtree(std::vector<Node> &nodes)
+{
+	const auto &subtree = _subtrees[_nextSubtree++];
+	const auto offset = static_cast<uint32_t>(nodes.size());
+	for (auto node : subtree)
+	{
+		node.next += offset;
+		nodes.push_back(node);
+	}
+}
+
+void BarnesHutTree::Accelerate(const float strength, const float theta, const float softening,
+                               float *__restrict__ accelerationX, float *__restrict__ accelerationY) const
+{
+	KINEMATICS_TRACE_SCOPE("BarnesHutTree::Accelerate");
+
+	const auto thetaSquared = theta * theta, softeningSquared = softening * softening;
+	const auto numNodes = static_cast<uint32_t>(_nodes.size());
+	const Node *nodes = _nodes.data();
+	const float *bodiesX = _x.data(), *bodiesY = _y.data();
+
+	// Rather than each body walking the tree, the bodies of each leaf walk it together, against the box around all
+	// of them. What attracts them is gathered into one list of centers of mass and bodies, which every body of the
+	// leaf then sums in a vectorized loop. Neighbouring leaves walk much the same nodes while they're still in cache.
+#pragma omp parallel
+	{
+		std::vector<float> listX, listY, listMass;
+
+#pragma omp for schedule(dynamic, 64)
+		for (size_t leaf = 0; leaf < _leaves.size(); leaf++)
+		{
+			const auto &group = nodes[_leaves[leaf]];
+			const auto begin = group.first, end = group.first + group.numBodies;
+			const auto [minX, maxX] = std::minmax_element(bodiesX + begin, bodiesX + end);
+			const auto [minY, maxY] = std::minmax_element(bodiesY + begin, bodiesY + end);
+
+			listX.clear();
+			listY.clear();
+			listMass.clear();
+			for (uint32_t index = 0; index < numNodes;)
+			{
+				// Distance to the nearest point of the box, so the node is at least as far from every body in it
+				const auto &node = nodes[index];
+				const auto dx = std::max({*minX - node.x, node.x - *maxX, 0.f});
+				const auto dy = std::max({*minY - node.y, node.y - *maxY, 0.f});
+				if (node.sizeSquared < thetaSquared * (dx * dx + dy * dy))
+				{
+					// Far enough away to attract as a single body at the center of mass, skipping the rest of the
+					// subtree
+					listX.push_back(node.x);
+					listY.push_back(node.y);
+					listMass.push_back(node.count);
+					index = node.next;
+				}
+				else if (node.next == index + 1)
+				{
+					// A leaf too close to approximate, so every one of its bodies attracts on its own
+					listX.insert(listX.end(), bodiesX + node.first, bodiesX + node.first + node.numBodies);
+					listY.insert(listY.end(), bodiesY + node.first, bodiesY + node.first + node.numBodies);
+					listMass.insert(listMass.end(), node.numBodies, 1.f);
+					index = node.next;
+				}
+				else
+				{
+					index++; // first child
+				}
+			}
+
+			for (auto i = begin; i < end; i++)
+			{
+				float sumX = 0, sumY = 0;
+				Attract<true>(listX.data(), listY.data(), listMass.data(), listX.size(), bodiesX[i], bodiesY[i],
+				              softeningSquared, sumX, sumY);
+				accelerationX[_order[i]] = sumX * strength;
+				accelerationY[_order[i]] = sumY * strength;
+			}
+		}
+	}
+}
+
+size_t BarnesHutTree::GetNumNodes() const { return _nodes.size(); }
+
+void AccelerateDirectly(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies,
+                        const float strength, const float softening, float *__restrict__ accelerationX,
+                        float *__restrict__ accelerationY)
+{
+	KINEMATICS_TRACE_SCOPE("AccelerateDirectly");
+
+	const auto softeningSquared = softening * softening;
+#pragma omp parallel for
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		float sumX = 0, sumY = 0;
+		Attract<false>(bodiesX, bodiesY, nullptr, numBodies, bodiesX[i], bodiesY[i], softeningSquared, sumX, sumY);
+		accelerationX[i] = sumX * strength;
+		accelerationY[i] = sumY * strength;
+	}
+}
+} // namespace kinematics
@@ -0,0 +1,291 @@
+#include "BounceEvents.h"
+#include "kinematics.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <immintrin.h>
+#include <limits>
+#include <utility>
+
+namespace kinematics
+{
+void BounceBuffer::Clear() { _count = 0; }
+
+void BounceBuffer::Add(const BounceEvent event)
+{
+	*Reserve(1) = event;
+	Commit(1);
+}
+
+BounceEvent *BounceBuffer::Reserve(const size_t count)
+{
+	if (_events.size() < _count + count)
+		_events.resize(std::max(_count + count, 2 * _events.size()));
+	return _events.data() + _count;
+}
+
+void BounceBuffer::Commit(const size_t count)
+{
+	assert(_count + count <= _events.size());
+	_count += count;
+}
+
+std::span<const BounceEvent> BounceBuffer::Get() const { return {_events.data(), _count}; }
+
+void BounceEvents::BeginStep(const size_t numThreads)
+{
+	assert(numThreads > 0);
+	if (_buffers.size() < numThreads)
+		_buffers.resize(numThreads);
+
+	_numThreads = numThreads;
+	for (size_t thread = 0; thread < _numThreads; thread++)
+		_buffers[thread].Clear();
+	_isJoined = false;
+}
+
+BounceBuffer &BounceEvents::GetBuffer(const size_t thread)
+{
+	assert(thread < _numThreads);
+	return _buffers[thread];
+}
+
+std::span<const BounceEvent> BounceEvents::Get()
+{
+	if (_numThreads == 0)
+		return {};
+
+	// Nothing to join for serial implementations, which are the most common
+	if (_numThreads == 1)
+		return _buffers[0].Get();
+
+	if (!_isJoined)
+	{
+		_joined.clear();
+		for (size_t thread = 0; thread < _numThreads; thread++)
+		{
+			const auto events = _buffers[thread].Get();
+			_joined.insert(_joined.end(), events.begin(), events.end());
+		}
+		_isJoined = true;
+	}
+	return _joined;
+}
+
+namespace
+{
+/// Scalar version of `UpdateRecordingBounces` for targets without SIMD support and for the bodies after the last whole
+/// register
+void UpdateRecordingBouncesScalar(const float deltaTime, const float width, const float height,
+                                  float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                                  float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                                  const size_t begin, const size_t end, BounceBuffer &buffer)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		// Update position based on speed
+		bodiesX[i] += bodiesHorizontalSpeed[i] * deltaTime;
+		bodiesY[i] += bodiesVerticalSpeed[i] * deltaTime;
+
+		// Bounce horizontally
+		const bool left = bodiesX[i] - BODY_RADIUS < 0 && bodiesHorizontalSpeed[i] < 0;
+		const bool right = bodiesX[i] + BODY_RADIUS > width && bodiesHorizontalSpeed[i] > 0;
+		if (left || right)
+		{
+			bodiesHorizontalSpeed[i] *= -1;
+			buffer.Add({static_cast<uint32_t>(i), left ? Wall::Left : Wall::Right});
+		}
+
+		// Bounce vertically
+		const bool top = bodiesY[i] - BODY_RADIUS < 0 && bodiesVerticalSpeed[i] < 0;
+		const bool bottom = bodiesY[i] + BODY_RADIUS > height && bodiesVerticalSpeed[i] > 0;
+		if (top || bottom)
+		{
+			bodiesVerticalSpeed[i] *= -1;
+			buffer.Add({static_cast<uint32_t>(i), top ? Wall::Top : Wall::Bottom});
+		}
+	}
+}
+
+#if defined(__AVX512F__)
+constexpr size_t LANES = 16;
+using Mask = __mmask16;
+
+/// Events of one register of bodies, before knowing which bounced, as 64-bit lanes with the body in the lower half
+struct Indices
+{
+	__m512i lower, upper; // first and last 8 bodies
+
+	/// @param i First body of the register
+	explicit Indices(const size_t i)
+		: lower(_mm512_add_epi64(_mm512_set1_epi64(static_cast<long long>(i)),
+		                         _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7))),
+		  upper(_mm512_add_epi64(lower, _mm512_set1_epi64(8)))
+	{
+	}
+};
+
+/// Write an event for every body of `indices` selected by `mask`, packed together at `out`. Always writes whole
+/// registers of events, of which only the first `popcount(mask)` are kept.
+/// @returns Number of events kept
+size_t Compact(const Indices &indices, const Mask mask, const Wall wall, BounceEvent *out)
+{
+	if (!mask)
+		return 0;
+
+	// Compress within each half, with the wall in the upper 32 bits of each event
+	const auto wallBits = _mm512_set1_epi64(static_cast<long long>(wall) << 32);
+	const auto lowerMask = static_cast<__mmask8>(mask), upperMask = static_cast<__mmask8>(mask >> 8);
+	const auto lowerCount = static_cast<size_t>(std::popcount(lowerMask));
+	_mm512_storeu_si512(out, _mm512_maskz_compress_epi64(lowerMask, _mm512_or_si512(indices.lower, wallBits)));
+	_mm512_storeu_si512(out + lowerCount,
+	                    _mm512_maskz_compress_epi64(upperMask, _mm512_or_si512(indices.upper, wallBits)));
+
+	return lowerCount + static_cast<size_t>(std::popcount(upperMask));
+}
+
+/// Move and bounce one register of bodies along one axis
+/// @returns Bodies that bounced off the lower and upper walls
+std::pair<Mask, Mask> Bounce(__m512 &position, __m512 &speed, const __m512 deltaTime, const __m512 bounds)
+{
+	const auto radius = _mm512_set1_ps(BODY_RADIUS);
+	const auto zero = _mm512_setzero_ps();
+
+	position = _mm512_add_ps(position, _mm512_mul_ps(speed, deltaTime));
+	const Mask lower = _mm512_cmp_ps_mask(_mm512_sub_ps(position, radius), zero, _CMP_LT_OQ) &
+	                   _mm512_cmp_ps_mask(speed, zero, _CMP_LT_OQ);
+	const Mask upper = _mm512_cmp_ps_mask(_mm512_add_ps(position, radius), bounds, _CMP_GT_OQ) &
+	                   _mm512_cmp_ps_mask(speed, zero, _CMP_GT_OQ);
+
+	// Flip the sign of the speed of every body that bounced
+	const auto sign = _mm512_set1_epi32(std::numeric_limits<int>::min());
+	const auto bits = _mm512_castps_si512(speed);
+	speed = _mm512_castsi512_ps(_mm512_mask_xor_epi32(bits, lower | upper, bits, sign));
+
+	return {lower, upper};
+}
+
+using Floats = __m512;
+Floats Load(const float *from) { return _mm512_loadu_ps(from); }
+void Store(float *to, const Floats from) { _mm512_storeu_ps(to, from); }
+Floats Broadcast(const float value) { return _mm512_set1_ps(value); }
+#elif defined(__AVX2__)
+constexpr size_t LANES = 8;
+using Mask = unsigned;
+
+// For each mask of 8 lanes, the lanes to move to the front in order, one byte each. AVX2 has no compress, so lanes
+// are instead moved with a shuffle from this table.
+constexpr auto COMPRESS_TABLE = [] {
+	std::array<uint64_t, 1 << LANES> table{};
+	for (unsigned mask = 0; mask < table.size(); mask++)
+	{
+		unsigned packed = 0;
+		for (unsigned lane = 0; lane < LANES; lane++)
+		{
+			if (mask & (1u << lane))
+				table[mask] |= static_cast<uint64_t>(lane) << (8 * packed++);
+		}
+	}
+	return table;
+}();
+
+/// Write an event for every body of `indices` selected by `mask`, packed together at `out`. Always writes `LANES`
+/// events, of which only the first `popcount(mask)` are kept.
+/// @returns Number of events kept
+size_t Compact(const __m256i indices, const Mask mask, const Wall wall, BounceEvent *out)
+{
+	if (!mask)
+		return 0;
+
+	// Bodies in the lower lanes, then the events widened to 64 bits with the wall in the upper half
+	const auto shuffle = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(COMPRESS_TABLE[mask])));
+	const auto packed = _mm256_permutevar8x32_epi32(indices, shuffle);
+	const auto wallBits = _mm256_set1_epi64x(static_cast<long long>(wall) << 32);
+	const auto lower = _mm256_or_si256(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(packed)), wallBits);
+	const auto upper = _mm256_or_si256(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(packed, 1)), wallBits);
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), lower);
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + LANES / 2), upper);
+
+	return static_cast<size_t>(std::popcount(mask));
+}
+
+/// Move and bounce one register of bodies along one axis
+/// @returns Bodies that bounced off the lower and upper walls
+std::pair<Mask, Mask> Bounce(__m256 &position, __m256 &speed, const __m256 deltaTime, const __m256 bounds)
+{
+	const auto radius = _mm256_set1_ps(BODY_RADIUS);
+	const auto zero = _mm256_setzero_ps();
+
+	position = _mm256_add_ps(position, _mm256_mul_ps(speed, deltaTime));
+	const auto lower = _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(position, radius), zero, _CMP_LT_OQ),
+	                                 _mm256_cmp_ps(speed, zero, _CMP_LT_OQ));
+	const auto upper = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(position, radius), bounds, _CMP_GT_OQ),
+	                                 _mm256_cmp_ps(speed, zero, _CMP_GT_OQ));
+
+	// Flip the sign of the speed of every body that bounced
+	const auto sign = _mm256_set1_ps(-0.f);
+	speed = _mm256_xor_ps(speed, _mm256_and_ps(_mm256_or_ps(lower, upper), sign));
+
+	return {static_cast<Mask>(_mm256_movemask_ps(lower)), static_cast<Mask>(_mm256_movemask_ps(upper))};
+}
+
+/// @returns Index of the first body of the register starting at `i`, in every lane
+__m256i Indices(const size_t i)
+{
+	return _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+using Floats = __m256;
+Floats Load(const float *from) { return _mm256_loadu_ps(from); }
+void Store(float *to, const Floats from) { _mm256_storeu_ps(to, from); }
+Floats Broadcast(const float value) { return _mm256_set1_ps(value); }
+#endif
+} // namespace
+
+void UpdateRecordingBounces(const float deltaTime, const float width, const float height, float *__restrict__ bodiesX,
+                            float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+                            float *__restrict__ bodiesVerticalSpeed, const size_t begin, const size_t end,
+                            BounceBuffer &buffer)
+{
+	assert(begin <= end && end <= std::numeric_limits<uint32_t>::max());
+	auto i = begin;
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+	const auto delta = Broadcast(deltaTime);
+	const auto widths = Broadcast(width), heights = Broadcast(height);
+
+	for (; i + LANES <= end; i += LANES)
+	{
+		auto x = Load(bodiesX + i), y = Load(bodiesY + i);
+		auto horizontalSpeed = Load(bodiesHorizontalSpeed + i), verticalSpeed = Load(bodiesVerticalSpeed + i);
+
+		const auto [left, right] = Bounce(x, horizontalSpeed, delta, widths);
+		const auto [top, bottom] = Bounce(y, verticalSpeed, delta, heights);
+
+		Store(bodiesX + i, x);
+		Store(bodiesY + i, y);
+		Store(bodiesHorizontalSpeed + i, horizontalSpeed);
+		Store(bodiesVerticalSpeed + i, verticalSpeed);
+
+		// Most registers have no bounces at all, so they skip compaction entirely
+		if (!(left | right | top | bottom))
+			continue;
+
+		// A body bounces off at most one wall per axis, so at most two registers of events are kept, and the last
+		// write can go a whole register past them
+		auto *out = buffer.Reserve(3 * LANES);
+		const auto indices = Indices(i);
+		size_t written = 0;
+		written += Compact(indices, left, Wall::Left, out + written);
+		written += Compact(indices, right, Wall::Right, out + written);
+		written += Compact(indices, top, Wall::Top, out + written);
+		written += Compact(indices, bottom, Wall::Bottom, out + written);
+		buffer.Commit(written);
+	}
+#endif
+
+	UpdateRecordingBouncesScalar(deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+	                             i, end, buffer);
+}
+} // namespace kinematics
@@ -0,0 +1,212 @@
+#include "DensityRasterizer.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <fstream>
+#include <omp.h>
+
+namespace kinematics
+{
+namespace
+{
+// Opacity of a pixel covered by a given number of bodies, growing with the log of the count until fully opaque
+constexpr uint32_t MAX_ALPHA_COUNT = 16;
+constexpr std::array<unsigned char, MAX_ALPHA_COUNT + 1> ALPHA_BY_COUNT = {
+	0, 128, 160, 178, 192, 202, 210, 217, 224, 229, 234, 238, 242, 246, 249, 253, 255};
+} // namespace
+
+DensityRasterizer::DensityRasterizer(const int width, const int height)
+	: _width(0), _height(0), _tileRows(1), _numTiles(0)
+{
+	Resize(width, height);
+}
+
+void DensityRasterizer::Resize(const int width, const int height)
+{
+	assert(width >= 0 && height >= 0);
+	_width = width;
+	_height = height;
+	_tileRows = std::max(MIN_TILE_ROWS, (height + MAX_TILES - 1) / MAX_TILES);
+	_numTiles = (height + _tileRows - 1) / _tileRows;
+	_pixels.assign(static_cast<size_t>(width) * static_cast<size_t>(height), BLANK);
+}
+
+void DensityRasterizer::Rasterize(const BodyFrame &frame)
+{
+	assert(frame.x.size() == frame.y.size() && frame.x.size() == frame.color.size());
+	Rasterize(frame.x.data(), frame.y.data(), frame.color.data(), frame.x.size());
+}
+
+void DensityRasterizer::Rasterize(const float *__restrict__ x, const float *__restrict__ y,
+                                  const Color *__restrict__ color, const size_t numBodies)
+{
+	KINEMATICS_TRACE_SCOPE("DensityRasterizer::Rasterize");
+
+	const auto width = static_cast<uint32_t>(_width);
+	const auto numTiles = static_cast<size_t>(_numTiles);
+	const auto tileRows = static_cast<uint32_t>(_tileRows);
+	const auto tilePixels = static_cast<size_t>(tileRows) * width;
+	const float maxX = static_cast<float>(_width), maxY = static_cast<float>(_height);
+	const float inverseTileRows = 1.f / static_cast<float>(tileRows);
+
+	// Bodies are handled in small blocks so the tile and pixel of each can be found with vector instructions, leaving
+	// only the actual counting and scattering to scalar code
+	constexpr size_t BLOCK_SIZE = 256;
+	const auto discardTile = static_cast<uint32_t>(numTiles);
+	const auto findTiles = [&](const size_t start, const size_t count, uint32_t *__restrict__ tiles) {
+		for (size_t i = 0; i < count; i++)
+		{
+			const float bodyX = x[start + i], bodyY = y[start + i];
+			// Written without branches, or conversions that only happen on one side of a branch, so it vectorizes
+			const bool inside = (bodyX >= 0) & (bodyX < maxX) & (bodyY >= 0) & (bodyY < maxY);
+			const uint32_t insideMask = 0u - static_cast<uint32_t>(inside);
+
+			// Dividing the middle of the row, rather than its top, keeps float rounding from moving it to another tile
+			const auto row = static_cast<float>(static_cast<uint32_t>(std::min(std::max(0.f, bodyY), maxY)));
+			const auto tile = static_cast<uint32_t>((row + 0.5f) * inverseTileRows);
+			tiles[i] = (tile & insideMask) | (discardTile & ~insideMask);
+		}
+	};
+
+	const auto maxThreads = static_cast<size_t>(omp_get_max_threads());
+	if (_tileOffsets.size() < maxThreads)
+		_tileOffsets.resize(maxThreads);
+
+#pragma omp parallel
+	{
+		const auto thread = static_cast<size_t>(omp_get_thread_num());
+		const auto numThreads = static_cast<size_t>(omp_get_num_threads());
+		const size_t begin = numBodies * thread / numThreads, end = numBodies * (thread + 1) / numThreads;
+
+		// Count how many of this thread's bodies land in each tile
+		auto &offsets = _tileOffsets[thread];
+		offsets.assign(numTiles + 1, 0);
+
+		alignas(64) uint32_t tiles[BLOCK_SIZE];
+		alignas(64) uint32_t pixels[BLOCK_SIZE];
+		for (size_t start = begin; start < end; start += BLOCK_SIZE)
+		{
+			const size_t count = std::min(BLOCK_SIZE, end - start);
+			findTiles(start, count, tiles);
+			for (size_t i = 0; i < count; i++)
+				offsets[tiles[i]]++;
+		}
+
+#pragma omp barrier
+#pragma omp single
+		{
+			// Turn the counts into where each thread starts writing into each tile. Threads are ordered within a tile
+			// so the result doesn't depend on timing.
+			size_t total = 0;
+			for (size_t tile = 0; tile < numTiles; tile++)
+			{
+				for (size_t other = 0; other < numThreads; other++)
+				{
+					const auto tileCount = _tileOffsets[other][tile];
+					_tileOffsets[other][tile] = total;
+					total += tileCount;
+				}
+			}
+			_splats.resize(total);
+		}
+
+		// Bin each body into its tile, again in the same order as they were counted
+		for (size_t start = begin; start < end; start += BLOCK_SIZE)
+		{
+			const size_t count = std::min(BLOCK_SIZE, end - start);
+			findTiles(start, count, tiles);
+			for (size_t i = 0; i < count; i++)
+			{
+				const bool inside = tiles[i] != discardTile;
+				const auto pixelX = static_cast<uint32_t>(inside ? x[start + i] : 0);
+				const auto pixelY = static_cast<uint32_t>(inside ? y[start + i] : 0) - tiles[i] * tileRows;
+				pixels[i] = pixelY * width + pixelX;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				if (tiles[i] != discardTile)
+					_splats[offsets[tiles[i]]++] = {pixels[i], color[start + i]};
+			}
+		}
+
+#pragma omp barrier
+
+		// After binning the last thread's offsets mark where each tile ends
+		const auto &tileEnds = _tileOffsets[numThreads - 1];
+		std::vector<Accumulator> accumulators(tilePixels);
+
+#pragma omp for schedule(dynamic)
+		for (size_t tile = 0; tile < numTiles; tile++)
+		{
+			const size_t tileBegin = tile ? tileEnds[tile - 1] : 0;
+			const size_t firstPixel = tile * tilePixels;
+			const size_t numPixels = std::min(tilePixels, _pixels.size() - firstPixel);
+
+			std::fill_n(accumulators.begin(), numPixels, Accumulator{});
+			for (size_t i = tileBegin; i < tileEnds[tile]; i++)
+			{
+				const auto &splat = _splats[i];
+				auto &accumulator = accumulators[splat.pixel];
+				accumulator.r += splat.color.r;
+				accumulator.g += splat.color.g;
+				accumulator.b += splat.color.b;
+				accumulator.count++;
+			}
+
+			// Average the color of each pixel, and make it more opaque as more bodies overlap. Empty pixels end up
+			// fully transparent without needing a branch.
+			Color *__restrict__ out = _pixels.data() + firstPixel;
+			for (size_t i = 0; i < numPixels; i++)
+			{
+				const auto &accumulator = accumulators[i];
+				const float scale = 1.f / static_cast<float>(std::max(accumulator.count, 1u));
+				out[i] = {static_cast<unsigned char>(static_cast<float>(accumulator.r) * scale),
+				          static_cast<unsigned char>(static_cast<float>(accumulator.g) * scale),
+				          static_cast<unsigned char>(static_cast<float>(accumulator.b) * scale),
+				          ALPHA_BY_COUNT[std::min(accumulator.count, MAX_ALPHA_COUNT)]};
+			}
+		}
+	}
+}
+
+std::span<const Color> DensityRasterizer::GetPixels() const { return _pixels; }
+
+int DensityRasterizer::GetWidth() const { return _width; }
+
+int DensityRasterizer::GetHeight() const { return _height; }
+
+bool DensityRasterizer::WritePpm(const std::string &fileName) const
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+		return false;
+
+	file << "P6\n" << _width << ' ' << _height << "\n255\n";
+
+	// PPM has no alpha, so pixels are blended onto black
+	std::vector<unsigned char> rgb;
+	rgb.reserve(_pixels.size() * 3);
+	for (const auto &pixel : _pixels)
+	{
+		rgb.push_back(static_cast<unsigned char>(pixel.r * pixel.a / 255));
+		rgb.push_back(static_cast<unsigned char>(pixel.g * pixel.a / 255));
+		rgb.push_back(static_cast<unsigned char>(pixel.b * pixel.a / 255));
+	}
+	file.write(reinterpret_cast<const char *>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+
+	return static_cast<bool>(file);
+}
+
+bool DensityRasterizer::WritePng(const std::string &fileName) const
+{
+	// `ExportImage` only reads the data, and doesn't need a window
+	const Image image{.data = const_cast<Color *>(_pixels.data()),
+	                  .width = _width,
+	                  .height = _height,
+	                  .mipmaps = 1,
+	                  .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+	return ExportImage(image, fileName.c_str());
+}
+} // namespace kinematics
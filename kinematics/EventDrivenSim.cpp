@@ -0,0 +1,324 @@
+#include "EventDrivenSim.h"
+#include "BounceEvents.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <raylib.h>
+
+namespace kinematics
+{
+namespace
+{
+/// @returns Seconds until a body at `position` moving at `speed` is past the wall it's heading for, which is when
+/// `Simulation::BounceCheck` would bounce it, or infinity if it's not moving
+double GetSecondsToWall(const float position, const float speed, const float bounds)
+{
+	if (speed < 0)
+		return std::max(0., static_cast<double>(position - BODY_RADIUS) / static_cast<double>(-speed));
+	if (speed > 0)
+		return std::max(0., static_cast<double>(bounds - BODY_RADIUS - position) / static_cast<double>(speed));
+	return std::numeric_limits<double>::infinity();
+}
+} // namespace
+
+EventDrivenSim::EventDrivenSim(const float width, const float height, const size_t numBodies)
+	: Simulation(width, height)
+{
+	// Add an initial `numBodies` bodies to the simulation
+	SetNumBodies(numBodies);
+}
+
+EventDrivenSim::EventDrivenSim(const float width, const float height, const Simulation &toCopy)
+	: Simulation(width, height)
+{
+	const auto totalNumBodies = toCopy.GetNumBodies();
+	_bodies.x.reserve(totalNumBodies);
+	_bodies.y.reserve(totalNumBodies);
+	_bodies.horizontalSpeed.reserve(totalNumBodies);
+	_bodies.verticalSpeed.reserve(totalNumBodies);
+	_bodies.time.reserve(totalNumBodies);
+	_bodies.color.reserve(totalNumBodies);
+
+	AddBodies(toCopy.GetBodies());
+}
+
+std::vector<Body> EventDrivenSim::GetBodies() const
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::GetBodies");
+
+	const auto numBodies = GetNumBodies();
+	std::vector<float> x(numBodies), y(numBodies);
+	FindPositions(x.data(), y.data());
+
+	std::vector<Body> copy;
+	copy.reserve(numBodies);
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		copy.emplace_back(x[i], y[i], _bodies.horizontalSpeed[i], _bodies.verticalSpeed[i], _bodies.color[i]);
+	}
+
+	return copy;
+}
+
+void EventDrivenSim::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.resize(numBodies);
+	frame.y.resize(numBodies);
+	FindPositions(frame.x.data(), frame.y.data());
+	frame.color.assign(_bodies.color.data(), _bodies.color.data() + numBodies);
+	frame.radius.clear();
+}
+
+void EventDrivenSim::FindPositions(float *__restrict__ x, float *__restrict__ y) const
+{
+	const float *__restrict__ bodiesX = _bodies.x.data();
+	const float *__restrict__ bodiesY = _bodies.y.data();
+	const float *__restrict__ bodiesHorizontalSpeed = _bodies.horizontalSpeed.data();
+	const float *__restrict__ bodiesVerticalSpeed = _bodies.verticalSpeed.data();
+	const float *__restrict__ bodiesTime = _bodies.time.data();
+	const auto elapsed = static_cast<float>(_now - _epoch);
+
+	const auto numBodies = GetNumBodies();
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		const auto age = elapsed - bodiesTime[i];
+		x[i] = bodiesX[i] + bodiesHorizontalSpeed[i] * age;
+		y[i] = bodiesY[i] + bodiesVerticalSpeed[i] * age;
+	}
+}
+
+void EventDrivenSim::Rebase()
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::Rebase");
+
+	// Event times are in seconds since creation rather than since `_epoch`, so the wheel stays as it is. Positions are
+	// moved in place, which `FindPositions` can't do as its outputs mustn't alias the bodies it reads.
+	float *__restrict__ bodiesX = _bodies.x.data();
+	float *__restrict__ bodiesY = _bodies.y.data();
+	const float *__restrict__ bodiesHorizontalSpeed = _bodies.horizontalSpeed.data();
+	const float *__restrict__ bodiesVerticalSpeed = _bodies.verticalSpeed.data();
+	float *__restrict__ bodiesTime = _bodies.time.data();
+	const auto elapsed = static_cast<float>(_now - _epoch);
+
+	const auto numBodies = GetNumBodies();
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		const auto age = elapsed - bodiesTime[i];
+		bodiesX[i] += bodiesHorizontalSpeed[i] * age;
+		bodiesY[i] += bodiesVerticalSpeed[i] * age;
+		bodiesTime[i] = 0;
+	}
+	_epoch = _now;
+}
+
+uint64_t EventDrivenSim::GetTick(const double time)
+{
+	// Bodies that barely move bounce so far away that the tick wouldn't fit, so are parked at a tick that's never
+	// reached instead. They're still in a slot, and bounce whenever the wheel comes round to them at their time.
+	constexpr double LAST_TICK = 1e15;
+	return static_cast<uint64_t>(std::min(time / SLOT_SECONDS, LAST_TICK));
+}
+
+void EventDrivenSim::Schedule(const uint32_t body)
+{
+	const auto seconds = std::min(GetSecondsToWall(_bodies.x[body], _bodies.horizontalSpeed[body], _width),
+	                              GetSecondsToWall(_bodies.y[body], _bodies.verticalSpeed[body], _height));
+	if (seconds == std::numeric_limits<double>::infinity())
+		return;
+
+	// Bounces due before the next step are put in the slot it starts from, which it visits again
+	const auto time = _epoch + static_cast<double>(_bodies.time[body]) + seconds;
+	const auto tick = std::max(GetTick(time), _tick);
+	_wheel[tick % NUM_SLOTS].push_back({time, body});
+}
+
+void EventDrivenSim::ScheduleAll()
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::ScheduleAll");
+
+	_wheel.resize(NUM_SLOTS);
+	for (auto &slot : _wheel)
+		slot.clear();
+
+	_tick = GetTick(_now);
+	const auto numBodies = static_cast<uint32_t>(GetNumBodies());
+	for (uint32_t i = 0; i < numBodies; i++)
+		Schedule(i);
+	_isScheduled = true;
+}
+
+void EventDrivenSim::Sweep(const float deltaTime)
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::Sweep");
+
+	// With every position stored as of the present, the stored positions are a Structure of Arrays like any other
+	Rebase();
+	UpdateHelper(deltaTime, _bodies.x.data(), _bodies.y.data(), _bodies.horizontalSpeed.data(),
+	             _bodies.verticalSpeed.data());
+	_now += static_cast<double>(deltaTime);
+	_epoch = _now;
+
+	_isScheduled = false;
+	_numVisited = GetNumBodies();
+}
+
+void EventDrivenSim::Update(const float deltaTime)
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::Update");
+
+	if (_forces || _obstacles)
+	{
+		Sweep(deltaTime);
+	}
+	else
+	{
+		if (!_isScheduled)
+			ScheduleAll();
+		_now += static_cast<double>(deltaTime);
+
+		// Visit every slot the step covers once, starting from the last visited as it may have bounces later than the
+		// previous step. Bounces in a slot that aren't due yet are further round the wheel, or later in the slot.
+		const auto tick = GetTick(_now);
+		const auto lastTick = std::min(tick, _tick + NUM_SLOTS - 1);
+		_due.clear();
+		for (auto visit = _tick; visit <= lastTick; visit++)
+		{
+			std::erase_if(_wheel[visit % NUM_SLOTS], [&](const Event &event) {
+				if (event.time > _now)
+					return false;
+				_due.push_back(event.body);
+				return true;
+			});
+		}
+		_tick = tick;
+
+		// In order of body, for the bounce events and so bodies next to each other in memory are visited together
+		std::ranges::sort(_due);
+		if (_bounceEvents)
+			_bounceEvents->BeginStep(1);
+
+		const auto elapsed = static_cast<float>(_now - _epoch);
+		for (const auto body : _due)
+		{
+			// Moved to the end of the step and bounced as `UpdateHelper` would, then stored from there. A body that's
+			// due but not quite past the wall, from rounding, is simply scheduled again for the next step.
+			auto &horizontalSpeed = _bodies.horizontalSpeed[body], &verticalSpeed = _bodies.verticalSpeed[body];
+			const auto age = elapsed - _bodies.time[body];
+			const auto x = _bodies.x[body] + horizontalSpeed * age;
+			const auto y = _bodies.y[body] + verticalSpeed * age;
+
+			if (BounceCheck(x, horizontalSpeed, _width))
+			{
+				if (_bounceEvents)
+					_bounceEvents->GetBuffer(0).Add({body, horizontalSpeed < 0 ? Wall::Left : Wall::Right});
+				horizontalSpeed *= -1;
+			}
+
+			if (BounceCheck(y, verticalSpeed, _height))
+			{
+				if (_bounceEvents)
+					_bounceEvents->GetBuffer(0).Add({body, verticalSpeed < 0 ? Wall::Top : Wall::Bottom});
+				verticalSpeed *= -1;
+			}
+
+			_bodies.x[body] = x;
+			_bodies.y[body] = y;
+			_bodies.time[body] = elapsed;
+			Schedule(body);
+		}
+		_numVisited = _due.size();
+
+		if (_now - _epoch >= REBASE_SECONDS)
+			Rebase();
+	}
+
+	if (_spatialIndex)
+	{
+		_presentX.resize(GetNumBodies());
+		_presentY.resize(GetNumBodies());
+		FindPositions(_presentX.data(), _presentY.data());
+		UpdateSpatialIndex(_presentX.data(), _presentY.data());
+	}
+}
+
+void EventDrivenSim::Draw() const
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::Draw");
+
+	// `Draw()` should not be called when a window is not available
+	assert(IsWindowReady());
+
+	_presentX.resize(GetNumBodies());
+	_presentY.resize(GetNumBodies());
+	FindPositions(_presentX.data(), _presentY.data());
+	GetRenderer().Draw(_presentX.data(), _presentY.data(), _bodies.color.data(), GetNumBodies());
+}
+
+void EventDrivenSim::SetNumBodies(const size_t totalNumBodies)
+{
+	KINEMATICS_TRACE_SCOPE("EventDrivenSim::SetNumBodies");
+
+	if (totalNumBodies > GetNumBodies())
+	{
+		_bodies.x.reserve(totalNumBodies);
+		_bodies.y.reserve(totalNumBodies);
+		_bodies.horizontalSpeed.reserve(totalNumBodies);
+		_bodies.verticalSpeed.reserve(totalNumBodies);
+		_bodies.time.reserve(totalNumBodies);
+		_bodies.color.reserve(totalNumBodies);
+
+		AddRandomBodies(totalNumBodies - GetNumBodies());
+	}
+	else
+	{
+		_bodies.x.resize(totalNumBodies);
+		_bodies.y.resize(totalNumBodies);
+		_bodies.horizontalSpeed.resize(totalNumBodies);
+		_bodies.verticalSpeed.resize(totalNumBodies);
+		_bodies.time.resize(totalNumBodies);
+		_bodies.color.resize(totalNumBodies);
+
+		// Removed bodies still have bounces in the wheel, which would be duplicates once their indices are reused
+		_isScheduled = false;
+	}
+
+	RebuildSpatialIndex();
+}
+
+void EventDrivenSim::SetBounds(const float width, const float height)
+{
+	Simulation::SetBounds(width, height);
+
+	// Every body's distance to the walls changed
+	_isScheduled = false;
+}
+
+size_t EventDrivenSim::GetNumBodies() const { return _bodies.x.size(); }
+
+size_t EventDrivenSim::GetNumVisited() const { return _numVisited; }
+
+void EventDrivenSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+                                  const Color *__restrict__ color, const size_t numBodies)
+{
+	const auto first = static_cast<uint32_t>(GetNumBodies());
+	_bodies.x.insert(_bodies.x.end(), x, x + numBodies);
+	_bodies.y.insert(_bodies.y.end(), y, y + numBodies);
+
+	_bodies.horizontalSpeed.insert(_bodies.horizontalSpeed.end(), horizontalSpeed, horizontalSpeed + numBodies);
+	_bodies.verticalSpeed.insert(_bodies.verticalSpeed.end(), verticalSpeed, verticalSpeed + numBodies);
+	_bodies.time.insert(_bodies.time.end(), numBodies, static_cast<float>(_now - _epoch));
+
+	_bodies.color.insert(_bodies.color.end(), color, color + numBodies);
+
+	if (_isScheduled)
+	{
+		const auto numBodiesNow = static_cast<uint32_t>(GetNumBodies());
+		for (auto body = first; body < numBodiesNow; body++)
+			Schedule(body);
+	}
+}
+} // namespace kinematics
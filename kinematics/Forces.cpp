@@ -0,0 +1,217 @@
+#include "Forces.h"
+#include "kinematics.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace kinematics
+{
+namespace
+{
+/// Radius of every body, for layouts without a radius per body
+struct UniformRadius
+{
+	float operator[](const size_t) const { return BODY_RADIUS; }
+};
+
+/// Everything of `Forces` that accelerates bodies, copied out so loops don't reload it after each store to a velocity
+struct Accelerations
+{
+	float gravityX, gravityY, drag;
+	const float *accelerationX, *accelerationY;
+	const RadialField *fields;
+	size_t numFields;
+
+	explicit Accelerations(const Forces &forces)
+		: gravityX(forces.gravity.x), gravityY(forces.gravity.y), drag(forces.drag),
+		  accelerationX(forces.accelerationX), accelerationY(forces.accelerationY), fields(forces.fields.data()),
+		  numFields(forces.fields.size())
+	{
+	}
+};
+
+/// @returns What to scale the offset `dx`, `dy` from a body to the center of a field by for the body's acceleration
+inline float GetFieldScale(const float dx, const float dy, const float strength, const float range)
+{
+	const auto distance = std::sqrt(dx * dx + dy * dy);
+
+	// Linear falloff, and nothing at the very center where there's no direction to accelerate in. Both sides are
+	// computed for every body when vectorized, so the division by zero at the center is never used.
+	const bool inRange = (distance < range) & (distance > 0);
+	return inRange ? strength * (1 - distance / range) / distance : 0.f;
+}
+
+// Bodies are taken a block at a time, small enough that a block stays in L1 between the loops over it. Memory is
+// then only streamed through once per step however many fields there are, while each loop is simple enough to
+// vectorize, which a loop over fields inside the loop over bodies isn't.
+constexpr size_t BLOCK_SIZE = 256;
+using Block = std::array<float, BLOCK_SIZE>;
+
+/// Find the acceleration of bodies `[begin, end)`, at most a block of them, into `horizontal` and `vertical`
+template <bool PER_BODY_ACCELERATION>
+void FindAccelerations(const Accelerations &forces, const float *__restrict__ bodiesX,
+                       const float *__restrict__ bodiesY, const float *__restrict__ bodiesHorizontalSpeed,
+                       const float *__restrict__ bodiesVerticalSpeed, const size_t begin, const size_t end,
+                       Block &horizontal, Block &vertical)
+{
+	const auto gravityX = forces.gravityX, gravityY = forces.gravityY, drag = forces.drag;
+	for (auto i = begin; i < end; i++)
+	{
+		horizontal[i - begin] = gravityX - drag * bodiesHorizontalSpeed[i];
+		vertical[i - begin] = gravityY - drag * bodiesVerticalSpeed[i];
+		if constexpr (PER_BODY_ACCELERATION)
+		{
+			horizontal[i - begin] += forces.accelerationX[i];
+			vertical[i - begin] += forces.accelerationY[i];
+		}
+	}
+
+	for (size_t field = 0; field < forces.numFields; field++)
+	{
+		const auto [fieldX, fieldY, strength, range] = forces.fields[field];
+		for (auto i = begin; i < end; i++)
+		{
+			const auto dx = fieldX - bodiesX[i], dy = fieldY - bodiesY[i];
+			const auto scale = GetFieldScale(dx, dy, strength, range);
+			horizontal[i - begin] += dx * scale;
+			vertical[i - begin] += dy * scale;
+		}
+	}
+}
+
+template <bool PER_BODY_ACCELERATION>
+void Accelerate(const Accelerations &forces, const float deltaTime, const float *__restrict__ bodiesX,
+                const float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+                float *__restrict__ bodiesVerticalSpeed, const size_t begin, const size_t end)
+{
+	Block horizontal, vertical;
+	for (auto block = begin; block < end; block += BLOCK_SIZE)
+	{
+		const auto blockEnd = std::min(end, block + BLOCK_SIZE);
+		FindAccelerations<PER_BODY_ACCELERATION>(forces, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+		                                         block, blockEnd, horizontal, vertical);
+		for (auto i = block; i < blockEnd; i++)
+		{
+			bodiesHorizontalSpeed[i] += horizontal[i - block] * deltaTime;
+			bodiesVerticalSpeed[i] += vertical[i - block] * deltaTime;
+		}
+	}
+}
+
+template <bool PER_BODY_ACCELERATION, typename Radii>
+void Update(const Accelerations &forces, const float deltaTime, const float width, const float height,
+            float *__restrict__ bodiesX, float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+            float *__restrict__ bodiesVerticalSpeed, const Radii bodiesRadius, const size_t begin, const size_t end)
+{
+	Block horizontal, vertical;
+	for (auto block = begin; block < end; block += BLOCK_SIZE)
+	{
+		const auto blockEnd = std::min(end, block + BLOCK_SIZE);
+		FindAccelerations<PER_BODY_ACCELERATION>(forces, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+		                                         block, blockEnd, horizontal, vertical);
+
+		for (auto i = block; i < blockEnd; i++)
+		{
+			// Update speed based on acceleration, then position based on the new speed
+			bodiesHorizontalSpeed[i] += horizontal[i - block] * deltaTime;
+			bodiesVerticalSpeed[i] += vertical[i - block] * deltaTime;
+			bodiesX[i] += bodiesHorizontalSpeed[i] * deltaTime;
+			bodiesY[i] += bodiesVerticalSpeed[i] * deltaTime;
+
+			// Bounce horizontally
+			const float radius = bodiesRadius[i];
+			if ((bodiesX[i] - radius < 0 && bodiesHorizontalSpeed[i] < 0) ||
+			    (bodiesX[i] + radius > width && bodiesHorizontalSpeed[i] > 0))
+			{
+				bodiesHorizontalSpeed[i] *= -1;
+			}
+
+			// Bounce vertically
+			if ((bodiesY[i] - radius < 0 && bodiesVerticalSpeed[i] < 0) ||
+			    (bodiesY[i] + radius > height && bodiesVerticalSpeed[i] > 0))
+			{
+				bodiesVerticalSpeed[i] *= -1;
+			}
+		}
+	}
+}
+
+/// Pick the loop for whether bodies have their own acceleration, so the other doesn't load it at all
+template <typename Radii>
+void Update(const Forces &forces, const float deltaTime, const float width, const float height,
+            float *__restrict__ bodiesX, float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+            float *__restrict__ bodiesVerticalSpeed, const Radii bodiesRadius, const size_t begin, const size_t end)
+{
+	const Accelerations accelerations(forces);
+	if (accelerations.accelerationX)
+		Update<true>(accelerations, deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+		             bodiesVerticalSpeed, bodiesRadius, begin, end);
+	else
+		Update<false>(accelerations, deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+		              bodiesVerticalSpeed, bodiesRadius, begin, end);
+}
+} // namespace
+
+void UpdateApplyingForces(const Forces &forces, const float deltaTime, const float width, const float height,
+                          float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                          const size_t begin, const size_t end)
+{
+	Update(forces, deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+	       UniformRadius(), begin, end);
+}
+
+void UpdateApplyingForces(const Forces &forces, const float deltaTime, const float width, const float height,
+                          float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                          const float *__restrict__ bodiesRadius, const size_t begin, const size_t end)
+{
+	Update(forces, deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+	       bodiesRadius, begin, end);
+}
+
+void UpdateApplyingForces(const Forces &forces, const float deltaTime, const float width, const float height,
+                          float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                          const uint8_t *__restrict__ bodiesRadius, const size_t begin, const size_t end)
+{
+	Update(forces, deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+	       bodiesRadius, begin, end);
+}
+
+void Accelerate(const Forces &forces, const float deltaTime, const float *__restrict__ bodiesX,
+                const float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+                float *__restrict__ bodiesVerticalSpeed, const size_t begin, const size_t end)
+{
+	const Accelerations accelerations(forces);
+	if (accelerations.accelerationX)
+		Accelerate<true>(accelerations, deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, begin,
+		                 end);
+	else
+		Accelerate<false>(accelerations, deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed,
+		                  begin, end);
+}
+
+void Accelerate(const Forces &forces, const float deltaTime, const float x, const float y, float &horizontalSpeed,
+                float &verticalSpeed, const size_t body)
+{
+	auto horizontalAcceleration = forces.gravity.x - forces.drag * horizontalSpeed;
+	auto verticalAcceleration = forces.gravity.y - forces.drag * verticalSpeed;
+	if (forces.accelerationX)
+	{
+		horizontalAcceleration += forces.accelerationX[body];
+		verticalAcceleration += forces.accelerationY[body];
+	}
+
+	for (const auto &field : forces.fields)
+	{
+		const auto dx = field.x - x, dy = field.y - y;
+		const auto scale = GetFieldScale(dx, dy, field.strength, field.range);
+		horizontalAcceleration += dx * scale;
+		verticalAcceleration += dy * scale;
+	}
+
+	horizontalSpeed += horizontalAcceleration * deltaTime;
+	verticalSpeed += verticalAcceleration * deltaTime;
+}
+} // namespace kinematics
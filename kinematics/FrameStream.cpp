@@ -0,0 +1,620 @@
+#include "FrameStream.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace kinematics
+{
+namespace
+{
+// All messages are a header followed by `size` bytes of payload. Values are sent in host byte order.
+enum class MessageType : uint32_t
+{
+	Subscribe = 1, // Rectangle viewport
+	Keyframe = 2,  // uint32 frameIndex, uint32 count, StreamedBody[count]
+	Delta = 3,     // uint32 frameIndex, uint32 numRemoved, uint32 numAdded, uint32 numMoved, uint32 removed[],
+	               // StreamedBody added[], int8 (dx, dy)[numMoved] for every retained body in index order
+};
+
+struct MessageHeader
+{
+	uint32_t type;
+	uint32_t size;
+};
+
+static_assert(sizeof(StreamedBody) == 12, "StreamedBody is sent as-is and should not contain padding");
+
+constexpr size_t RECEIVE_CHUNK_SIZE = 64 * 1024;
+
+template <typename T> void Append(std::vector<std::byte> &buffer, const T &value)
+{
+	const auto offset = buffer.size();
+	buffer.resize(offset + sizeof(T));
+	std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template <typename T> void Append(std::vector<std::byte> &buffer, const std::vector<T> &values)
+{
+	const auto offset = buffer.size();
+	buffer.resize(offset + sizeof(T) * values.size());
+	std::memcpy(buffer.data() + offset, values.data(), sizeof(T) * values.size());
+}
+
+/// Consume a `T` from the front of `payload`, which must be large enough
+template <typename T> T Read(std::span<const std::byte> &payload)
+{
+	T value;
+	std::memcpy(&value, payload.data(), sizeof(T));
+	payload = payload.subspan(sizeof(T));
+	return value;
+}
+
+/// Consume `count` `T`s from the front of `payload`, which must be large enough
+template <typename T> void Read(std::span<const std::byte> &payload, std::vector<T> &values, const size_t count)
+{
+	values.resize(count);
+	std::memcpy(values.data(), payload.data(), sizeof(T) * count);
+	payload = payload.subspan(sizeof(T) * count);
+}
+
+/// Start a message in `buffer`
+/// @returns Offset of the header to pass to `EndMessage`
+size_t BeginMessage(std::vector<std::byte> &buffer)
+{
+	const auto offset = buffer.size();
+	Append(buffer, MessageHeader{});
+	return offset;
+}
+
+/// Fill in the header of a message that was started with `BeginMessage`
+void EndMessage(std::vector<std::byte> &buffer, const size_t headerOffset, const MessageType type)
+{
+	const MessageHeader header{.type = static_cast<uint32_t>(type),
+	                           .size = static_cast<uint32_t>(buffer.size() - headerOffset - sizeof(MessageHeader))};
+	std::memcpy(buffer.data() + headerOffset, &header, sizeof(MessageHeader));
+}
+
+/// Calls `handler(type, payload)` for every complete message at the front of `buffer` then removes them
+/// @param maxPayloadSize Largest payload expected, beyond which a message fails as soon as its header arrives rather
+/// than waiting for the rest of it
+template <typename Handler>
+bool ConsumeMessages(std::vector<std::byte> &buffer, Handler &&handler, const size_t maxPayloadSize = UINT32_MAX)
+{
+	size_t offset = 0;
+	bool ok = true;
+	while (ok && buffer.size() - offset >= sizeof(MessageHeader))
+	{
+		MessageHeader header;
+		std::memcpy(&header, buffer.data() + offset, sizeof(MessageHeader));
+		if (header.size > maxPayloadSize)
+		{
+			ok = false;
+			break;
+		}
+		if (buffer.size() - offset - sizeof(MessageHeader) < header.size)
+			break;
+
+		ok = handler(header.type, std::span<const std::byte>(buffer).subspan(offset + sizeof(MessageHeader), header.size));
+		offset += sizeof(MessageHeader) + header.size;
+	}
+
+	buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+	return ok;
+}
+
+uint16_t Quantize(const float position) { return static_cast<uint16_t>(std::clamp(position, 0.f, 65535.f)); }
+
+bool IsVisible(const StreamedBody &body, const Rectangle &viewport)
+{
+	const auto x = static_cast<float>(body.x);
+	const auto y = static_cast<float>(body.y);
+	return x + BODY_RADIUS >= viewport.x && x - BODY_RADIUS < viewport.x + viewport.width &&
+	       y + BODY_RADIUS >= viewport.y && y - BODY_RADIUS < viewport.y + viewport.height;
+}
+
+[[noreturn]] void ThrowSystemError(const char *what) { throw std::system_error(errno, std::generic_category(), what); }
+
+/// Create a socket for `address` and fill in the matching `sockaddr`
+/// @param flags Additional flags for `socket()`, such as `SOCK_NONBLOCK`
+int OpenSocket(const StreamAddress &address, const int flags, sockaddr_storage &storage, socklen_t &length)
+{
+	storage = {};
+	if (address.kind == StreamAddress::Kind::Tcp)
+	{
+		auto &inet = reinterpret_cast<sockaddr_in &>(storage);
+		inet.sin_family = AF_INET;
+		inet.sin_port = htons(address.port);
+		if (inet_pton(AF_INET, address.host.c_str(), &inet.sin_addr) != 1)
+			throw std::invalid_argument("Invalid IPv4 address: " + address.host);
+		length = sizeof(sockaddr_in);
+	}
+	else
+	{
+		auto &local = reinterpret_cast<sockaddr_un &>(storage);
+		local.sun_family = AF_UNIX;
+		if (address.host.size() >= sizeof(local.sun_path))
+			throw std::invalid_argument("Unix socket path is too long: " + address.host);
+		std::memcpy(local.sun_path, address.host.c_str(), address.host.size() + 1);
+		length = sizeof(sockaddr_un);
+	}
+
+	const int domain = address.kind == StreamAddress::Kind::Tcp ? AF_INET : AF_UNIX;
+	const int fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC | flags, 0);
+	if (fd < 0)
+		ThrowSystemError("socket");
+
+	return fd;
+}
+
+/// Frames are latency sensitive so don't let TCP hold on to small writes
+void DisableNagle(const int fd, const StreamAddress &address)
+{
+	if (address.kind != StreamAddress::Kind::Tcp)
+		return;
+
+	const int enable = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+} // namespace
+
+StreamAddress StreamAddress::Tcp(const std::string &host, const uint16_t port)
+{
+	return StreamAddress{.kind = Kind::Tcp, .host = host, .port = port};
+}
+
+StreamAddress StreamAddress::Unix(const std::string &path)
+{
+	return StreamAddress{.kind = Kind::Unix, .host = path, .port = 0};
+}
+
+FrameServer::FrameServer(const StreamAddress &address, const size_t keyframeInterval, const size_t maxPendingBytes)
+	: _address(address), _listenSocket(-1), _keyframeInterval(keyframeInterval), _maxPendingBytes(maxPendingBytes),
+	  _frameIndex(0)
+{
+	sockaddr_storage storage;
+	socklen_t length;
+	// Never block on `accept()` when there are no new clients
+	_listenSocket = OpenSocket(_address, SOCK_NONBLOCK, storage, length);
+
+	if (_address.kind == StreamAddress::Kind::Tcp)
+	{
+		const int enable = 1;
+		setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+	}
+	else
+	{
+		// Remove a stale socket left behind by a previous server
+		unlink(_address.host.c_str());
+	}
+
+	if (bind(_listenSocket, reinterpret_cast<const sockaddr *>(&storage), length) != 0 ||
+	    listen(_listenSocket, SOMAXCONN) != 0)
+	{
+		const int error = errno;
+		close(_listenSocket);
+		throw std::system_error(error, std::generic_category(), "FrameServer bind/listen");
+	}
+}
+
+FrameServer::~FrameServer()
+{
+	for (auto &client : _clients)
+	{
+		Disconnect(client);
+	}
+
+	close(_listenSocket);
+	if (_address.kind == StreamAddress::Kind::Unix)
+		unlink(_address.host.c_str());
+}
+
+uint16_t FrameServer::GetPort() const
+{
+	if (_address.kind != StreamAddress::Kind::Tcp)
+		return 0;
+
+	sockaddr_in inet{};
+	socklen_t length = sizeof(inet);
+	getsockname(_listenSocket, reinterpret_cast<sockaddr *>(&inet), &length);
+	return ntohs(inet.sin_port);
+}
+
+size_t FrameServer::GetNumSubscribers() const
+{
+	return static_cast<size_t>(std::ranges::count_if(_clients, [](const Client &client) { return client.subscribed; }));
+}
+
+const StreamStats &FrameServer::GetStats() const { return _stats; }
+
+void FrameServer::Publish(std::span<const Body> bodies)
+{
+	// Pick up any new clients or subscription changes before deciding what to send
+	Poll();
+
+	_frameIndex++;
+	_frame.resize(bodies.size());
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		_frame[i] = StreamedBody{.index = static_cast<uint32_t>(i),
+		                         .x = Quantize(bodies[i].x),
+		                         .y = Quantize(bodies[i].y),
+		                         .color = bodies[i].color};
+	}
+
+	for (auto &client : _clients)
+	{
+		if (!client.subscribed)
+			continue;
+
+		// Backpressure: rather than queue without bound, skip this client until it catches up. Deltas rely on the
+		// client having seen every previous frame so it must be resynchronized with a keyframe.
+		if (client.pending.size() - client.pendingOffset > _maxPendingBytes)
+		{
+			client.needsKeyframe = true;
+			_stats.droppedFrames++;
+			continue;
+		}
+
+		Encode(client);
+	}
+
+	Poll();
+}
+
+void FrameServer::Poll()
+{
+	Accept();
+	for (auto &client : _clients)
+	{
+		if (!Receive(client) || !Flush(client))
+			Disconnect(client);
+	}
+
+	std::erase_if(_clients, [](const Client &client) { return client.socket < 0; });
+}
+
+void FrameServer::Accept()
+{
+	int fd;
+	while ((fd = accept4(_listenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		DisableNagle(fd, _address);
+		_clients.emplace_back().socket = fd;
+	}
+}
+
+bool FrameServer::Receive(Client &client)
+{
+	const auto subscribe = [&](const uint32_t type, std::span<const std::byte> payload) {
+		if (type != static_cast<uint32_t>(MessageType::Subscribe) || payload.size() != sizeof(Rectangle))
+			return false;
+
+		client.viewport = Read<Rectangle>(payload);
+		client.subscribed = true;
+		client.needsKeyframe = true;
+		return true;
+	};
+
+	std::byte chunk[4096];
+	while (true)
+	{
+		const auto received = recv(client.socket, chunk, sizeof(chunk), MSG_DONTWAIT);
+		if (received == 0)
+			return false;
+		if (received < 0)
+		{
+			if (errno == EAGAIN)
+				break;
+			return false;
+		}
+
+		// Consumed as each chunk arrives, so a client can't make the server buffer more than one subscription
+		client.received.insert(client.received.end(), chunk, chunk + received);
+		if (!ConsumeMessages(client.received, subscribe, sizeof(Rectangle)))
+			return false;
+	}
+
+	return true;
+}
+
+bool FrameServer::Flush(Client &client)
+{
+	while (client.pendingOffset < client.pending.size())
+	{
+		const auto sent = send(client.socket, client.pending.data() + client.pendingOffset,
+		                       client.pending.size() - client.pendingOffset, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (sent < 0)
+		{
+			if (errno == EAGAIN)
+				break;
+			return false;
+		}
+
+		client.pendingOffset += static_cast<size_t>(sent);
+		_stats.bytes += static_cast<uint64_t>(sent);
+	}
+
+	// Reclaim the sent part of the queue, but only once it's worth moving the remainder
+	if (client.pendingOffset == client.pending.size())
+	{
+		client.pending.clear();
+		client.pendingOffset = 0;
+	}
+	else if (client.pendingOffset > client.pending.size() / 2)
+	{
+		client.pending.erase(client.pending.begin(),
+		                     client.pending.begin() + static_cast<std::ptrdiff_t>(client.pendingOffset));
+		client.pendingOffset = 0;
+	}
+
+	return true;
+}
+
+void FrameServer::Encode(Client &client)
+{
+	_visible.clear();
+	for (const auto &body : _frame)
+	{
+		if (IsVisible(body, client.viewport))
+			_visible.push_back(body);
+	}
+
+	const auto headerOffset = BeginMessage(client.pending);
+	Append(client.pending, _frameIndex);
+
+	if (client.needsKeyframe || client.framesSinceKeyframe + 1 >= _keyframeInterval)
+	{
+		Append(client.pending, static_cast<uint32_t>(_visible.size()));
+		Append(client.pending, _visible);
+		EndMessage(client.pending, headerOffset, MessageType::Keyframe);
+
+		client.needsKeyframe = false;
+		client.framesSinceKeyframe = 0;
+		_stats.keyframes++;
+	}
+	else
+	{
+		// Both lists are sorted by index, so a single merge finds bodies that left, entered or stayed in view
+		_removed.clear();
+		_added.clear();
+		_moves.clear();
+
+		auto previous = client.sent.cbegin();
+		auto current = _visible.cbegin();
+		while (previous != client.sent.cend() || current != _visible.cend())
+		{
+			if (current == _visible.cend() || (previous != client.sent.cend() && previous->index < current->index))
+			{
+				_removed.push_back((previous++)->index);
+			}
+			else if (previous == client.sent.cend() || current->index < previous->index)
+			{
+				_added.push_back(*current++);
+			}
+			else
+			{
+				const int dx = current->x - previous->x;
+				const int dy = current->y - previous->y;
+				if (dx < INT8_MIN || dx > INT8_MAX || dy < INT8_MIN || dy > INT8_MAX)
+				{
+					// Moved too far for a delta, so resend it in full
+					_removed.push_back(previous->index);
+					_added.push_back(*current);
+				}
+				else
+				{
+					_moves.push_back(static_cast<int8_t>(dx));
+					_moves.push_back(static_cast<int8_t>(dy));
+				}
+				previous++;
+				current++;
+			}
+		}
+
+		Append(client.pending, static_cast<uint32_t>(_removed.size()));
+		Append(client.pending, static_cast<uint32_t>(_added.size()));
+		Append(client.pending, static_cast<uint32_t>(_moves.size() / 2));
+		Append(client.pending, _removed);
+		Append(client.pending, _added);
+		Append(client.pending, _moves);
+		EndMessage(client.pending, headerOffset, MessageType::Delta);
+
+		client.framesSinceKeyframe++;
+	}
+
+	client.sent.swap(_visible);
+	_stats.frames++;
+	_stats.bodies += client.sent.size();
+}
+
+void FrameServer::Disconnect(Client &client)
+{
+	if (client.socket >= 0)
+		close(client.socket);
+	client.socket = -1;
+	client.subscribed = false;
+}
+
+FrameClient::FrameClient(const StreamAddress &address, const Rectangle viewport) : _socket(-1), _frameIndex(0)
+{
+	sockaddr_storage storage;
+	socklen_t length;
+	_socket = OpenSocket(address, 0, storage, length);
+
+	if (connect(_socket, reinterpret_cast<const sockaddr *>(&storage), length) != 0)
+	{
+		const int error = errno;
+		close(_socket);
+		throw std::system_error(error, std::generic_category(), "FrameClient connect");
+	}
+
+	DisableNagle(_socket, address);
+	Subscribe(viewport);
+}
+
+FrameClient::~FrameClient()
+{
+	if (_socket >= 0)
+		close(_socket);
+}
+
+void FrameClient::Subscribe(const Rectangle viewport)
+{
+	std::vector<std::byte> message;
+	const auto headerOffset = BeginMessage(message);
+	Append(message, viewport);
+	EndMessage(message, headerOffset, MessageType::Subscribe);
+
+	size_t offset = 0;
+	while (_socket >= 0 && offset < message.size())
+	{
+		const auto sent = send(_socket, message.data() + offset, message.size() - offset, MSG_NOSIGNAL);
+		if (sent < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			close(_socket);
+			_socket = -1;
+			break;
+		}
+		offset += static_cast<size_t>(sent);
+	}
+}
+
+bool FrameClient::Receive(const int timeoutMilliseconds)
+{
+	if (_socket < 0)
+		return false;
+
+	pollfd descriptor{.fd = _socket, .events = POLLIN, .revents = 0};
+	if (poll(&descriptor, 1, timeoutMilliseconds) <= 0)
+		return false;
+
+	while (true)
+	{
+		const auto offset = _received.size();
+		_received.resize(offset + RECEIVE_CHUNK_SIZE);
+		const auto received = recv(_socket, _received.data() + offset, RECEIVE_CHUNK_SIZE, MSG_DONTWAIT);
+		_received.resize(offset + static_cast<size_t>(std::max<ssize_t>(received, 0)));
+
+		if (received > 0)
+		{
+			_stats.bytes += static_cast<uint64_t>(received);
+			continue;
+		}
+
+		if (received < 0 && (errno == EAGAIN))
+			break;
+
+		// Closed or failed, but still apply whatever arrived beforehand
+		close(_socket);
+		_socket = -1;
+		break;
+	}
+
+	bool applied = false;
+	const bool ok = ConsumeMessages(_received, [&](const uint32_t type, std::span<const std::byte> payload) {
+		const bool valid = Apply(type, payload);
+		applied |= valid;
+		return valid;
+	});
+
+	if (!ok && _socket >= 0)
+	{
+		close(_socket);
+		_socket = -1;
+	}
+
+	return applied;
+}
+
+bool FrameClient::Apply(const uint32_t type, std::span<const std::byte> payload)
+{
+	if (type == static_cast<uint32_t>(MessageType::Keyframe))
+	{
+		if (payload.size() < 2 * sizeof(uint32_t))
+			return false;
+
+		const auto frameIndex = Read<uint32_t>(payload);
+		const auto count = Read<uint32_t>(payload);
+		if (payload.size() != count * sizeof(StreamedBody))
+			return false;
+
+		Read(payload, _bodies, count);
+		_frameIndex = frameIndex;
+		_stats.keyframes++;
+	}
+	else if (type == static_cast<uint32_t>(MessageType::Delta))
+	{
+		if (payload.size() < 4 * sizeof(uint32_t))
+			return false;
+
+		const auto frameIndex = Read<uint32_t>(payload);
+		const auto numRemoved = Read<uint32_t>(payload);
+		const auto numAdded = Read<uint32_t>(payload);
+		const auto numMoved = Read<uint32_t>(payload);
+		if (payload.size() != numRemoved * sizeof(uint32_t) + numAdded * sizeof(StreamedBody) + numMoved * 2 ||
+		    _bodies.size() != numRemoved + numMoved)
+			return false;
+
+		Read(payload, _removed, numRemoved);
+		Read(payload, _added, numAdded);
+		const auto *moves = reinterpret_cast<const int8_t *>(payload.data());
+		const auto *movesEnd = moves + payload.size();
+
+		// Apply offsets to every body that stayed in view, which are the ones not removed in index order. Removed
+		// indices that match no body leave more bodies than moves, so stop before reading past the payload.
+		_retained.clear();
+		size_t removed = 0;
+		for (const auto &body : _bodies)
+		{
+			if (removed < _removed.size() && _removed[removed] == body.index)
+			{
+				removed++;
+				continue;
+			}
+
+			if (moves == movesEnd)
+				return false;
+
+			auto moved = body;
+			moved.x = static_cast<uint16_t>(body.x + *moves++);
+			moved.y = static_cast<uint16_t>(body.y + *moves++);
+			_retained.push_back(moved);
+		}
+
+		if (removed != _removed.size())
+			return false;
+
+		_bodies.resize(_retained.size() + _added.size());
+		std::ranges::merge(_retained, _added, _bodies.begin(),
+		                   [](const StreamedBody &a, const StreamedBody &b) { return a.index < b.index; });
+		_frameIndex = frameIndex;
+	}
+	else
+	{
+		return false;
+	}
+
+	_stats.frames++;
+	_stats.bodies += _bodies.size();
+	return true;
+}
+
+bool FrameClient::IsConnected() const { return _socket >= 0; }
+
+uint32_t FrameClient::GetFrameIndex() const { return _frameIndex; }
+
+std::span<const StreamedBody> FrameClient::GetBodies() const { return _bodies; }
+
+const StreamStats &FrameClient::GetStats() const { return _stats; }
+} // namespace kinematics
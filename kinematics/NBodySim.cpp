@@ -0,0 +1,53 @@
+#include "NBodySim.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <utility>
+
+namespace kinematics
+{
+NBodySim::NBodySim(const float width, const float height, const size_t numBodies, const float theta)
+	: StructOfVectorSim(width, height, numBodies), _theta(theta) {};
+
+NBodySim::NBodySim(const float width, const float height, const Simulation &toCopy, const float theta)
+	: StructOfVectorSim(width, height, toCopy), _theta(theta) {};
+
+void NBodySim::SetTheta(const float theta) { _theta = theta; }
+
+float NBodySim::GetTheta() const { return _theta; }
+
+void NBodySim::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                            float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed)
+{
+	KINEMATICS_TRACE_SCOPE("NBodySim::UpdateHelper");
+
+	const auto numBodies = GetNumBodies();
+	_accelerationX.resize(numBodies);
+	_accelerationY.resize(numBodies);
+	_tree.Build(bodiesX, bodiesY, numBodies);
+	_tree.Accelerate(TOTAL_STRENGTH / static_cast<float>(std::max<size_t>(numBodies, 1)), _theta, BODY_RADIUS,
+	                 _accelerationX.data(), _accelerationY.data());
+
+	// Gravity between bodies is an acceleration per body on top of any forces that are set, so the usual update
+	// applies both, along with bounce events and obstacles
+	_combined.gravity = _forces ? _forces->gravity : Vector2{0, 0};
+	_combined.drag = _forces ? _forces->drag : 0;
+	if (_forces)
+		_combined.fields.assign(_forces->fields.cbegin(), _forces->fields.cend());
+	else
+		_combined.fields.clear();
+	if (_forces && _forces->accelerationX)
+	{
+		for (size_t i = 0; i < numBodies; i++)
+		{
+			_accelerationX[i] += _forces->accelerationX[i];
+			_accelerationY[i] += _forces->accelerationY[i];
+		}
+	}
+	_combined.accelerationX = _accelerationX.data();
+	_combined.accelerationY = _accelerationY.data();
+
+	const auto *forces = std::exchange(_forces, &_combined);
+	Simulation::UpdateHelper(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+	_forces = forces;
+}
+} // namespace kinematics
@@ -0,0 +1,201 @@
+#include "ObstacleGrid.h"
+#include "kinematics.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace kinematics
+{
+namespace
+{
+/// Which way, if any, a body bounces off an obstacle grown to span `[left, right]` and `[top, bottom]`. Bodies bounce
+/// off the nearest side, but only when moving further in. Written without branches so it vectorizes.
+struct Bounce
+{
+	bool inside, horizontal, vertical;
+
+	Bounce(const float x, const float y, const float horizontalSpeed, const float verticalSpeed, const float left,
+	       const float top, const float right, const float bottom)
+	{
+		// Bitwise rather than logical operators, as short circuits are branches
+		inside = (x > left) & (x < right) & (y > top) & (y < bottom);
+
+		const auto fromLeft = x - left, fromRight = right - x;
+		const auto fromTop = y - top, fromBottom = bottom - y;
+		const bool nearestIsHorizontal = std::min(fromLeft, fromRight) <= std::min(fromTop, fromBottom);
+		const bool movingInHorizontally = ((fromLeft <= fromRight) & (horizontalSpeed > 0)) |
+		                                  ((fromLeft > fromRight) & (horizontalSpeed < 0));
+		const bool movingInVertically = ((fromTop <= fromBottom) & (verticalSpeed > 0)) |
+		                                ((fromTop > fromBottom) & (verticalSpeed < 0));
+		horizontal = inside & nearestIsHorizontal & movingInHorizontally;
+		vertical = inside & !nearestIsHorizontal & movingInVertically;
+	}
+};
+} // namespace
+
+ObstacleGrid::ObstacleGrid(std::vector<Rectangle> obstacles, const float cellSize)
+	: _obstacles(std::move(obstacles)), _originX(0), _originY(0), _inverseCellSize(1 / cellSize), _columns(0),
+	  _rows(0), _numCells(0), _emptyEntry(0)
+{
+	assert(cellSize > 0);
+
+	// Obstacles grown by `BODY_RADIUS`, and the area they cover
+	std::vector<Rectangle> grown;
+	float maxX = 0, maxY = 0;
+	if (!_obstacles.empty())
+	{
+		_originX = _originY = std::numeric_limits<float>::max();
+		maxX = maxY = std::numeric_limits<float>::lowest();
+	}
+
+	for (const auto &obstacle : _obstacles)
+	{
+		grown.push_back({obstacle.x - BODY_RADIUS, obstacle.y - BODY_RADIUS, obstacle.width + 2 * BODY_RADIUS,
+		                 obstacle.height + 2 * BODY_RADIUS});
+		_originX = std::min(_originX, grown.back().x);
+		_originY = std::min(_originY, grown.back().y);
+		maxX = std::max(maxX, grown.back().x + grown.back().width);
+		maxY = std::max(maxY, grown.back().y + grown.back().height);
+	}
+
+	if (!_obstacles.empty())
+	{
+		_columns = std::max(1, static_cast<int>(std::ceil((maxX - _originX) * _inverseCellSize)));
+		_rows = std::max(1, static_cast<int>(std::ceil((maxY - _originY) * _inverseCellSize)));
+		_numCells = static_cast<uint32_t>(_columns) * static_cast<uint32_t>(_rows);
+	}
+
+	// Cells covered by an obstacle, as an inclusive range of columns and rows
+	const auto forEachCell = [&](const Rectangle &obstacle, const auto &function) {
+		const auto toCell = [this](const float position, const float origin, const int numCells) {
+			return std::clamp(static_cast<int>((position - origin) * _inverseCellSize), 0, numCells - 1);
+		};
+		const auto firstColumn = toCell(obstacle.x, _originX, _columns);
+		const auto lastColumn = toCell(obstacle.x + obstacle.width, _originX, _columns);
+		const auto firstRow = toCell(obstacle.y, _originY, _rows);
+		const auto lastRow = toCell(obstacle.y + obstacle.height, _originY, _rows);
+		for (auto row = firstRow; row <= lastRow; row++)
+		{
+			for (auto column = firstColumn; column <= lastColumn; column++)
+				function(static_cast<size_t>(row * _columns + column));
+		}
+	};
+
+	// Count the obstacles of each cell, then place them, so each cell's obstacles are contiguous and in order
+	_cellStart.assign(_numCells + 2, 0);
+	for (const auto &obstacle : grown)
+		forEachCell(obstacle, [this](const size_t cell) { _cellStart[cell + 1]++; });
+
+	for (size_t cell = 0; cell < _numCells; cell++)
+		_cellStart[cell + 1] += _cellStart[cell];
+	_cellStart[_numCells + 1] = _cellStart[_numCells];
+
+	// Nothing is inside the empty entry, as its left is past its right
+	_emptyEntry = _cellStart[_numCells];
+	_left.assign(_emptyEntry + 1, std::numeric_limits<float>::max());
+	_top.assign(_emptyEntry + 1, std::numeric_limits<float>::max());
+	_right.assign(_emptyEntry + 1, std::numeric_limits<float>::lowest());
+	_bottom.assign(_emptyEntry + 1, std::numeric_limits<float>::lowest());
+
+	auto next = _cellStart;
+	for (const auto &obstacle : grown)
+	{
+		forEachCell(obstacle, [&](const size_t cell) {
+			const auto entry = next[cell]++;
+			_left[entry] = obstacle.x;
+			_top[entry] = obstacle.y;
+			_right[entry] = obstacle.x + obstacle.width;
+			_bottom[entry] = obstacle.y + obstacle.height;
+		});
+	}
+}
+
+void ObstacleGrid::Collide(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY,
+                           float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                           const size_t begin, const size_t end) const
+{
+	// Small enough that the state of a block stays in L1 across its passes, but large enough to amortize them
+	constexpr size_t BLOCK_SIZE = 256;
+	std::array<uint32_t, BLOCK_SIZE> first, count;
+	std::array<uint8_t, BLOCK_SIZE> done; // rather than `bool`, which GCC doesn't vectorize loads of
+	const auto *left = _left.data(), *top = _top.data(), *right = _right.data(), *bottom = _bottom.data();
+	const auto emptyEntry = _emptyEntry;
+
+	for (auto block = begin; block < end; block += BLOCK_SIZE)
+	{
+		const auto blockEnd = std::min(end, block + BLOCK_SIZE);
+
+		uint32_t maxCount = 0;
+#pragma omp simd reduction(max : maxCount)
+		for (auto i = block; i < blockEnd; i++)
+		{
+			const auto cell = GetCell(bodiesX[i], bodiesY[i]);
+			first[i - block] = _cellStart[cell];
+			count[i - block] = _cellStart[cell + 1] - _cellStart[cell];
+			done[i - block] = 0;
+			maxCount = std::max(maxCount, count[i - block]);
+		}
+
+		// Every body tests its `k`th candidate at once. Bodies with fewer candidates test the empty entry instead, and
+		// bodies that were inside an earlier candidate stop there, as bouncing off each of overlapping obstacles would
+		// cancel out.
+		for (uint32_t k = 0; k < maxCount; k++)
+		{
+#pragma omp simd
+			for (auto i = block; i < blockEnd; i++)
+			{
+				const auto j = i - block;
+				// Signed, as gathers take signed 32-bit indices
+				const auto entry = static_cast<int>(k < count[j] ? first[j] + k : emptyEntry);
+				const Bounce bounce(bodiesX[i], bodiesY[i], bodiesHorizontalSpeed[i], bodiesVerticalSpeed[i],
+				                    left[entry], top[entry], right[entry], bottom[entry]);
+				bodiesHorizontalSpeed[i] *= bounce.horizontal & !done[j] ? -1.f : 1.f;
+				bodiesVerticalSpeed[i] *= bounce.vertical & !done[j] ? -1.f : 1.f;
+				done[j] = static_cast<uint8_t>(done[j] | bounce.inside);
+			}
+		}
+	}
+}
+
+void ObstacleGrid::Collide(const float x, const float y, float &horizontalSpeed, float &verticalSpeed) const
+{
+	Collide(GetCell(x, y), x, y, horizontalSpeed, verticalSpeed);
+}
+
+std::span<const Rectangle> ObstacleGrid::GetObstacles() const { return _obstacles; }
+
+size_t ObstacleGrid::GetNumEntries() const { return _emptyEntry; }
+
+uint32_t ObstacleGrid::GetCell(const float x, const float y) const
+{
+	// Clamped first, as converting a float that doesn't fit in an int is undefined
+	const auto column =
+		static_cast<int>(std::clamp((x - _originX) * _inverseCellSize, -1.f, static_cast<float>(_columns)));
+	const auto row =
+		static_cast<int>(std::clamp((y - _originY) * _inverseCellSize, -1.f, static_cast<float>(_rows)));
+
+	const bool inside = column >= 0 && column < _columns && row >= 0 && row < _rows;
+	return inside ? static_cast<uint32_t>(row * _columns + column) : _numCells;
+}
+
+void ObstacleGrid::Collide(const uint32_t cell, const float x, const float y, float &horizontalSpeed,
+                           float &verticalSpeed) const
+{
+	for (auto entry = _cellStart[cell]; entry < _cellStart[cell + 1]; entry++)
+	{
+		const Bounce bounce(x, y, horizontalSpeed, verticalSpeed, _left[entry], _top[entry], _right[entry],
+		                    _bottom[entry]);
+		if (!bounce.inside)
+			continue;
+
+		if (bounce.horizontal)
+			horizontalSpeed *= -1;
+		if (bounce.vertical)
+			verticalSpeed *= -1;
+		return;
+	}
+}
+} // namespace kinematics
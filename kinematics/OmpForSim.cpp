@@ -1,5 +1,11 @@
 #include "kinematics.h"
+#include "BounceEvents.h"
+#include "Forces.h"
+#include "ObstacleGrid.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <cassert>
+#include <omp.h>
 #include <raylib.h>
 
 namespace kinematics
@@ -13,24 +19,89 @@ OmpForSim::OmpForSim(const float width, const float height, const Simulation &to
 void OmpForSim::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
                              float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed)
 {
+	KINEMATICS_TRACE_SCOPE("OmpForSim::UpdateHelper");
+
 	const auto numBodies = GetNumBodies();
-#pragma omp parallel for
-	for (size_t i = 0; i < numBodies; i++)
+	if (_bounceEvents)
+	{
+		// Each thread takes a contiguous range, a multiple of a cache line long, and records its bounces in a buffer of
+		// its own so that threads never contend. Joining the ranges in order of thread keeps events in order of body.
+		_bounceEvents->BeginStep(static_cast<size_t>(omp_get_max_threads()));
+#pragma omp parallel
+		{
+			KINEMATICS_TRACE_SCOPE("OmpForSim worker");
+
+			const auto thread = static_cast<size_t>(omp_get_thread_num());
+			const auto numThreads = static_cast<size_t>(omp_get_num_threads());
+			constexpr size_t BODIES_PER_LINE = 64 / sizeof(float);
+			const auto perThread = (numBodies + numThreads * BODIES_PER_LINE - 1) / (numThreads * BODIES_PER_LINE);
+			const auto begin = std::min(numBodies, thread * perThread * BODIES_PER_LINE);
+			const auto end = std::min(numBodies, begin + perThread * BODIES_PER_LINE);
+			if (_forces)
+				Accelerate(*_forces, deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, begin,
+				           end);
+			UpdateRecordingBounces(deltaTime, _width, _height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+			                       bodiesVerticalSpeed, begin, end, _bounceEvents->GetBuffer(thread));
+			if (_obstacles)
+				_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, begin, end);
+		}
+		return;
+	}
+
+	// Forces and obstacles split bodies into blocks that are each a single vectorized pass, a multiple of a cache line
+	// long so threads never share one
+	constexpr size_t BLOCK_SIZE = 4096;
+	const auto numBlocks = (numBodies + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+#pragma omp parallel
 	{
-		// Update position based on speed
-		bodiesX[i] += bodiesHorizontalSpeed[i] * deltaTime;
-		bodiesY[i] += bodiesVerticalSpeed[i] * deltaTime;
+		// Each worker's share, without waiting on the others, so imbalance and late wakeups show up in a trace
+		KINEMATICS_TRACE_SCOPE("OmpForSim worker");
 
-		// Bounce horizontally
-		if (BounceCheck(bodiesX[i], bodiesHorizontalSpeed[i], _width))
+		if (_forces)
+		{
+#pragma omp for nowait
+			for (size_t block = 0; block < numBlocks; block++)
+			{
+				const auto begin = block * BLOCK_SIZE;
+				UpdateApplyingForces(*_forces, deltaTime, _width, _height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+				                     bodiesVerticalSpeed, begin, std::min(numBodies, begin + BLOCK_SIZE));
+			}
+		}
+		else
 		{
-			bodiesHorizontalSpeed[i] *= -1;
+#pragma omp for nowait
+			for (size_t i = 0; i < numBodies; i++)
+			{
+				// Update position based on speed
+				bodiesX[i] += bodiesHorizontalSpeed[i] * deltaTime;
+				bodiesY[i] += bodiesVerticalSpeed[i] * deltaTime;
+
+				// Bounce horizontally
+				if (BounceCheck(bodiesX[i], bodiesHorizontalSpeed[i], _width))
+				{
+					bodiesHorizontalSpeed[i] *= -1;
+				}
+
+				// Bounce vertically
+				if (BounceCheck(bodiesY[i], bodiesVerticalSpeed[i], _height))
+				{
+					bodiesVerticalSpeed[i] *= -1;
+				}
+			}
 		}
 
-		// Bounce vertically
-		if (BounceCheck(bodiesY[i], bodiesVerticalSpeed[i], _height))
+		// Bodies may be split differently for obstacles, so every body has to have moved first
+		if (_obstacles)
 		{
-			bodiesVerticalSpeed[i] *= -1;
+#pragma omp barrier
+#pragma omp for nowait
+			for (size_t block = 0; block < numBlocks; block++)
+			{
+				const auto begin = block * BLOCK_SIZE;
+				_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, begin,
+				                    std::min(numBodies, begin + BLOCK_SIZE));
+			}
 		}
 	}
 }
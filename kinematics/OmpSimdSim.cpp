@@ -1,4 +1,6 @@
 #include "kinematics.h"
+#include "ObstacleGrid.h"
+#include "Tracing.h"
 #include <cassert>
 #include <raylib.h>
 
@@ -13,6 +15,21 @@ OmpSimdSim::OmpSimdSim(const float width, const float height, const Simulation &
 void OmpSimdSim::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
                               float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed)
 {
+	KINEMATICS_TRACE_SCOPE("OmpSimdSim::UpdateHelper");
+
+	// Bounces are only looked for when something is subscribed to them, otherwise the loop below is unchanged
+	if (_bounceEvents)
+	{
+		UpdateAndRecordBounces(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+		return;
+	}
+
+	if (_forces)
+	{
+		UpdateAndApplyForces(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+		return;
+	}
+
 	const auto numBodies = GetNumBodies();
 #pragma omp simd
 	for (size_t i = 0; i < numBodies; i++)
@@ -33,5 +50,8 @@ void OmpSimdSim::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX
 			bodiesVerticalSpeed[i] *= -1;
 		}
 	}
+
+	if (_obstacles)
+		_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, numBodies);
 }
 } // namespace kinematics
@@ -0,0 +1,170 @@
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <cassert>
+#include <raymath.h>
+#include <rlgl.h>
+
+namespace kinematics
+{
+PointRenderer::PointRenderer() : _vao(0), _vbo(0), _capacity(0), _radiusVbo(0), _radiusLocation(-1)
+{
+	// Same approach as `ShaderSim`: a fragment shader that cuts a circle out of each point, with a vertex shader like
+	// raylib's default that also sizes each point by its radius
+	_shader = LoadShader("shaders/vertex.glsl", "shaders/fragment.glsl");
+	_radiusLocation = GetShaderLocationAttrib(_shader, "vertexRadius");
+
+	glGenVertexArrays(1, &_vao);
+	glBindVertexArray(_vao);
+	glGenBuffers(1, &_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+	glVertexAttribPointer(static_cast<GLuint>(_shader.locs[SHADER_LOC_VERTEX_POSITION]), 2, GL_FLOAT, false,
+	                      sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, x)));
+	glVertexAttribPointer(static_cast<GLuint>(_shader.locs[SHADER_LOC_VERTEX_COLOR]), 4, GL_UNSIGNED_BYTE, true,
+	                      sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, color)));
+
+	glEnableVertexAttribArray(static_cast<GLuint>(_shader.locs[SHADER_LOC_VERTEX_POSITION]));
+	glEnableVertexAttribArray(static_cast<GLuint>(_shader.locs[SHADER_LOC_VERTEX_COLOR]));
+
+	glGenBuffers(1, &_radiusVbo);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+PointRenderer::~PointRenderer()
+{
+	// Only release resources if window is still ready to avoid potential segfault
+	if (IsWindowReady())
+	{
+		glDeleteBuffers(1, &_radiusVbo);
+		glDeleteBuffers(1, &_vbo);
+		glDeleteVertexArrays(1, &_vao);
+		UnloadShader(_shader);
+	}
+}
+
+void PointRenderer::Draw(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+                         const size_t numBodies)
+{
+	DrawArrays(x, y, color, nullptr, GL_FLOAT, 0, numBodies);
+}
+
+void PointRenderer::Draw(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+                         const float *__restrict__ radius, const size_t numBodies)
+{
+	DrawArrays(x, y, color, radius, GL_FLOAT, sizeof(float), numBodies);
+}
+
+void PointRenderer::Draw(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+                         const uint8_t *__restrict__ radius, const size_t numBodies)
+{
+	DrawArrays(x, y, color, radius, GL_UNSIGNED_BYTE, sizeof(uint8_t), numBodies);
+}
+
+void PointRenderer::Draw(std::span<const Body> bodies)
+{
+	if (bodies.empty())
+		return;
+
+	SetRadii(nullptr, GL_FLOAT, 0, bodies.size());
+	Vertex *__restrict__ vertices = Map(bodies.size());
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		vertices[i] = Vertex{.x = bodies[i].x, .y = bodies[i].y, .color = bodies[i].color};
+	}
+	UnmapAndDraw(bodies.size());
+}
+
+void PointRenderer::Draw(const BodyFrame &frame)
+{
+	assert(frame.x.size() == frame.y.size() && frame.x.size() == frame.color.size());
+	assert(frame.radius.empty() || frame.radius.size() == frame.x.size());
+	if (frame.radius.empty())
+		Draw(frame.x.data(), frame.y.data(), frame.color.data(), frame.x.size());
+	else
+		Draw(frame.x.data(), frame.y.data(), frame.color.data(), frame.radius.data(), frame.x.size());
+}
+
+void PointRenderer::DrawArrays(const float *__restrict__ x, const float *__restrict__ y,
+                               const Color *__restrict__ color, const void *radius, const GLenum type,
+                               const size_t size, const size_t numBodies)
+{
+	KINEMATICS_TRACE_SCOPE("PointRenderer::Draw");
+
+	if (numBodies == 0)
+		return;
+
+	SetRadii(radius, type, size, numBodies);
+	Vertex *__restrict__ vertices = Map(numBodies);
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		vertices[i] = Vertex{.x = x[i], .y = y[i], .color = color[i]};
+	}
+	UnmapAndDraw(numBodies);
+}
+
+PointRenderer::Vertex *PointRenderer::Map(const size_t numBodies)
+{
+	// `Draw()` should not be called when a window is not available
+	assert(IsWindowReady());
+
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+	if (numBodies > _capacity)
+	{
+		_capacity = numBodies;
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(Vertex) * _capacity), nullptr, GL_STREAM_DRAW);
+	}
+
+	// Invalidating lets the driver hand out fresh memory rather than wait for the previous frame's draw to finish
+	// with it. Persistent mapping would avoid the map call entirely, but needs OpenGL 4.4 while raylib is set up for
+	// 4.3.
+	return static_cast<Vertex *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(sizeof(Vertex) * numBodies),
+	                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+}
+
+void PointRenderer::SetRadii(const void *radius, const GLenum type, const size_t size, const size_t numBodies)
+{
+	const auto location = static_cast<GLuint>(_radiusLocation);
+	glBindVertexArray(_vao);
+	if (!radius)
+	{
+		// The constant value set when drawing stands in for an array of identical radii
+		glDisableVertexAttribArray(location);
+	}
+	else
+	{
+		// Integer radii are converted to floats as they're read, rather than widened on the CPU first
+		glBindBuffer(GL_ARRAY_BUFFER, _radiusVbo);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size * numBodies), radius, GL_STREAM_DRAW);
+		glVertexAttribPointer(location, 1, type, false, static_cast<GLsizei>(size), nullptr);
+		glEnableVertexAttribArray(location);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glBindVertexArray(0);
+}
+
+void PointRenderer::UnmapAndDraw(const size_t numBodies)
+{
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Anything raylib has queued should be drawn first so it ends up beneath the bodies
+	rlDrawRenderBatchActive();
+
+	glUseProgram(_shader.id);
+	const Matrix modelViewProjection = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+	glUniformMatrix4fv(_shader.locs[SHADER_LOC_MATRIX_MVP], 1, false, MatrixToFloat(modelViewProjection));
+
+	// Points are sized by the vertex shader, from each body's radius. The constant is only used while there's no array
+	// of radii, and is set after raylib's batch as that may have left other values in the attribute.
+	glVertexAttrib1f(static_cast<GLuint>(_radiusLocation), BODY_RADIUS);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	glBindVertexArray(_vao);
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(numBodies));
+
+	glBindVertexArray(0);
+	glDisable(GL_PROGRAM_POINT_SIZE);
+	glUseProgram(0);
+}
+} // namespace kinematics
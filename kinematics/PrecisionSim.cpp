@@ -0,0 +1,268 @@
+#include "kinematics.h"
+#include "BounceEvents.h"
+#include "Forces.h"
+#include "ObstacleGrid.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <cassert>
+#include <raylib.h>
+#include <type_traits>
+
+namespace kinematics
+{
+namespace
+{
+/// @returns `value` rounded to `float`, which is no conversion at all for `float`
+template <typename Scalar> float ToFloat(const Scalar value)
+{
+	if constexpr (std::is_same_v<Scalar, float>)
+		return value;
+	else
+		return static_cast<float>(value);
+}
+
+/// Same as `Simulation::BounceCheck`, in `Scalar`
+template <typename Scalar> bool IsBouncing(const Scalar position, const Scalar speed, const Scalar bounds)
+{
+	constexpr auto RADIUS = static_cast<Scalar>(BODY_RADIUS);
+	return (position - RADIUS < 0 && speed < 0) || (position + RADIUS > bounds && speed > 0);
+}
+
+/// Accelerate a single body by `forces`, which are given in `float`. For wider types only the change in speed is
+/// rounded, rather than the speed itself.
+template <typename Scalar>
+void AccelerateBody(const Forces &forces, const float deltaTime, const Scalar x, const Scalar y,
+                    Scalar &horizontalSpeed, Scalar &verticalSpeed, const size_t body)
+{
+	if constexpr (std::is_same_v<Scalar, float>)
+	{
+		Accelerate(forces, deltaTime, x, y, horizontalSpeed, verticalSpeed, body);
+	}
+	else
+	{
+		const auto oldHorizontalSpeed = static_cast<float>(horizontalSpeed);
+		const auto oldVerticalSpeed = static_cast<float>(verticalSpeed);
+		auto newHorizontalSpeed = oldHorizontalSpeed, newVerticalSpeed = oldVerticalSpeed;
+		Accelerate(forces, deltaTime, static_cast<float>(x), static_cast<float>(y), newHorizontalSpeed,
+		           newVerticalSpeed, body);
+		horizontalSpeed += static_cast<Scalar>(newHorizontalSpeed) - static_cast<Scalar>(oldHorizontalSpeed);
+		verticalSpeed += static_cast<Scalar>(newVerticalSpeed) - static_cast<Scalar>(oldVerticalSpeed);
+	}
+}
+
+/// Bounce a single body off `obstacles`, which only ever reverses speeds, so wider types reverse their own
+template <typename Scalar>
+void CollideBody(const ObstacleGrid &obstacles, const Scalar x, const Scalar y, Scalar &horizontalSpeed,
+                 Scalar &verticalSpeed)
+{
+	if constexpr (std::is_same_v<Scalar, float>)
+	{
+		obstacles.Collide(x, y, horizontalSpeed, verticalSpeed);
+	}
+	else
+	{
+		auto roundedHorizontalSpeed = static_cast<float>(horizontalSpeed);
+		auto roundedVerticalSpeed = static_cast<float>(verticalSpeed);
+		obstacles.Collide(static_cast<float>(x), static_cast<float>(y), roundedHorizontalSpeed, roundedVerticalSpeed);
+		if (roundedHorizontalSpeed != static_cast<float>(horizontalSpeed))
+			horizontalSpeed *= -1;
+		if (roundedVerticalSpeed != static_cast<float>(verticalSpeed))
+			verticalSpeed *= -1;
+	}
+}
+} // namespace
+
+template <typename Scalar>
+PrecisionSim<Scalar>::PrecisionSim(const float width, const float height, const size_t numBodies)
+	: Simulation(width, height)
+{
+	// Add an initial `numBodies` bodies to the simulation
+	SetNumBodies(numBodies);
+}
+
+template <typename Scalar>
+PrecisionSim<Scalar>::PrecisionSim(const float width, const float height, const Simulation &toCopy)
+	: Simulation(width, height)
+{
+	const auto totalNumBodies = toCopy.GetNumBodies();
+	_bodies.x.reserve(totalNumBodies);
+	_bodies.y.reserve(totalNumBodies);
+	_bodies.horizontalSpeed.reserve(totalNumBodies);
+	_bodies.verticalSpeed.reserve(totalNumBodies);
+	_bodies.color.reserve(totalNumBodies);
+
+	AddBodies(toCopy.GetBodies());
+}
+
+template <typename Scalar> std::vector<Body> PrecisionSim<Scalar>::GetBodies() const
+{
+	KINEMATICS_TRACE_SCOPE("PrecisionSim::GetBodies");
+
+	std::vector<Body> copy;
+	copy.reserve(GetNumBodies());
+
+	const auto numBodies = GetNumBodies();
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		copy.emplace_back(ToFloat(_bodies.x[i]), ToFloat(_bodies.y[i]), ToFloat(_bodies.horizontalSpeed[i]),
+		                  ToFloat(_bodies.verticalSpeed[i]), _bodies.color[i]);
+	}
+
+	return copy;
+}
+
+template <typename Scalar> void PrecisionSim<Scalar>::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.assign(_bodies.x.cbegin(), _bodies.x.cend());
+	frame.y.assign(_bodies.y.cbegin(), _bodies.y.cend());
+	frame.color.assign(_bodies.color.data(), _bodies.color.data() + numBodies);
+	frame.radius.clear();
+}
+
+template <typename Scalar> void PrecisionSim<Scalar>::RoundPositions() const
+{
+	_roundedX.assign(_bodies.x.cbegin(), _bodies.x.cend());
+	_roundedY.assign(_bodies.y.cbegin(), _bodies.y.cend());
+}
+
+template <typename Scalar> void PrecisionSim<Scalar>::Update(const float deltaTime)
+{
+	KINEMATICS_TRACE_SCOPE("PrecisionSim::Update");
+
+	if (_bounceEvents || _forces || _obstacles)
+	{
+		UpdateOneAtATime(deltaTime);
+	}
+	else
+	{
+		Scalar *__restrict__ bodiesX = _bodies.x.data();
+		Scalar *__restrict__ bodiesY = _bodies.y.data();
+		Scalar *__restrict__ bodiesHorizontalSpeed = _bodies.horizontalSpeed.data();
+		Scalar *__restrict__ bodiesVerticalSpeed = _bodies.verticalSpeed.data();
+		const Scalar step = deltaTime, width = _width, height = _height;
+
+		// Same as `UpdateHelper`, in `Scalar`, so a SIMD register holds as many bodies as fit at that width
+		const auto numBodies = GetNumBodies();
+		for (size_t i = 0; i < numBodies; i++)
+		{
+			// Update position based on speed
+			bodiesX[i] += bodiesHorizontalSpeed[i] * step;
+			bodiesY[i] += bodiesVerticalSpeed[i] * step;
+
+			// Bounce horizontally
+			if (IsBouncing(bodiesX[i], bodiesHorizontalSpeed[i], width))
+			{
+				bodiesHorizontalSpeed[i] *= -1;
+			}
+
+			// Bounce vertically
+			if (IsBouncing(bodiesY[i], bodiesVerticalSpeed[i], height))
+			{
+				bodiesVerticalSpeed[i] *= -1;
+			}
+		}
+	}
+
+	if (_spatialIndex)
+	{
+		RoundPositions();
+		UpdateSpatialIndex(_roundedX.data(), _roundedY.data());
+	}
+}
+
+template <typename Scalar> void PrecisionSim<Scalar>::UpdateOneAtATime(const float deltaTime)
+{
+	const Scalar step = deltaTime, width = _width, height = _height;
+	if (_bounceEvents)
+		_bounceEvents->BeginStep(1);
+
+	const auto numBodies = GetNumBodies();
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		const auto body = static_cast<uint32_t>(i);
+		auto &x = _bodies.x[i], &y = _bodies.y[i];
+		auto &horizontalSpeed = _bodies.horizontalSpeed[i], &verticalSpeed = _bodies.verticalSpeed[i];
+		if (_forces)
+			AccelerateBody(*_forces, deltaTime, x, y, horizontalSpeed, verticalSpeed, i);
+
+		x += horizontalSpeed * step;
+		y += verticalSpeed * step;
+
+		if (IsBouncing(x, horizontalSpeed, width))
+		{
+			if (_bounceEvents)
+				_bounceEvents->GetBuffer(0).Add({body, horizontalSpeed < 0 ? Wall::Left : Wall::Right});
+			horizontalSpeed *= -1;
+		}
+
+		if (IsBouncing(y, verticalSpeed, height))
+		{
+			if (_bounceEvents)
+				_bounceEvents->GetBuffer(0).Add({body, verticalSpeed < 0 ? Wall::Top : Wall::Bottom});
+			verticalSpeed *= -1;
+		}
+
+		if (_obstacles)
+			CollideBody(*_obstacles, x, y, horizontalSpeed, verticalSpeed);
+	}
+}
+
+template <typename Scalar> void PrecisionSim<Scalar>::Draw() const
+{
+	KINEMATICS_TRACE_SCOPE("PrecisionSim::Draw");
+
+	// `Draw()` should not be called when a window is not available
+	assert(IsWindowReady());
+
+	RoundPositions();
+	GetRenderer().Draw(_roundedX.data(), _roundedY.data(), _bodies.color.data(), GetNumBodies());
+}
+
+template <typename Scalar> void PrecisionSim<Scalar>::SetNumBodies(const size_t totalNumBodies)
+{
+	KINEMATICS_TRACE_SCOPE("PrecisionSim::SetNumBodies");
+
+	if (totalNumBodies > GetNumBodies())
+	{
+		_bodies.x.reserve(totalNumBodies);
+		_bodies.y.reserve(totalNumBodies);
+		_bodies.horizontalSpeed.reserve(totalNumBodies);
+		_bodies.verticalSpeed.reserve(totalNumBodies);
+		_bodies.color.reserve(totalNumBodies);
+
+		AddRandomBodies(totalNumBodies - GetNumBodies());
+	}
+	else
+	{
+		_bodies.x.resize(totalNumBodies);
+		_bodies.y.resize(totalNumBodies);
+		_bodies.horizontalSpeed.resize(totalNumBodies);
+		_bodies.verticalSpeed.resize(totalNumBodies);
+		_bodies.color.resize(totalNumBodies);
+	}
+
+	RebuildSpatialIndex();
+}
+
+template <typename Scalar> size_t PrecisionSim<Scalar>::GetNumBodies() const { return _bodies.x.size(); }
+
+template <typename Scalar>
+void PrecisionSim<Scalar>::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                        const float *__restrict__ horizontalSpeed,
+                                        const float *__restrict__ verticalSpeed, const Color *__restrict__ color,
+                                        const size_t numBodies)
+{
+	_bodies.x.insert(_bodies.x.end(), x, x + numBodies);
+	_bodies.y.insert(_bodies.y.end(), y, y + numBodies);
+
+	_bodies.horizontalSpeed.insert(_bodies.horizontalSpeed.end(), horizontalSpeed, horizontalSpeed + numBodies);
+	_bodies.verticalSpeed.insert(_bodies.verticalSpeed.end(), verticalSpeed, verticalSpeed + numBodies);
+
+	_bodies.color.insert(_bodies.color.end(), color, color + numBodies);
+}
+
+// Explicitly instantiate specializations so they can be used from the shared library
+template class PrecisionSim<float>;
+template class PrecisionSim<double>;
+} // namespace kinematics
@@ -1,4 +1,6 @@
 #include "kinematics.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <external/glad.h>
@@ -62,6 +64,8 @@ ShaderSim::~ShaderSim()
 
 std::vector<Body> ShaderSim::GetBodies() const
 {
+	KINEMATICS_TRACE_SCOPE("ShaderSim::GetBodies");
+
 	std::vector<Body> copy(GetNumBodies());
 
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _vbo);
@@ -72,6 +76,8 @@ std::vector<Body> ShaderSim::GetBodies() const
 
 void ShaderSim::Update(const float deltaTime)
 {
+	KINEMATICS_TRACE_SCOPE("ShaderSim::Update");
+
 	constexpr unsigned WORKGROUP_SIZE = 1024;
 	constexpr unsigned WORKGROUP_LIMIT = 1 << 16;
 
@@ -100,6 +106,8 @@ void ShaderSim::Update(const float deltaTime)
 
 void ShaderSim::Draw() const
 {
+	KINEMATICS_TRACE_SCOPE("ShaderSim::Draw");
+
 	// `Draw()` should not be called when a window is not available
 	assert(IsWindowReady());
 
@@ -125,6 +133,8 @@ void ShaderSim::Draw() const
 
 void ShaderSim::SetNumBodies(const size_t totalNumBodies)
 {
+	KINEMATICS_TRACE_SCOPE("ShaderSim::SetNumBodies");
+
 	if (totalNumBodies > _maxBodies)
 	{
 		// TODO: we don't really need CPU buffer, if we have similar shader functionality
@@ -148,5 +158,36 @@ void ShaderSim::SetNumBodies(const size_t totalNumBodies)
 
 size_t ShaderSim::GetNumBodies() const { return _numBodies; }
 
-void ShaderSim::AddRandomBody() {}
+void ShaderSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                             const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+                             const Color *__restrict__ color, const size_t numBodies)
+{
+	KINEMATICS_TRACE_SCOPE("ShaderSim::AppendBodies");
+
+	// The buffer holds a `Body` each, as the shaders read them
+	std::vector<Body> bodies(numBodies);
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		bodies[i] = {x[i], y[i], horizontalSpeed[i], verticalSpeed[i], color[i]};
+	}
+
+	if (_numBodies + numBodies > _maxBodies)
+	{
+		// Grows to at least double, by way of a copy on the CPU as in `SetNumBodies()`
+		const auto oldBodies = GetBodies();
+		const auto maxBodies = std::max(_numBodies + numBodies, 2 * _maxBodies);
+
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(Body) * maxBodies), nullptr, GL_DYNAMIC_COPY);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(sizeof(Body) * oldBodies.size()),
+		                oldBodies.data());
+
+		_maxBodies = maxBodies;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(sizeof(Body) * _numBodies),
+	                static_cast<GLsizeiptr>(sizeof(Body) * numBodies), bodies.data());
+	_numBodies += numBodies;
+}
 } // namespace kinematics
@@ -1,39 +1,153 @@
 #include "kinematics.h"
+#include "BounceEvents.h"
+#include "Forces.h"
+#include "ObstacleGrid.h"
+#include "PointRenderer.h"
+#include "SpatialIndex.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <cassert>
 #include <raylib.h>
 
 namespace kinematics
 {
-Simulation::Simulation(const float width, const float height) : _width(width), _height(height)
+namespace
 {
-	// Not the most robust, but avoid segfault trying to access window related functionality where a window is not
-	// present (such as via the benchmark).
-	// TODO: Compose a draw stategy?
-	if (IsWindowReady())
+/// Bodies handed to `AppendBodies()` at once by the base class, few enough for a batch to stay in cache on its way to
+/// the implementation's own arrays
+constexpr size_t BATCH_SIZE = 4'096;
+
+/// A batch of bodies with a separate array for each field, as `AppendBodies()` takes them
+struct Batch
+{
+	std::vector<float> x, y;
+	std::vector<float> horizontalSpeed, verticalSpeed;
+	std::vector<Color> color;
+
+	void Clear()
 	{
-		// Create texture for all bodies to reuse
-		_bodyRender = LoadRenderTexture(BODY_RADIUS * 2, BODY_RADIUS * 2);
-		BeginTextureMode(_bodyRender);
-		ClearBackground(BLANK);
-		DrawCircle(BODY_RADIUS, BODY_RADIUS, BODY_RADIUS, WHITE);
-		EndTextureMode();
+		x.clear();
+		y.clear();
+		horizontalSpeed.clear();
+		verticalSpeed.clear();
+		color.clear();
 	}
-}
-Simulation::~Simulation()
+
+	void Push(const Body &body)
+	{
+		x.push_back(body.x);
+		y.push_back(body.y);
+		horizontalSpeed.push_back(body.horizontalSpeed);
+		verticalSpeed.push_back(body.verticalSpeed);
+		color.push_back(body.color);
+	}
+};
+} // namespace
+
+Simulation::Simulation(const float width, const float height) : _width(width), _height(height) {}
+Simulation::~Simulation() = default;
+
+PointRenderer &Simulation::GetRenderer() const
 {
-	// Only unload texture if window is still ready to avoid potential segfault
-	if (IsWindowReady())
-		UnloadRenderTexture(_bodyRender);
+	// Created on first use rather than on construction, as only drawing is tied to the thread with the OpenGL context.
+	// Simulations can then be created anywhere, such as on a simulation thread or without a window at all.
+	if (!_renderer)
+		_renderer = std::make_unique<PointRenderer>();
+	return *_renderer;
 }
 
 void Simulation::SetNumBodies([[maybe_unused]] const size_t totalNumBodies) {}
 
+std::vector<float> Simulation::GetRadii() const { return {}; }
+
+void Simulation::CopyFrame(BodyFrame &frame) const
+{
+	const auto bodies = GetBodies();
+	frame.radius = GetRadii();
+	frame.x.resize(bodies.size());
+	frame.y.resize(bodies.size());
+	frame.color.resize(bodies.size());
+
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		frame.x[i] = bodies[i].x;
+		frame.y[i] = bodies[i].y;
+		frame.color[i] = bodies[i].color;
+	}
+}
+
+void Simulation::PublishFrame(TripleBuffer<BodyFrame> &frames) const
+{
+	CopyFrame(frames.Back());
+	frames.Publish();
+}
+
 void Simulation::SetBounds(const float width, const float height)
 {
 	_width = width;
 	_height = height;
 }
 
+float Simulation::GetWidth() const { return _width; }
+
+float Simulation::GetHeight() const { return _height; }
+
+void Simulation::SetBounceEvents(BounceEvents *events) { _bounceEvents = events; }
+
+void Simulation::SetObstacles(const ObstacleGrid *obstacles) { _obstacles = obstacles; }
+
+void Simulation::SetSpatialIndex(SpatialIndex *index)
+{
+	_spatialIndex = index;
+
+	// Built from a copy this once, so queries answer for the current bodies without waiting for a step
+	RebuildSpatialIndex();
+}
+
+void Simulation::SetForces(const Forces *forces) { _forces = forces; }
+
+void Simulation::AddBodies(std::span<const Body> bodies)
+{
+	KINEMATICS_TRACE_SCOPE("Simulation::AddBodies");
+
+	Batch batch;
+	for (size_t first = 0; first < bodies.size(); first += BATCH_SIZE)
+	{
+		batch.Clear();
+		for (const auto &body : bodies.subspan(first, std::min(BATCH_SIZE, bodies.size() - first)))
+			batch.Push(body);
+		AppendBodies(batch.x.data(), batch.y.data(), batch.horizontalSpeed.data(), batch.verticalSpeed.data(),
+		             batch.color.data(), batch.x.size());
+	}
+	RebuildSpatialIndex();
+}
+
+void Simulation::AddBodies(const float *x, const float *y, const float *horizontalSpeed, const float *verticalSpeed,
+                           const Color *color, const size_t numBodies)
+{
+	KINEMATICS_TRACE_SCOPE("Simulation::AddBodies");
+
+	if (numBodies)
+	{
+		AppendBodies(x, y, horizontalSpeed, verticalSpeed, color, numBodies);
+		RebuildSpatialIndex();
+	}
+}
+
+void Simulation::AddRandomBodies(const size_t numBodies)
+{
+	Batch batch;
+	for (size_t first = 0; first < numBodies; first += BATCH_SIZE)
+	{
+		batch.Clear();
+		const auto batchSize = std::min(BATCH_SIZE, numBodies - first);
+		for (size_t i = 0; i < batchSize; i++)
+			batch.Push(GenerateRandomBody());
+		AppendBodies(batch.x.data(), batch.y.data(), batch.horizontalSpeed.data(), batch.verticalSpeed.data(),
+		             batch.color.data(), batch.x.size());
+	}
+}
+
 Body Simulation::GenerateRandomBody() const
 {
 	return Body{// Random starting position of a body that is in bounds
@@ -55,9 +169,69 @@ bool Simulation::BounceCheck(const float position, const float speed, const floa
 	return (position - BODY_RADIUS < 0 && speed < 0) || (position + BODY_RADIUS > bounds && speed > 0);
 }
 
+void Simulation::UpdateAndRecordBounces(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                                        float *__restrict__ bodiesHorizontalSpeed,
+                                        float *__restrict__ bodiesVerticalSpeed)
+{
+	// Recording moves bodies in a loop of its own, so forces are a pass of their own before it
+	if (_forces)
+		Accelerate(*_forces, deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0,
+		           GetNumBodies());
+
+	_bounceEvents->BeginStep(1);
+	kinematics::UpdateRecordingBounces(deltaTime, _width, _height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+	                                   bodiesVerticalSpeed, 0, GetNumBodies(), _bounceEvents->GetBuffer(0));
+
+	if (_obstacles)
+		_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, GetNumBodies());
+}
+
+void Simulation::UpdateAndApplyForces(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                                      float *__restrict__ bodiesHorizontalSpeed,
+                                      float *__restrict__ bodiesVerticalSpeed)
+{
+	kinematics::UpdateApplyingForces(*_forces, deltaTime, _width, _height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+	                                 bodiesVerticalSpeed, 0, GetNumBodies());
+
+	if (_obstacles)
+		_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, GetNumBodies());
+}
+
+void Simulation::UpdateSpatialIndex(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY)
+{
+	if (_spatialIndex)
+		_spatialIndex->Build(bodiesX, bodiesY, GetNumBodies(), _width, _height);
+}
+
+void Simulation::RebuildSpatialIndex()
+{
+	if (!_spatialIndex)
+		return;
+
+	BodyFrame frame;
+	CopyFrame(frame);
+	_spatialIndex->Build(frame.x.data(), frame.y.data(), frame.x.size(), _width, _height);
+}
+
 void Simulation::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
                               float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed)
 {
+	KINEMATICS_TRACE_SCOPE("Simulation::UpdateHelper");
+
+	// Bounces are only looked for when something is subscribed to them, otherwise the loop below is unchanged
+	if (_bounceEvents)
+	{
+		UpdateAndRecordBounces(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+		return;
+	}
+
+	// Likewise for forces, which are accelerated in the same pass that moves bodies rather than before it
+	if (_forces)
+	{
+		UpdateAndApplyForces(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+		return;
+	}
+
 	const auto numBodies = GetNumBodies();
 	for (size_t i = 0; i < numBodies; i++)
 	{
@@ -77,5 +251,9 @@ void Simulation::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX
 			bodiesVerticalSpeed[i] *= -1;
 		}
 	}
+
+	// Obstacles are a separate pass, so the loop above stays as simple to vectorize as without them
+	if (_obstacles)
+		_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, numBodies);
 }
 } // namespace kinematics
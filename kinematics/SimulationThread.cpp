@@ -0,0 +1,222 @@
+#include "SimulationThread.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+namespace kinematics
+{
+using Clock = std::chrono::steady_clock;
+
+SimulationThread::SimulationThread(std::unique_ptr<Simulation> simulation, const float timeStep, std::string backend)
+	: _simulation(std::move(simulation)), _timeStep(timeStep), _paused(false), _backend(std::move(backend)),
+	  _swapMilliseconds(0), _thread([this](std::stop_token stopToken) { Run(stopToken); })
+{
+}
+
+SimulationThread::~SimulationThread() = default;
+
+void SimulationThread::SetNumBodies(const size_t totalNumBodies)
+{
+	std::scoped_lock lock(_requestMutex);
+	_requestedNumBodies = totalNumBodies;
+}
+
+void SimulationThread::SetBounds(const float width, const float height)
+{
+	std::scoped_lock lock(_requestMutex);
+	_requestedBounds = {width, height};
+}
+
+void SimulationThread::SetForces(std::optional<Forces> forces)
+{
+	std::scoped_lock lock(_requestMutex);
+	_requestedForces = std::move(forces);
+}
+
+void SimulationThread::SetPaused(const bool paused) { _paused = paused; }
+
+void SimulationThread::SetBackend(std::string name, BackendFactory create)
+{
+	std::scoped_lock lock(_requestMutex);
+	_requestedBackend.emplace(std::move(name), std::move(create));
+}
+
+float SimulationThread::GetTimeStep() const { return _timeStep; }
+
+const SimulationThread::StepTimes &SimulationThread::GetStepTimes() const { return _stepTimes; }
+
+const SteppedFrame &SimulationThread::AcquireFrame() { return _frames.Acquire(); }
+
+const SteppedFrame &SimulationThread::Interpolate(BodyFrame &frame, const Clock::time_point now)
+{
+	const auto &stepped = AcquireFrame();
+
+	// Progress from `previous` to `current` over the same amount of time it took to publish `current`. Normally that
+	// is a single time step, but when the simulation can't keep up it is drawn in slow motion rather than stuttering.
+	const auto interval = std::chrono::duration<float>(std::max(stepped.interval, Clock::duration(1)));
+	const float alpha = std::clamp(std::chrono::duration<float>(now - stepped.time) / interval, 0.f, 1.f);
+
+	const auto numBodies = stepped.current.x.size();
+	frame.x.resize(numBodies);
+	frame.y.resize(numBodies);
+	frame.color.assign(stepped.current.color.cbegin(), stepped.current.color.cend());
+
+	const float *__restrict__ previousX = stepped.previous.x.data();
+	const float *__restrict__ previousY = stepped.previous.y.data();
+	const float *__restrict__ currentX = stepped.current.x.data();
+	const float *__restrict__ currentY = stepped.current.y.data();
+	float *__restrict__ x = frame.x.data();
+	float *__restrict__ y = frame.y.data();
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		x[i] = previousX[i] + (currentX[i] - previousX[i]) * alpha;
+		y[i] = previousY[i] + (currentY[i] - previousY[i]) * alpha;
+	}
+
+	return stepped;
+}
+
+bool SimulationThread::ApplyRequests()
+{
+	std::optional<size_t> numBodies;
+	std::optional<std::pair<float, float>> bounds;
+	std::optional<std::pair<std::string, BackendFactory>> backend;
+	std::optional<std::optional<Forces>> forces;
+	{
+		std::scoped_lock lock(_requestMutex);
+		numBodies.swap(_requestedNumBodies);
+		bounds.swap(_requestedBounds);
+		backend.swap(_requestedBackend);
+		forces.swap(_requestedForces);
+	}
+
+	if (bounds)
+		_simulation->SetBounds(bounds->first, bounds->second);
+
+	// Backends with a fixed capacity keep as many bodies as they can hold rather than overrun it, and aren't swapped to
+	// while there are more bodies than that. Bodies are set before a swap, so they have to fit both.
+	const auto capacity = [](const std::string_view name) {
+		const auto *registered = FindBackend(name);
+		return registered ? registered->maxBodies : std::numeric_limits<size_t>::max();
+	};
+	if (numBodies)
+	{
+		numBodies = std::min({*numBodies, capacity(_backend), backend ? capacity(backend->first) : *numBodies});
+		_simulation->SetNumBodies(*numBodies);
+	}
+	if (backend && _simulation->GetNumBodies() > capacity(backend->first))
+		backend.reset();
+
+	if (backend)
+	{
+		KINEMATICS_TRACE_SCOPE("SimulationThread::SetBackend");
+		const auto start = Clock::now();
+		_simulation = backend->second(_simulation->GetWidth(), _simulation->GetHeight(), *_simulation);
+		_swapMilliseconds = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		_backend = std::move(backend->first);
+	}
+	if (forces)
+		_forces = std::move(*forces);
+	if (forces || backend)
+		_simulation->SetForces(_forces ? &*_forces : nullptr);
+
+	return numBodies || bounds || backend;
+}
+
+void SimulationThread::Run(std::stop_token stopToken)
+{
+	KINEMATICS_TRACE_THREAD("simulation");
+
+	const auto timeStep = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(_timeStep));
+
+	uint64_t numSteps = 0;
+	auto lastTime = Clock::now();
+	auto lastPublish = lastTime;
+	Clock::duration accumulator{};
+
+	// Steps per second is measured over (at least) one second windows
+	auto rateStart = lastTime;
+	uint64_t rateSteps = 0;
+	float stepsPerSecond = 0;
+
+	// Publish the state as-is, such as at startup or after a change while not taking steps
+	auto publishUnchanged = [&](SteppedFrame &frame) {
+		_simulation->CopyFrame(frame.current);
+		frame.previous = frame.current;
+		frame.step = numSteps;
+		frame.time = Clock::now();
+		frame.interval = timeStep;
+		frame.backend = _backend;
+		frame.swapMilliseconds = _swapMilliseconds;
+		_frames.Publish();
+	};
+	publishUnchanged(_frames.Back());
+
+	while (!stopToken.stop_requested())
+	{
+		const bool changed = ApplyRequests();
+
+		const auto now = Clock::now();
+		accumulator += now - lastTime;
+		lastTime = now;
+
+		if (_paused)
+			accumulator = {};
+
+		if (accumulator < timeStep)
+		{
+			if (changed)
+				publishUnchanged(_frames.Back());
+
+			std::this_thread::sleep_for(_paused ? timeStep : timeStep - accumulator);
+			continue;
+		}
+
+		// Rather than fall further and further behind, drop time that can't be caught up on
+		accumulator = std::min(accumulator, timeStep * MAX_STEPS_PER_PUBLISH);
+		const auto stepsToTake = accumulator / timeStep;
+		accumulator -= timeStep * stepsToTake;
+
+		auto &frame = _frames.Back();
+		Clock::duration updateTime{};
+		for (auto i = 0; i < stepsToTake; i++)
+		{
+			if (i == stepsToTake - 1)
+				_simulation->CopyFrame(frame.previous);
+
+			const auto startUpdate = Clock::now();
+			_simulation->Update(_timeStep);
+			const auto stepTime = Clock::now() - startUpdate;
+
+			updateTime += stepTime;
+			_stepTimes.Push(std::chrono::duration<float, std::micro>(stepTime).count());
+		}
+		_simulation->CopyFrame(frame.current);
+
+		numSteps += static_cast<uint64_t>(stepsToTake);
+		rateSteps += static_cast<uint64_t>(stepsToTake);
+
+		const auto publishTime = Clock::now();
+		if (publishTime - rateStart >= std::chrono::seconds(1))
+		{
+			const auto rateSeconds = std::chrono::duration<float>(publishTime - rateStart).count();
+			stepsPerSecond = static_cast<float>(rateSteps) / rateSeconds;
+			rateStart = publishTime;
+			rateSteps = 0;
+		}
+
+		frame.step = numSteps;
+		frame.time = publishTime;
+		frame.interval = publishTime - lastPublish;
+		frame.stepMicroseconds =
+			std::chrono::duration<float, std::micro>(updateTime).count() / static_cast<float>(stepsToTake);
+		frame.stepsPerSecond = stepsPerSecond;
+		frame.backend = _backend;
+		frame.swapMilliseconds = _swapMilliseconds;
+		_frames.Publish();
+
+		lastPublish = publishTime;
+	}
+}
+} // namespace kinematics
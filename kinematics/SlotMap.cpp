@@ -0,0 +1,78 @@
+#include "SlotMap.h"
+#include <cassert>
+
+namespace kinematics
+{
+BodyHandle SlotMap::Add()
+{
+	const auto index = static_cast<uint32_t>(_slotOfIndex.size());
+	assert(index != NO_SLOT);
+
+	uint32_t slot = _firstFree;
+	if (slot == NO_SLOT)
+	{
+		slot = static_cast<uint32_t>(_slots.size());
+		_slots.push_back({index, 0});
+	}
+	else
+	{
+		_firstFree = _slots[slot].index;
+		_slots[slot].index = index;
+	}
+
+	_slotOfIndex.push_back(slot);
+	return {slot, _slots[slot].generation};
+}
+
+size_t SlotMap::Remove(const BodyHandle handle)
+{
+	assert(Contains(handle));
+
+	// The last element moves into the removed one's index, so only its slot changes
+	const auto index = _slots[handle.slot].index;
+	const auto lastSlot = _slotOfIndex.back();
+	_slots[lastSlot].index = index;
+	_slotOfIndex[index] = lastSlot;
+	_slotOfIndex.pop_back();
+
+	// Freeing the slot makes every handle given out for it stale
+	auto &slot = _slots[handle.slot];
+	slot.generation++;
+	slot.index = _firstFree;
+	_firstFree = handle.slot;
+
+	return index;
+}
+
+void SlotMap::Resize(const size_t size)
+{
+	while (GetSize() < size)
+		Add();
+	while (GetSize() > size)
+		Remove(GetHandle(GetSize() - 1));
+}
+
+bool SlotMap::Contains(const BodyHandle handle) const
+{
+	// Freeing a slot changes its generation, so only handles given out since it was last reused match. Checking the
+	// slot is in use as well rejects handles that were never given out.
+	if (handle.slot >= _slots.size() || _slots[handle.slot].generation != handle.generation)
+		return false;
+	const auto index = _slots[handle.slot].index;
+	return index < _slotOfIndex.size() && _slotOfIndex[index] == handle.slot;
+}
+
+size_t SlotMap::GetIndex(const BodyHandle handle) const
+{
+	assert(Contains(handle));
+	return _slots[handle.slot].index;
+}
+
+BodyHandle SlotMap::GetHandle(const size_t index) const
+{
+	const auto slot = _slotOfIndex[index];
+	return {slot, _slots[slot].generation};
+}
+
+size_t SlotMap::GetSize() const { return _slotOfIndex.size(); }
+} // namespace kinematics
@@ -0,0 +1,85 @@
+#include "SlotMapSim.h"
+#include "Tracing.h"
+#include <cassert>
+
+namespace kinematics
+{
+SlotMapSim::SlotMapSim(const float width, const float height, const size_t numBodies)
+	: StructOfVectorSim(width, height, numBodies)
+{
+	// Bodies were added before there was a map to give them handles
+	_handles.Resize(GetNumBodies());
+}
+
+SlotMapSim::SlotMapSim(const float width, const float height, const Simulation &toCopy)
+	: StructOfVectorSim(width, height, toCopy)
+{
+	_handles.Resize(GetNumBodies());
+}
+
+void SlotMapSim::SetNumBodies(const size_t totalNumBodies)
+{
+	KINEMATICS_TRACE_SCOPE("SlotMapSim::SetNumBodies");
+
+	StructOfVectorSim::SetNumBodies(totalNumBodies);
+	_handles.Resize(totalNumBodies);
+}
+
+BodyHandle SlotMapSim::AddBody(const Body body)
+{
+	_bodies.x.push_back(body.x);
+	_bodies.y.push_back(body.y);
+
+	_bodies.horizontalSpeed.push_back(body.horizontalSpeed);
+	_bodies.verticalSpeed.push_back(body.verticalSpeed);
+
+	_bodies.color.push_back(body.color);
+
+	const auto handle = _handles.Add();
+	RebuildSpatialIndex();
+	return handle;
+}
+
+void SlotMapSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                              const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+                              const Color *__restrict__ color, const size_t numBodies)
+{
+	StructOfVectorSim::AppendBodies(x, y, horizontalSpeed, verticalSpeed, color, numBodies);
+	_handles.Resize(GetNumBodies());
+}
+
+bool SlotMapSim::RemoveBody(const BodyHandle handle)
+{
+	if (!_handles.Contains(handle))
+		return false;
+
+	// Same move of the last body into the removed one's place as the map made, to each array
+	const auto index = _handles.Remove(handle);
+	const auto removeFrom = [index](auto &values) {
+		values[index] = values.back();
+		values.pop_back();
+	};
+	removeFrom(_bodies.x);
+	removeFrom(_bodies.y);
+	removeFrom(_bodies.horizontalSpeed);
+	removeFrom(_bodies.verticalSpeed);
+	removeFrom(_bodies.color);
+
+	assert(_handles.GetSize() == GetNumBodies());
+	RebuildSpatialIndex();
+	return true;
+}
+
+bool SlotMapSim::Contains(const BodyHandle handle) const { return _handles.Contains(handle); }
+
+Body SlotMapSim::GetBody(const BodyHandle handle) const
+{
+	const auto index = GetIndex(handle);
+	return {_bodies.x[index], _bodies.y[index], _bodies.horizontalSpeed[index], _bodies.verticalSpeed[index],
+	        _bodies.color[index]};
+}
+
+size_t SlotMapSim::GetIndex(const BodyHandle handle) const { return _handles.GetIndex(handle); }
+
+BodyHandle SlotMapSim::GetHandle(const size_t index) const { return _handles.GetHandle(index); }
+} // namespace kinematics
@@ -0,0 +1,231 @@
+#include "SpatialIndex.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace kinematics
+{
+void SpatialIndex::Build(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies,
+                         const float width, const float height)
+{
+	BuildFrom([bodiesX](const size_t i) { return bodiesX[i]; }, [bodiesY](const size_t i) { return bodiesY[i]; },
+	          numBodies, width, height);
+}
+
+void SpatialIndex::Build(std::span<const Body> bodies, const float width, const float height)
+{
+	BuildFrom([bodies](const size_t i) { return bodies[i].x; }, [bodies](const size_t i) { return bodies[i].y; },
+	          bodies.size(), width, height);
+}
+
+template <typename GetX, typename GetY>
+void SpatialIndex::BuildFrom(const GetX &getX, const GetY &getY, const size_t numBodies, const float width,
+                             const float height)
+{
+	KINEMATICS_TRACE_SCOPE("SpatialIndex::Build");
+	assert(numBodies < std::numeric_limits<uint32_t>::max());
+
+	// Square cells, sized for the bodies to average `BODIES_PER_CELL` per cell if spread evenly
+	const auto area = std::max(width * height, 1.f);
+	const auto bodies = static_cast<float>(std::max<size_t>(numBodies, 1));
+	_cellSize = std::max(std::sqrt(area * BODIES_PER_CELL / bodies), 1.f);
+	_inverseCellSize = 1 / _cellSize;
+	_columns = std::max(1, static_cast<int>(std::ceil(width * _inverseCellSize)));
+	_rows = std::max(1, static_cast<int>(std::ceil(height * _inverseCellSize)));
+	const auto numCells = static_cast<size_t>(_columns) * static_cast<size_t>(_rows);
+
+	_cells.resize(numBodies);
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		const auto column = static_cast<uint32_t>(GetCell(getX(i), _columns));
+		const auto row = static_cast<uint32_t>(GetCell(getY(i), _rows));
+		_cells[i] = row * static_cast<uint32_t>(_columns) + column;
+	}
+
+	// Counting sort by cell. Counts start one cell along so that, once scanned, placing each body moves its cell's
+	// entry from the start of the cell to the end of it, which is the start of the next cell.
+	_cellStart.assign(numCells + 1, 0);
+	for (size_t i = 0; i < numBodies; i++)
+		_cellStart[_cells[i] + 1]++;
+
+	uint32_t start = 0;
+	for (size_t cell = 1; cell <= numCells; cell++)
+		start += std::exchange(_cellStart[cell], start);
+
+	_indices.resize(numBodies);
+	_positions.resize(numBodies);
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		const auto destination = _cellStart[_cells[i] + 1]++;
+		_indices[destination] = static_cast<uint32_t>(i);
+		_positions[destination] = {getX(i), getY(i)};
+	}
+}
+
+int SpatialIndex::GetCell(const float position, const int numCells) const
+{
+	// Clamped first, as converting a float that doesn't fit in an int is undefined. Unlike `std::clamp`, `fmin` takes
+	// NaN to a cell too.
+	return static_cast<int>(std::fmax(0.f, std::fmin(position * _inverseCellSize, static_cast<float>(numCells - 1))));
+}
+
+template <typename Function> void SpatialIndex::ForEachRow(const Rectangle &area, const Function &function) const
+{
+	if (_cellStart.empty() || area.width < 0 || area.height < 0)
+		return;
+
+	const auto firstColumn = GetCell(area.x, _columns), lastColumn = GetCell(area.x + area.width, _columns);
+	const auto firstRow = GetCell(area.y, _rows), lastRow = GetCell(area.y + area.height, _rows);
+	for (auto row = firstRow; row <= lastRow; row++)
+	{
+		const auto rowStart = static_cast<size_t>(row) * static_cast<size_t>(_columns);
+		if (!function(_cellStart[rowStart + static_cast<size_t>(firstColumn)],
+		              _cellStart[rowStart + static_cast<size_t>(lastColumn) + 1]))
+			return;
+	}
+}
+
+std::span<const uint32_t> SpatialIndex::QueryRectangle(const Rectangle &area, std::span<uint32_t> results) const
+{
+	const auto left = area.x, top = area.y, right = area.x + area.width, bottom = area.y + area.height;
+	size_t count = 0;
+	ForEachRow(area, [&](const uint32_t begin, const uint32_t end) {
+		for (auto i = begin; i < end && count < results.size(); i++)
+		{
+			const auto [x, y] = _positions[i];
+			if (x >= left && x <= right && y >= top && y <= bottom)
+				results[count++] = _indices[i];
+		}
+		return count < results.size();
+	});
+	return results.first(count);
+}
+
+std::span<const uint32_t> SpatialIndex::QueryRadius(const Vector2 center, const float radius,
+                                                    std::span<uint32_t> results) const
+{
+	const auto radiusSquared = radius * radius;
+	size_t count = 0;
+	ForEachRow({center.x - radius, center.y - radius, 2 * radius, 2 * radius},
+	           [&](const uint32_t begin, const uint32_t end) {
+		           for (auto i = begin; i < end && count < results.size(); i++)
+		           {
+			           const auto dx = _positions[i].x - center.x, dy = _positions[i].y - center.y;
+			           if (dx * dx + dy * dy <= radiusSquared)
+				           results[count++] = _indices[i];
+		           }
+		           return count < results.size();
+	           });
+	return results.first(count);
+}
+
+std::span<const uint32_t> SpatialIndex::FindNearest(const Vector2 point, std::span<uint32_t> results) const
+{
+	const auto k = std::min(results.size(), _indices.size());
+	if (!k)
+		return {};
+
+	// The nearest bodies so far are kept as a max heap of their sorted positions in `results`, with the furthest of
+	// them on top to be replaced by anything nearer
+	const auto distanceSquared = [&](const uint32_t i) {
+		const auto dx = _positions[i].x - point.x, dy = _positions[i].y - point.y;
+		return dx * dx + dy * dy;
+	};
+	const auto nearer = [&](const uint32_t a, const uint32_t b) { return distanceSquared(a) < distanceSquared(b); };
+	size_t count = 0;
+	const auto consider = [&](const uint32_t begin, const uint32_t end) {
+		for (auto i = begin; i < end; i++)
+		{
+			if (count < k)
+			{
+				results[count++] = i;
+				std::push_heap(results.begin(), results.begin() + static_cast<ptrdiff_t>(count), nearer);
+			}
+			else if (distanceSquared(i) < distanceSquared(results[0]))
+			{
+				std::pop_heap(results.begin(), results.begin() + static_cast<ptrdiff_t>(k), nearer);
+				results[k - 1] = i;
+				std::push_heap(results.begin(), results.begin() + static_cast<ptrdiff_t>(k), nearer);
+			}
+		}
+	};
+
+	// Search rings of cells outwards from the point's cell. Cells beyond a ring are at least as far as the edge of
+	// the square it encloses, so once the heap is full and its furthest body is nearer than that, the search is done.
+	const auto centerColumn = GetCell(point.x, _columns), centerRow = GetCell(point.y, _rows);
+	const auto considerRow = [&](const int row, const int firstColumn, const int lastColumn) {
+		if (row < 0 || row >= _rows)
+			return;
+		const auto rowStart = static_cast<size_t>(row) * static_cast<size_t>(_columns);
+		consider(_cellStart[rowStart + static_cast<size_t>(std::max(firstColumn, 0))],
+		         _cellStart[rowStart + static_cast<size_t>(std::min(lastColumn, _columns - 1)) + 1]);
+	};
+	for (int ring = 0;; ring++)
+	{
+		const auto firstColumn = centerColumn - ring, lastColumn = centerColumn + ring;
+		const auto firstRow = centerRow - ring, lastRow = centerRow + ring;
+		considerRow(firstRow, firstColumn, lastColumn);
+		for (auto row = firstRow + 1; row < lastRow; row++)
+		{
+			if (firstColumn >= 0)
+				considerRow(row, firstColumn, firstColumn);
+			if (lastColumn < _columns)
+				considerRow(row, lastColumn, lastColumn);
+		}
+		if (lastRow != firstRow)
+			considerRow(lastRow, firstColumn, lastColumn);
+
+		if (firstColumn <= 0 && lastColumn >= _columns - 1 && firstRow <= 0 && lastRow >= _rows - 1)
+			break;
+		if (count == k)
+		{
+			const auto edge = std::min({point.x - static_cast<float>(firstColumn) * _cellSize,
+			                            static_cast<float>(lastColumn + 1) * _cellSize - point.x,
+			                            point.y - static_cast<float>(firstRow) * _cellSize,
+			                            static_cast<float>(lastRow + 1) * _cellSize - point.y});
+			if (edge > 0 && edge * edge >= distanceSquared(results[0]))
+				break;
+		}
+	}
+
+	std::sort_heap(results.begin(), results.begin() + static_cast<ptrdiff_t>(k), nearer);
+	for (size_t i = 0; i < k; i++)
+		results[i] = _indices[results[i]];
+	return results.first(k);
+}
+
+void SpatialIndex::QueryRectangles(std::span<const Rectangle> areas, std::span<uint32_t> results,
+                                   std::span<std::span<const uint32_t>> found) const
+{
+	assert(found.size() >= areas.size());
+	const auto share = areas.empty() ? 0 : results.size() / areas.size();
+#pragma omp parallel for schedule(dynamic, 16)
+	for (size_t i = 0; i < areas.size(); i++)
+		found[i] = QueryRectangle(areas[i], results.subspan(i * share, share));
+}
+
+void SpatialIndex::QueryRadii(std::span<const Vector2> centers, const float radius, std::span<uint32_t> results,
+                              std::span<std::span<const uint32_t>> found) const
+{
+	assert(found.size() >= centers.size());
+	const auto share = centers.empty() ? 0 : results.size() / centers.size();
+#pragma omp parallel for schedule(dynamic, 16)
+	for (size_t i = 0; i < centers.size(); i++)
+		found[i] = QueryRadius(centers[i], radius, results.subspan(i * share, share));
+}
+
+void SpatialIndex::FindNearest(std::span<const Vector2> points, std::span<uint32_t> results,
+                               std::span<std::span<const uint32_t>> found) const
+{
+	assert(found.size() >= points.size());
+	const auto share = points.empty() ? 0 : results.size() / points.size();
+#pragma omp parallel for schedule(dynamic, 16)
+	for (size_t i = 0; i < points.size(); i++)
+		found[i] = FindNearest(points[i], results.subspan(i * share, share));
+}
+
+size_t SpatialIndex::GetNumBodies() const { return _indices.size(); }
+} // namespace kinematics
@@ -1,4 +1,8 @@
 #include "kinematics.h"
+#include "ObstacleGrid.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <raylib.h>
@@ -36,10 +40,7 @@ StructOfAlignedSim::StructOfAlignedSim(const float width, const float height, co
 
 	_bodies.color = new Color[totalNumBodies];
 
-	for (const auto &body : toCopy.GetBodies())
-	{
-		AddBody(body);
-	}
+	AddBodies(toCopy.GetBodies());
 
 	assert(_numBodies == totalNumBodies);
 }
@@ -57,6 +58,8 @@ StructOfAlignedSim::~StructOfAlignedSim()
 
 std::vector<Body> StructOfAlignedSim::GetBodies() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfAlignedSim::GetBodies");
+
 	std::vector<Body> copy;
 	copy.reserve(GetNumBodies());
 
@@ -70,91 +73,116 @@ std::vector<Body> StructOfAlignedSim::GetBodies() const
 	return copy;
 }
 
+void StructOfAlignedSim::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.assign(_bodies.x, _bodies.x + numBodies);
+	frame.y.assign(_bodies.y, _bodies.y + numBodies);
+	frame.color.assign(_bodies.color, _bodies.color + numBodies);
+	frame.radius.clear();
+}
+
 void StructOfAlignedSim::Update(const float deltaTime)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfAlignedSim::Update");
+
 	UpdateHelper(deltaTime, _bodies.x, _bodies.y, _bodies.horizontalSpeed, _bodies.verticalSpeed);
+	UpdateSpatialIndex(_bodies.x, _bodies.y);
 }
 
 void StructOfAlignedSim::Draw() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfAlignedSim::Draw");
+
 	// `Draw()` should not be called when a window is not available
 	assert(IsWindowReady());
 
-	const auto numBodies = GetNumBodies();
-	for (size_t i = 0; i < numBodies; i++)
-	{
-		DrawTexture(_bodyRender.texture, static_cast<int>(_bodies.x[i] - BODY_RADIUS),
-		            static_cast<int>(_bodies.y[i] - BODY_RADIUS), _bodies.color[i]);
-	}
+	GetRenderer().Draw(_bodies.x, _bodies.y, _bodies.color, GetNumBodies());
 }
 
 void StructOfAlignedSim::SetNumBodies(const size_t totalNumBodies)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfAlignedSim::SetNumBodies");
+
 	if (totalNumBodies > _maxBodies)
 	{
-		// Lazy way to preserve the old bodies
-		auto oldBodies = GetBodies();
-
-		// Free previous memory
-		::operator delete[](_bodies.x, ALIGNMENT);
-		::operator delete[](_bodies.y, ALIGNMENT);
-
-		::operator delete[](_bodies.horizontalSpeed, ALIGNMENT);
-		::operator delete[](_bodies.verticalSpeed, ALIGNMENT);
-
-		delete[] _bodies.color;
-
-		// Allocate new memory that can fit all the bodies
-		_bodies.x = new (ALIGNMENT) float[totalNumBodies];
-		_bodies.y = new (ALIGNMENT) float[totalNumBodies];
-		_bodies.horizontalSpeed = new (ALIGNMENT) float[totalNumBodies];
-		_bodies.verticalSpeed = new (ALIGNMENT) float[totalNumBodies];
-
-		_bodies.color = new Color[totalNumBodies];
-
-		// Lazy way to add old bodies back
-		_numBodies = 0;
-		for (const auto &body : oldBodies)
-		{
-			AddBody(body);
-		}
-		_maxBodies = totalNumBodies;
+		Reallocate(totalNumBodies);
 	}
 
 	if (totalNumBodies > GetNumBodies())
 	{
-		for (auto i = GetNumBodies(); i < totalNumBodies; i++)
-		{
-			AddRandomBody();
-		}
+		AddRandomBodies(totalNumBodies - GetNumBodies());
 	}
 	else
 	{
 		_numBodies = totalNumBodies;
 		// Does not shrink, so _maxBodies remains as-is
 	}
+
+	RebuildSpatialIndex();
 }
 
 size_t StructOfAlignedSim::GetNumBodies() const { return _numBodies; }
 
-void StructOfAlignedSim::AddRandomBody() { AddBody(GenerateRandomBody()); }
-
-void StructOfAlignedSim::AddBody(const Body body)
+void StructOfAlignedSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                      const float *__restrict__ horizontalSpeed,
+                                      const float *__restrict__ verticalSpeed, const Color *__restrict__ color,
+                                      const size_t numBodies)
 {
-	_bodies.x[_numBodies] = body.x;
-	_bodies.y[_numBodies] = body.y;
+	// Grows to at least double, so adding a few bodies at a time doesn't copy every body each time
+	if (_numBodies + numBodies > _maxBodies)
+		Reallocate(std::max(_numBodies + numBodies, 2 * _maxBodies));
+
+	std::copy_n(x, numBodies, _bodies.x + _numBodies);
+	std::copy_n(y, numBodies, _bodies.y + _numBodies);
 
-	_bodies.horizontalSpeed[_numBodies] = body.horizontalSpeed;
-	_bodies.verticalSpeed[_numBodies] = body.verticalSpeed;
+	std::copy_n(horizontalSpeed, numBodies, _bodies.horizontalSpeed + _numBodies);
+	std::copy_n(verticalSpeed, numBodies, _bodies.verticalSpeed + _numBodies);
 
-	_bodies.color[_numBodies] = body.color;
-	_numBodies++;
+	std::copy_n(color, numBodies, _bodies.color + _numBodies);
+	_numBodies += numBodies;
+}
+
+void StructOfAlignedSim::Reallocate(const size_t maxBodies)
+{
+	// Copy the bodies to memory that can fit `maxBodies`, then free the previous memory
+	const auto moveTo = [numBodies = _numBodies](float *&values, float *newValues) {
+		std::copy_n(values, numBodies, newValues);
+		::operator delete[](values, ALIGNMENT);
+		values = newValues;
+	};
+	moveTo(_bodies.x, new (ALIGNMENT) float[maxBodies]);
+	moveTo(_bodies.y, new (ALIGNMENT) float[maxBodies]);
+
+	moveTo(_bodies.horizontalSpeed, new (ALIGNMENT) float[maxBodies]);
+	moveTo(_bodies.verticalSpeed, new (ALIGNMENT) float[maxBodies]);
+
+	auto *color = new Color[maxBodies];
+	std::copy_n(_bodies.color, _numBodies, color);
+	delete[] _bodies.color;
+	_bodies.color = color;
+	_maxBodies = maxBodies;
 }
 
 void StructOfAlignedSim::UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
                                       float *__restrict__ bodiesHorizontalSpeed,
                                       float *__restrict__ bodiesVerticalSpeed)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfAlignedSim::UpdateHelper");
+
+	// Bounces are only looked for when something is subscribed to them, otherwise the loop below is unchanged
+	if (_bounceEvents)
+	{
+		UpdateAndRecordBounces(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+		return;
+	}
+
+	if (_forces)
+	{
+		UpdateAndApplyForces(deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed);
+		return;
+	}
+
 	// TODO: is there a better way to declare/enforce alignment
 	bodiesX = std::assume_aligned<ALIGNMENT_SIZE>(bodiesX);
 	bodiesY = std::assume_aligned<ALIGNMENT_SIZE>(bodiesY);
@@ -180,5 +208,8 @@ void StructOfAlignedSim::UpdateHelper(const float deltaTime, float *__restrict__
 			bodiesVerticalSpeed[i] *= -1;
 		}
 	}
+
+	if (_obstacles)
+		_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, numBodies);
 }
 } // namespace kinematics
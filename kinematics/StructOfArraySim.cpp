@@ -1,4 +1,7 @@
 #include "kinematics.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <cassert>
 #include <raylib.h>
 
@@ -19,16 +22,15 @@ StructOfArraySim<size>::StructOfArraySim(const float width, const float height,
 	[[maybe_unused]] const auto totalNumBodies = toCopy.GetNumBodies();
 	assert(size >= totalNumBodies);
 
-	for (const auto &body : toCopy.GetBodies())
-	{
-		AddBody(body);
-	}
+	AddBodies(toCopy.GetBodies());
 
 	assert(_numBodies == totalNumBodies);
 }
 
 template <size_t size> std::vector<Body> StructOfArraySim<size>::GetBodies() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfArraySim::GetBodies");
+
 	std::vector<Body> copy;
 	copy.reserve(GetNumBodies());
 
@@ -42,57 +44,71 @@ template <size_t size> std::vector<Body> StructOfArraySim<size>::GetBodies() con
 	return copy;
 }
 
+template <size_t size> void StructOfArraySim<size>::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.assign(_bodies.x.data(), _bodies.x.data() + numBodies);
+	frame.y.assign(_bodies.y.data(), _bodies.y.data() + numBodies);
+	frame.color.assign(_bodies.color.data(), _bodies.color.data() + numBodies);
+	frame.radius.clear();
+}
+
 template <size_t size> void StructOfArraySim<size>::Update(const float deltaTime)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfArraySim::Update");
+
 	// NOTE: Even without explicit `__restrict__` there was already decent alias detection
 	UpdateHelper(deltaTime, _bodies.x.data(), _bodies.y.data(), _bodies.horizontalSpeed.data(), _bodies.verticalSpeed.data());
+	UpdateSpatialIndex(_bodies.x.data(), _bodies.y.data());
 }
 
 template <size_t size> void StructOfArraySim<size>::Draw() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfArraySim::Draw");
+
 	// `Draw()` should not be called when a window is not available
 	assert(IsWindowReady());
 
-	const auto numBodies = GetNumBodies();
-	for (size_t i = 0; i < numBodies; i++)
-	{
-		DrawTexture(_bodyRender.texture, static_cast<int>(_bodies.x[i] - BODY_RADIUS),
-		            static_cast<int>(_bodies.y[i] - BODY_RADIUS), _bodies.color[i]);
-	}
+	GetRenderer().Draw(_bodies.x.data(), _bodies.y.data(), _bodies.color.data(), GetNumBodies());
 }
 
 template <size_t size> void StructOfArraySim<size>::SetNumBodies(const size_t totalNumBodies)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfArraySim::SetNumBodies");
+
 	assert(totalNumBodies <= size);
 
 	if (totalNumBodies > GetNumBodies())
 	{
-		for (auto i = GetNumBodies(); i < totalNumBodies; i++)
-		{
-			AddRandomBody();
-		}
+		AddRandomBodies(totalNumBodies - GetNumBodies());
 	}
 	else
 	{
 		_numBodies = totalNumBodies;
 	}
+
+	RebuildSpatialIndex();
 }
 
 template <size_t size> size_t StructOfArraySim<size>::GetNumBodies() const { return _numBodies; }
 
-template <size_t size> void StructOfArraySim<size>::AddRandomBody() { AddBody(GenerateRandomBody()); }
-
-template <size_t size> void StructOfArraySim<size>::AddBody(const Body body)
+template <size_t size>
+void StructOfArraySim<size>::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                          const float *__restrict__ horizontalSpeed,
+                                          const float *__restrict__ verticalSpeed, const Color *__restrict__ color,
+                                          const size_t numBodies)
 {
-	_bodies.x[_numBodies] = body.x;
-	_bodies.y[_numBodies] = body.y;
+	assert(_numBodies + numBodies <= size);
+
+	std::copy_n(x, numBodies, _bodies.x.data() + _numBodies);
+	std::copy_n(y, numBodies, _bodies.y.data() + _numBodies);
 
-	_bodies.horizontalSpeed[_numBodies] = body.horizontalSpeed;
-	_bodies.verticalSpeed[_numBodies] = body.verticalSpeed;
+	std::copy_n(horizontalSpeed, numBodies, _bodies.horizontalSpeed.data() + _numBodies);
+	std::copy_n(verticalSpeed, numBodies, _bodies.verticalSpeed.data() + _numBodies);
 
-	_bodies.color[_numBodies] = body.color;
+	std::copy_n(color, numBodies, _bodies.color.data() + _numBodies);
 
-	_numBodies++;
+	_numBodies += numBodies;
 }
 
 // Explicitly instantiate specializations so they can be used from the shared library
@@ -1,4 +1,7 @@
 #include "kinematics.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <algorithm>
 #include <cassert>
 #include <raylib.h>
 #include <vector>
@@ -32,10 +35,7 @@ StructOfPointerSim::StructOfPointerSim(const float width, const float height, co
 
 	_bodies.color = new Color[totalNumBodies];
 
-	for (const auto &body : toCopy.GetBodies())
-	{
-		AddBody(body);
-	}
+	AddBodies(toCopy.GetBodies());
 
 	assert(_numBodies == totalNumBodies);
 }
@@ -53,6 +53,8 @@ StructOfPointerSim::~StructOfPointerSim()
 
 std::vector<Body> StructOfPointerSim::GetBodies() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfPointerSim::GetBodies");
+
 	std::vector<Body> copy;
 	copy.reserve(GetNumBodies());
 
@@ -66,86 +68,93 @@ std::vector<Body> StructOfPointerSim::GetBodies() const
 	return copy;
 }
 
+void StructOfPointerSim::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.assign(_bodies.x, _bodies.x + numBodies);
+	frame.y.assign(_bodies.y, _bodies.y + numBodies);
+	frame.color.assign(_bodies.color, _bodies.color + numBodies);
+	frame.radius.clear();
+}
+
 void StructOfPointerSim::Update(const float deltaTime)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfPointerSim::Update");
+
 	// TODO: is there a better way to use `__restrict__`?
 	UpdateHelper(deltaTime, _bodies.x, _bodies.y, _bodies.horizontalSpeed, _bodies.verticalSpeed);
+	UpdateSpatialIndex(_bodies.x, _bodies.y);
 }
 
 void StructOfPointerSim::Draw() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfPointerSim::Draw");
+
 	// `Draw()` should not be called when a window is not available
 	assert(IsWindowReady());
 
-	const auto numBodies = GetNumBodies();
-	for (size_t i = 0; i < numBodies; i++)
-	{
-		DrawTexture(_bodyRender.texture, static_cast<int>(_bodies.x[i] - BODY_RADIUS),
-		            static_cast<int>(_bodies.y[i] - BODY_RADIUS), _bodies.color[i]);
-	}
+	GetRenderer().Draw(_bodies.x, _bodies.y, _bodies.color, GetNumBodies());
 }
 
 void StructOfPointerSim::SetNumBodies(const size_t totalNumBodies)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfPointerSim::SetNumBodies");
+
 	if (totalNumBodies > _maxBodies)
 	{
-		// Lazy way to preserve the old bodies
-		auto oldBodies = GetBodies();
-
-		// Free previous memory
-		delete[] _bodies.x;
-		delete[] _bodies.y;
-
-		delete[] _bodies.horizontalSpeed;
-		delete[] _bodies.verticalSpeed;
-
-		delete[] _bodies.color;
-
-		// Allocate new memory that can fit all the bodies
-		_bodies.x = new float[totalNumBodies];
-		_bodies.y = new float[totalNumBodies];
-		_bodies.horizontalSpeed = new float[totalNumBodies];
-		_bodies.verticalSpeed = new float[totalNumBodies];
-
-		_bodies.color = new Color[totalNumBodies];
-
-		// Lazy way to add old bodies back
-		_numBodies = 0;
-		for (const auto &body : oldBodies)
-		{
-			AddBody(body);
-		}
-		_maxBodies = totalNumBodies;
+		Reallocate(totalNumBodies);
 	}
 
 	if (totalNumBodies > GetNumBodies())
 	{
-		for (auto i = GetNumBodies(); i < totalNumBodies; i++)
-		{
-			AddRandomBody();
-		}
+		AddRandomBodies(totalNumBodies - GetNumBodies());
 	}
 	else
 	{
 		_numBodies = totalNumBodies;
 		// Does not shrink, so _maxBodies remains as-is
 	}
+
+	RebuildSpatialIndex();
 }
 
 size_t StructOfPointerSim::GetNumBodies() const { return _numBodies; }
 
-void StructOfPointerSim::AddRandomBody() { AddBody(GenerateRandomBody()); }
-
-void StructOfPointerSim::AddBody(const Body body)
+void StructOfPointerSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                      const float *__restrict__ horizontalSpeed,
+                                      const float *__restrict__ verticalSpeed, const Color *__restrict__ color,
+                                      const size_t numBodies)
 {
-	_bodies.x[_numBodies] = body.x;
-	_bodies.y[_numBodies] = body.y;
+	// Grows to at least double, so adding a few bodies at a time doesn't copy every body each time
+	if (_numBodies + numBodies > _maxBodies)
+		Reallocate(std::max(_numBodies + numBodies, 2 * _maxBodies));
+
+	std::copy_n(x, numBodies, _bodies.x + _numBodies);
+	std::copy_n(y, numBodies, _bodies.y + _numBodies);
 
-	_bodies.horizontalSpeed[_numBodies] = body.horizontalSpeed;
-	_bodies.verticalSpeed[_numBodies] = body.verticalSpeed;
+	std::copy_n(horizontalSpeed, numBodies, _bodies.horizontalSpeed + _numBodies);
+	std::copy_n(verticalSpeed, numBodies, _bodies.verticalSpeed + _numBodies);
 
-	_bodies.color[_numBodies] = body.color;
-	_numBodies++;
+	std::copy_n(color, numBodies, _bodies.color + _numBodies);
+	_numBodies += numBodies;
+}
+
+void StructOfPointerSim::Reallocate(const size_t maxBodies)
+{
+	// Copy the bodies to memory that can fit `maxBodies`, then free the previous memory
+	const auto moveTo = [numBodies = _numBodies](auto *&values, auto *newValues) {
+		std::copy_n(values, numBodies, newValues);
+		delete[] values;
+		values = newValues;
+	};
+	moveTo(_bodies.x, new float[maxBodies]);
+	moveTo(_bodies.y, new float[maxBodies]);
+
+	moveTo(_bodies.horizontalSpeed, new float[maxBodies]);
+	moveTo(_bodies.verticalSpeed, new float[maxBodies]);
+
+	moveTo(_bodies.color, new Color[maxBodies]);
+	_maxBodies = maxBodies;
 }
 
 } // namespace kinematics
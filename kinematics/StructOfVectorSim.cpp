@@ -1,4 +1,6 @@
 #include "kinematics.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
 #include <cassert>
 #include <raylib.h>
 #include <vector>
@@ -21,14 +23,13 @@ StructOfVectorSim::StructOfVectorSim(const float width, const float height, cons
 	_bodies.verticalSpeed.reserve(totalNumBodies);
 	_bodies.color.reserve(totalNumBodies);
 
-	for (const auto &body : toCopy.GetBodies())
-	{
-		AddBody(body);
-	}
+	AddBodies(toCopy.GetBodies());
 }
 
 std::vector<Body> StructOfVectorSim::GetBodies() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfVectorSim::GetBodies");
+
 	std::vector<Body> copy;
 	copy.reserve(GetNumBodies());
 
@@ -42,26 +43,37 @@ std::vector<Body> StructOfVectorSim::GetBodies() const
 	return copy;
 }
 
+void StructOfVectorSim::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.assign(_bodies.x.data(), _bodies.x.data() + numBodies);
+	frame.y.assign(_bodies.y.data(), _bodies.y.data() + numBodies);
+	frame.color.assign(_bodies.color.data(), _bodies.color.data() + numBodies);
+	frame.radius.clear();
+}
+
 void StructOfVectorSim::Update(const float deltaTime)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfVectorSim::Update");
+
 	UpdateHelper(deltaTime, _bodies.x.data(), _bodies.y.data(), _bodies.horizontalSpeed.data(), _bodies.verticalSpeed.data());
+	UpdateSpatialIndex(_bodies.x.data(), _bodies.y.data());
 }
 
 void StructOfVectorSim::Draw() const
 {
+	KINEMATICS_TRACE_SCOPE("StructOfVectorSim::Draw");
+
 	// `Draw()` should not be called when a window is not available
 	assert(IsWindowReady());
 
-	const auto numBodies = GetNumBodies();
-	for (size_t i = 0; i < numBodies; i++)
-	{
-		DrawTexture(_bodyRender.texture, static_cast<int>(_bodies.x[i] - BODY_RADIUS),
-		            static_cast<int>(_bodies.y[i] - BODY_RADIUS), _bodies.color[i]);
-	}
+	GetRenderer().Draw(_bodies.x.data(), _bodies.y.data(), _bodies.color.data(), GetNumBodies());
 }
 
 void StructOfVectorSim::SetNumBodies(const size_t totalNumBodies)
 {
+	KINEMATICS_TRACE_SCOPE("StructOfVectorSim::SetNumBodies");
+
 	if (totalNumBodies > GetNumBodies())
 	{
 		_bodies.x.reserve(totalNumBodies);
@@ -70,10 +82,7 @@ void StructOfVectorSim::SetNumBodies(const size_t totalNumBodies)
 		_bodies.verticalSpeed.reserve(totalNumBodies);
 		_bodies.color.reserve(totalNumBodies);
 
-		for (auto i = GetNumBodies(); i < totalNumBodies; i++)
-		{
-			AddRandomBody();
-		}
+		AddRandomBodies(totalNumBodies - GetNumBodies());
 	}
 	else
 	{
@@ -83,21 +92,24 @@ void StructOfVectorSim::SetNumBodies(const size_t totalNumBodies)
 		_bodies.verticalSpeed.resize(totalNumBodies);
 		_bodies.color.resize(totalNumBodies);
 	}
+
+	RebuildSpatialIndex();
 }
 
 size_t StructOfVectorSim::GetNumBodies() const { return _bodies.x.size(); }
 
-void StructOfVectorSim::AddRandomBody() { AddBody(GenerateRandomBody()); }
-
-void StructOfVectorSim::AddBody(const Body body)
+void StructOfVectorSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                     const float *__restrict__ horizontalSpeed,
+                                     const float *__restrict__ verticalSpeed, const Color *__restrict__ color,
+                                     const size_t numBodies)
 {
-	_bodies.x.push_back(body.x);
-	_bodies.y.push_back(body.y);
+	_bodies.x.insert(_bodies.x.end(), x, x + numBodies);
+	_bodies.y.insert(_bodies.y.end(), y, y + numBodies);
 
-	_bodies.horizontalSpeed.push_back(body.horizontalSpeed);
-	_bodies.verticalSpeed.push_back(body.verticalSpeed);
+	_bodies.horizontalSpeed.insert(_bodies.horizontalSpeed.end(), horizontalSpeed, horizontalSpeed + numBodies);
+	_bodies.verticalSpeed.insert(_bodies.verticalSpeed.end(), verticalSpeed, verticalSpeed + numBodies);
 
-	_bodies.color.push_back(body.color);
+	_bodies.color.insert(_bodies.color.end(), color, color + numBodies);
 }
 
 } // namespace kinematics
@@ -0,0 +1,142 @@
+#include "Tracing.h"
+
+#ifdef KINEMATICS_TRACING
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace kinematics::tracing
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Enough for minutes of a few spans per frame on every thread, while bounding memory if left running for hours
+constexpr size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+struct Event
+{
+	const char *name;
+	Clock::time_point start, end;
+};
+
+/// Spans of a single thread. Only that thread records into it, so the lock is uncontended other than while writing
+/// the trace.
+struct ThreadBuffer
+{
+	std::mutex mutex;
+	uint32_t id = 0;
+	std::string name;
+	std::vector<Event> events;
+	size_t dropped = 0;
+};
+
+class Registry
+{
+  public:
+	Registry() : _start(Clock::now()) {}
+
+	// Threads, such as those of OpenMP, can outlive `main`, so buffers are never freed before the trace is written
+	~Registry()
+	{
+		const char *path = std::getenv("KINEMATICS_TRACE_FILE");
+		Write(path && *path ? path : "kinematics-trace.json");
+	}
+
+	Registry(const Registry &) = delete;
+	Registry &operator=(const Registry &) = delete;
+
+	ThreadBuffer &AddThread()
+	{
+		std::scoped_lock lock(_mutex);
+		auto &buffer = *_threads.emplace_back(std::make_unique<ThreadBuffer>());
+		buffer.id = static_cast<uint32_t>(_threads.size());
+		buffer.name = "thread " + std::to_string(buffer.id);
+		return buffer;
+	}
+
+	bool Write(const std::string &path)
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		const auto pid = getpid();
+		const auto microseconds = [this](const Clock::time_point time) {
+			return std::chrono::duration<double, std::micro>(time - _start).count();
+		};
+
+		std::scoped_lock lock(_mutex);
+		file.precision(3);
+		file << std::fixed << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+		bool first = true;
+		for (const auto &thread : _threads)
+		{
+			std::scoped_lock threadLock(thread->mutex);
+			file << (first ? "\n" : ",\n") << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": " << pid
+			     << ", \"tid\": " << thread->id << ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+			first = false;
+
+			for (const auto &event : thread->events)
+			{
+				file << ",\n{\"ph\": \"X\", \"name\": \"" << event.name << "\", \"pid\": " << pid
+				     << ", \"tid\": " << thread->id << ", \"ts\": " << microseconds(event.start)
+				     << ", \"dur\": " << microseconds(event.end) - microseconds(event.start) << "}";
+			}
+			if (thread->dropped)
+			{
+				file << ",\n{\"ph\": \"i\", \"s\": \"t\", \"name\": \"" << thread->dropped
+				     << " spans dropped\", \"pid\": " << pid << ", \"tid\": " << thread->id
+				     << ", \"ts\": " << microseconds(thread->events.back().end) << "}";
+			}
+		}
+		file << "\n]}\n";
+
+		return static_cast<bool>(file);
+	}
+
+  private:
+	std::mutex _mutex;
+	Clock::time_point _start;
+	std::vector<std::unique_ptr<ThreadBuffer>> _threads;
+};
+
+Registry &GetRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+ThreadBuffer &GetThreadBuffer()
+{
+	thread_local ThreadBuffer &buffer = GetRegistry().AddThread();
+	return buffer;
+}
+} // namespace
+
+Span::~Span()
+{
+	const auto end = Clock::now();
+	auto &buffer = GetThreadBuffer();
+
+	std::scoped_lock lock(buffer.mutex);
+	if (buffer.events.size() < MAX_EVENTS_PER_THREAD)
+		buffer.events.push_back({_name, _start, end});
+	else
+		buffer.dropped++;
+}
+
+void SetThreadName(std::string name)
+{
+	auto &buffer = GetThreadBuffer();
+	std::scoped_lock lock(buffer.mutex);
+	buffer.name = std::move(name);
+}
+
+bool WriteTrace(const std::string &path) { return GetRegistry().Write(path); }
+} // namespace kinematics::tracing
+#endif
@@ -0,0 +1,247 @@
+#include "kinematics.h"
+#include "BounceEvents.h"
+#include "Forces.h"
+#include "ObstacleGrid.h"
+#include "PointRenderer.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <raylib.h>
+#include <type_traits>
+
+namespace kinematics
+{
+namespace
+{
+/// @returns `radius` as stored in a column of `RadiusType`, rounded and clamped to fit when that's an integer
+template <typename RadiusType> RadiusType ToRadiusType(const float radius)
+{
+	if constexpr (std::is_integral_v<RadiusType>)
+	{
+		constexpr auto MAX = static_cast<float>(std::numeric_limits<RadiusType>::max());
+		return static_cast<RadiusType>(std::clamp(std::round(radius), 0.f, MAX));
+	}
+	else
+	{
+		return radius;
+	}
+}
+} // namespace
+
+template <typename RadiusType>
+VariableRadiusSim<RadiusType>::VariableRadiusSim(const float width, const float height, const size_t numBodies)
+	: Simulation(width, height)
+{
+	// Add an initial `numBodies` bodies to the simulation
+	SetNumBodies(numBodies);
+}
+
+template <typename RadiusType>
+VariableRadiusSim<RadiusType>::VariableRadiusSim(const float width, const float height, const Simulation &toCopy)
+	: Simulation(width, height)
+{
+	const auto bodies = toCopy.GetBodies();
+	const auto radii = toCopy.GetRadii();
+	assert(radii.empty() || radii.size() == bodies.size());
+
+	_bodies.x.reserve(bodies.size());
+	_bodies.y.reserve(bodies.size());
+	_bodies.horizontalSpeed.reserve(bodies.size());
+	_bodies.verticalSpeed.reserve(bodies.size());
+	_bodies.color.reserve(bodies.size());
+	_bodies.radius.reserve(bodies.size());
+
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		AddBody(bodies[i], radii.empty() ? BODY_RADIUS : radii[i]);
+	}
+}
+
+template <typename RadiusType> std::vector<Body> VariableRadiusSim<RadiusType>::GetBodies() const
+{
+	KINEMATICS_TRACE_SCOPE("VariableRadiusSim::GetBodies");
+
+	std::vector<Body> copy;
+	copy.reserve(GetNumBodies());
+
+	const auto numBodies = GetNumBodies();
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		copy.emplace_back(_bodies.x[i], _bodies.y[i], _bodies.horizontalSpeed[i], _bodies.verticalSpeed[i],
+		                  _bodies.color[i]);
+	}
+
+	return copy;
+}
+
+template <typename RadiusType> std::vector<float> VariableRadiusSim<RadiusType>::GetRadii() const
+{
+	return {_bodies.radius.cbegin(), _bodies.radius.cend()};
+}
+
+template <typename RadiusType> void VariableRadiusSim<RadiusType>::CopyFrame(BodyFrame &frame) const
+{
+	const auto numBodies = GetNumBodies();
+	frame.x.assign(_bodies.x.data(), _bodies.x.data() + numBodies);
+	frame.y.assign(_bodies.y.data(), _bodies.y.data() + numBodies);
+	frame.color.assign(_bodies.color.data(), _bodies.color.data() + numBodies);
+	frame.radius.assign(_bodies.radius.data(), _bodies.radius.data() + numBodies);
+}
+
+template <typename RadiusType> void VariableRadiusSim<RadiusType>::Update(const float deltaTime)
+{
+	KINEMATICS_TRACE_SCOPE("VariableRadiusSim::Update");
+
+	float *__restrict__ bodiesX = _bodies.x.data();
+	float *__restrict__ bodiesY = _bodies.y.data();
+	float *__restrict__ bodiesHorizontalSpeed = _bodies.horizontalSpeed.data();
+	float *__restrict__ bodiesVerticalSpeed = _bodies.verticalSpeed.data();
+	const RadiusType *__restrict__ bodiesRadius = _bodies.radius.data();
+	const auto width = _width, height = _height;
+	const auto numBodies = GetNumBodies();
+
+	// Recording isn't worth a SIMD compaction of its own here, so bounces are recorded one body at a time
+	if (_bounceEvents)
+	{
+		if (_forces)
+			Accelerate(*_forces, deltaTime, bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, numBodies);
+
+		_bounceEvents->BeginStep(1);
+		auto &buffer = _bounceEvents->GetBuffer(0);
+		for (size_t i = 0; i < numBodies; i++)
+		{
+			const float radius = bodiesRadius[i];
+			bodiesX[i] += bodiesHorizontalSpeed[i] * deltaTime;
+			bodiesY[i] += bodiesVerticalSpeed[i] * deltaTime;
+
+			if ((bodiesX[i] - radius < 0 && bodiesHorizontalSpeed[i] < 0) ||
+			    (bodiesX[i] + radius > width && bodiesHorizontalSpeed[i] > 0))
+			{
+				buffer.Add({static_cast<uint32_t>(i), bodiesHorizontalSpeed[i] < 0 ? Wall::Left : Wall::Right});
+				bodiesHorizontalSpeed[i] *= -1;
+			}
+
+			if ((bodiesY[i] - radius < 0 && bodiesVerticalSpeed[i] < 0) ||
+			    (bodiesY[i] + radius > height && bodiesVerticalSpeed[i] > 0))
+			{
+				buffer.Add({static_cast<uint32_t>(i), bodiesVerticalSpeed[i] < 0 ? Wall::Top : Wall::Bottom});
+				bodiesVerticalSpeed[i] *= -1;
+			}
+		}
+	}
+	else if (_forces)
+	{
+		UpdateApplyingForces(*_forces, deltaTime, width, height, bodiesX, bodiesY, bodiesHorizontalSpeed,
+		                     bodiesVerticalSpeed, bodiesRadius, 0, numBodies);
+	}
+	else
+	{
+		// Same as `UpdateHelper`, with the radius loaded (and widened, for integers) alongside the other fields
+		for (size_t i = 0; i < numBodies; i++)
+		{
+			const float radius = bodiesRadius[i];
+
+			// Update position based on speed
+			bodiesX[i] += bodiesHorizontalSpeed[i] * deltaTime;
+			bodiesY[i] += bodiesVerticalSpeed[i] * deltaTime;
+
+			// Bounce horizontally
+			if ((bodiesX[i] - radius < 0 && bodiesHorizontalSpeed[i] < 0) ||
+			    (bodiesX[i] + radius > width && bodiesHorizontalSpeed[i] > 0))
+			{
+				bodiesHorizontalSpeed[i] *= -1;
+			}
+
+			// Bounce vertically
+			if ((bodiesY[i] - radius < 0 && bodiesVerticalSpeed[i] < 0) ||
+			    (bodiesY[i] + radius > height && bodiesVerticalSpeed[i] > 0))
+			{
+				bodiesVerticalSpeed[i] *= -1;
+			}
+		}
+	}
+
+	if (_obstacles)
+		_obstacles->Collide(bodiesX, bodiesY, bodiesHorizontalSpeed, bodiesVerticalSpeed, 0, numBodies);
+	UpdateSpatialIndex(bodiesX, bodiesY);
+}
+
+template <typename RadiusType> void VariableRadiusSim<RadiusType>::Draw() const
+{
+	KINEMATICS_TRACE_SCOPE("VariableRadiusSim::Draw");
+
+	// `Draw()` should not be called when a window is not available
+	assert(IsWindowReady());
+
+	GetRenderer().Draw(_bodies.x.data(), _bodies.y.data(), _bodies.color.data(), _bodies.radius.data(),
+	                   GetNumBodies());
+}
+
+template <typename RadiusType> void VariableRadiusSim<RadiusType>::SetNumBodies(const size_t totalNumBodies)
+{
+	KINEMATICS_TRACE_SCOPE("VariableRadiusSim::SetNumBodies");
+
+	if (totalNumBodies > GetNumBodies())
+	{
+		_bodies.x.reserve(totalNumBodies);
+		_bodies.y.reserve(totalNumBodies);
+		_bodies.horizontalSpeed.reserve(totalNumBodies);
+		_bodies.verticalSpeed.reserve(totalNumBodies);
+		_bodies.color.reserve(totalNumBodies);
+		_bodies.radius.reserve(totalNumBodies);
+
+		for (auto i = GetNumBodies(); i < totalNumBodies; i++)
+		{
+			const auto body = GenerateRandomBody();
+			AddBody(body, static_cast<float>(GetRandomValue(MIN_RADIUS, MAX_RADIUS)));
+		}
+	}
+	else
+	{
+		_bodies.x.resize(totalNumBodies);
+		_bodies.y.resize(totalNumBodies);
+		_bodies.horizontalSpeed.resize(totalNumBodies);
+		_bodies.verticalSpeed.resize(totalNumBodies);
+		_bodies.color.resize(totalNumBodies);
+		_bodies.radius.resize(totalNumBodies);
+	}
+
+	RebuildSpatialIndex();
+}
+
+template <typename RadiusType> size_t VariableRadiusSim<RadiusType>::GetNumBodies() const { return _bodies.x.size(); }
+
+template <typename RadiusType>
+void VariableRadiusSim<RadiusType>::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                                 const float *__restrict__ horizontalSpeed,
+                                                 const float *__restrict__ verticalSpeed,
+                                                 const Color *__restrict__ color, const size_t numBodies)
+{
+	_bodies.x.insert(_bodies.x.end(), x, x + numBodies);
+	_bodies.y.insert(_bodies.y.end(), y, y + numBodies);
+
+	_bodies.horizontalSpeed.insert(_bodies.horizontalSpeed.end(), horizontalSpeed, horizontalSpeed + numBodies);
+	_bodies.verticalSpeed.insert(_bodies.verticalSpeed.end(), verticalSpeed, verticalSpeed + numBodies);
+
+	_bodies.color.insert(_bodies.color.end(), color, color + numBodies);
+	_bodies.radius.insert(_bodies.radius.end(), numBodies, ToRadiusType<RadiusType>(BODY_RADIUS));
+}
+
+template <typename RadiusType> void VariableRadiusSim<RadiusType>::AddBody(const Body body, const float radius)
+{
+	_bodies.x.push_back(body.x);
+	_bodies.y.push_back(body.y);
+
+	_bodies.horizontalSpeed.push_back(body.horizontalSpeed);
+	_bodies.verticalSpeed.push_back(body.verticalSpeed);
+
+	_bodies.color.push_back(body.color);
+	_bodies.radius.push_back(ToRadiusType<RadiusType>(radius));
+}
+
+// Explicitly instantiate specializations so they can be used from the shared library
+template class VariableRadiusSim<float>;
+template class VariableRadiusSim<uint8_t>;
+} // namespace kinematics
@@ -1,4 +1,10 @@
 #include "kinematics.h"
+#include "BounceEvents.h"
+#include "Forces.h"
+#include "ObstacleGrid.h"
+#include "PointRenderer.h"
+#include "SpatialIndex.h"
+#include "Tracing.h"
 #include <cassert>
 #include <raylib.h>
 #include <vector>
@@ -23,6 +29,8 @@ VectorOfStructSim::VectorOfStructSim(const float width, const float height, cons
 
 std::vector<Body> VectorOfStructSim::GetBodies() const
 {
+	KINEMATICS_TRACE_SCOPE("VectorOfStructSim::GetBodies");
+
 	std::vector<Body> copy;
 	copy.reserve(GetNumBodies());
 
@@ -35,58 +43,147 @@ std::vector<Body> VectorOfStructSim::GetBodies() const
 	return copy;
 }
 
-void VectorOfStructSim::Update(const float deltaTime)
+void VectorOfStructSim::CopyFrame(BodyFrame &frame) const
 {
-	for (auto &body : _bodies)
+	frame.x.resize(_bodies.size());
+	frame.y.resize(_bodies.size());
+	frame.color.resize(_bodies.size());
+	frame.radius.clear();
+
+	for (size_t i = 0; i < _bodies.size(); i++)
 	{
-		// Update position based on speed
-		body.x += body.horizontalSpeed * deltaTime;
-		body.y += body.verticalSpeed * deltaTime;
+		frame.x[i] = _bodies[i].x;
+		frame.y[i] = _bodies[i].y;
+		frame.color[i] = _bodies[i].color;
+	}
+}
 
-		// Bounce horizontally
-		if (BounceCheck(body.x, body.horizontalSpeed, _width))
+void VectorOfStructSim::Update(const float deltaTime)
+{
+	KINEMATICS_TRACE_SCOPE("VectorOfStructSim::Update");
+
+	// Bodies are interleaved rather than in registers of their own, so bounces are recorded one body at a time
+	if (_bounceEvents)
+	{
+		_bounceEvents->BeginStep(1);
+		auto &buffer = _bounceEvents->GetBuffer(0);
+		for (size_t i = 0; i < _bodies.size(); i++)
 		{
-			body.horizontalSpeed *= -1;
+			auto &body = _bodies[i];
+			if (_forces)
+				Accelerate(*_forces, deltaTime, body.x, body.y, body.horizontalSpeed, body.verticalSpeed, i);
+			body.x += body.horizontalSpeed * deltaTime;
+			body.y += body.verticalSpeed * deltaTime;
+
+			if (BounceCheck(body.x, body.horizontalSpeed, _width))
+			{
+				buffer.Add({static_cast<uint32_t>(i), body.horizontalSpeed < 0 ? Wall::Left : Wall::Right});
+				body.horizontalSpeed *= -1;
+			}
+
+			if (BounceCheck(body.y, body.verticalSpeed, _height))
+			{
+				buffer.Add({static_cast<uint32_t>(i), body.verticalSpeed < 0 ? Wall::Top : Wall::Bottom});
+				body.verticalSpeed *= -1;
+			}
 		}
+	}
+	else if (_forces)
+	{
+		// Interleaved fields don't vectorize well either way, so forces are applied one body at a time
+		for (size_t i = 0; i < _bodies.size(); i++)
+		{
+			auto &body = _bodies[i];
+			Accelerate(*_forces, deltaTime, body.x, body.y, body.horizontalSpeed, body.verticalSpeed, i);
+
+			// Update position based on the new speed
+			body.x += body.horizontalSpeed * deltaTime;
+			body.y += body.verticalSpeed * deltaTime;
 
-		// Bounce vertically
-		if (BounceCheck(body.y, body.verticalSpeed, _height))
+			// Bounce horizontally
+			if (BounceCheck(body.x, body.horizontalSpeed, _width))
+			{
+				body.horizontalSpeed *= -1;
+			}
+
+			// Bounce vertically
+			if (BounceCheck(body.y, body.verticalSpeed, _height))
+			{
+				body.verticalSpeed *= -1;
+			}
+		}
+	}
+	else
+	{
+		for (auto &body : _bodies)
 		{
-			body.verticalSpeed *= -1;
+			// Update position based on speed
+			body.x += body.horizontalSpeed * deltaTime;
+			body.y += body.verticalSpeed * deltaTime;
+
+			// Bounce horizontally
+			if (BounceCheck(body.x, body.horizontalSpeed, _width))
+			{
+				body.horizontalSpeed *= -1;
+			}
+
+			// Bounce vertically
+			if (BounceCheck(body.y, body.verticalSpeed, _height))
+			{
+				body.verticalSpeed *= -1;
+			}
 		}
 	}
+
+	if (_obstacles)
+	{
+		for (auto &body : _bodies)
+			_obstacles->Collide(body.x, body.y, body.horizontalSpeed, body.verticalSpeed);
+	}
+
+	if (_spatialIndex)
+		_spatialIndex->Build(_bodies, _width, _height);
 }
 
 void VectorOfStructSim::Draw() const
 {
+	KINEMATICS_TRACE_SCOPE("VectorOfStructSim::Draw");
+
 	// `Draw()` should not be called when a window is not available
 	assert(IsWindowReady());
 
-	for (const auto &body : _bodies)
-	{
-		DrawTexture(_bodyRender.texture, static_cast<int>(body.x - BODY_RADIUS), static_cast<int>(body.y - BODY_RADIUS),
-		            body.color);
-	}
+	GetRenderer().Draw(_bodies);
 }
 
 void VectorOfStructSim::SetNumBodies(const size_t totalNumBodies)
 {
+	KINEMATICS_TRACE_SCOPE("VectorOfStructSim::SetNumBodies");
+
 	if (totalNumBodies > GetNumBodies())
 	{
 		_bodies.reserve(totalNumBodies);
-		// TODO: maybe refactor this up to super class?
-		for (auto i = GetNumBodies(); i < totalNumBodies; i++)
-		{
-			AddRandomBody();
-		}
+		AddRandomBodies(totalNumBodies - GetNumBodies());
 	}
 	else
 	{
 		_bodies.resize(totalNumBodies);
 	}
+
+	RebuildSpatialIndex();
 }
 
 size_t VectorOfStructSim::GetNumBodies() const { return _bodies.size(); }
 
-void VectorOfStructSim::AddRandomBody() { _bodies.push_back(GenerateRandomBody()); }
+void VectorOfStructSim::AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+                                     const float *__restrict__ horizontalSpeed,
+                                     const float *__restrict__ verticalSpeed, const Color *__restrict__ color,
+                                     const size_t numBodies)
+{
+	const auto first = GetNumBodies();
+	_bodies.resize(first + numBodies);
+	for (size_t i = 0; i < numBodies; i++)
+	{
+		_bodies[first + i] = {x[i], y[i], horizontalSpeed[i], verticalSpeed[i], color[i]};
+	}
+}
 } // namespace kinematics
@@ -0,0 +1,123 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Backends.h"
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// @returns Model name of the CPU as reported by `/proc/cpuinfo`, or "unknown"
+std::string GetCpuModel();
+
+/// Work each step does besides moving bodies and bouncing them off the bounds, which changes which backend is fastest
+struct TuningWorkload
+{
+	const Forces *forces = nullptr;
+	const ObstacleGrid *obstacles = nullptr;
+	bool recordsBounces = false;
+
+	/// @returns Names of the work done, such as "forces, obstacles", or empty for none
+	std::string GetName() const;
+};
+
+/// Picks the fastest CPU backend for a number of bodies on this host by timing `Update()` of every tunable registered
+/// backend that can hold them. Decisions are kept per host, workload and bucket of body counts, both in memory and in a
+/// file, so each bucket is only measured once per host rather than once per run.
+class AutoTuner
+{
+  public:
+	/// @param cachePath File to keep decisions in across runs, or empty to only keep them for the life of the tuner.
+	/// Any problem reading or writing it just results in measuring again.
+	explicit AutoTuner(std::filesystem::path cachePath = GetDefaultCachePath());
+
+	/// @returns The fastest backend for the number of bodies in `current`. Unless a decision is cached for its bucket,
+	/// every candidate is timed updating a copy of those bodies, which can take a moment for millions of bodies.
+	/// @param width Bounds to time the candidates with
+	/// @param height Bounds to time the candidates with
+	/// @param current Bodies to time the candidates with, which are not modified
+	/// @param workload Work to time the candidates doing along with each step. Bounces are recorded somewhere other
+	/// than the subscriber of `current`, which only sees the steps it runs.
+	const Backend &Choose(const float width, const float height, const Simulation &current,
+	                      const TuningWorkload &workload = {});
+
+	/// @returns Bucket that `numBodies` falls in, with one bucket per power of two
+	static unsigned GetBucket(const size_t numBodies);
+
+	/// @returns `$XDG_CACHE_HOME/kinematics-demo/backends.tsv`, falling back to `$HOME/.cache`, or an empty path if
+	/// neither is set
+	static std::filesystem::path GetDefaultCachePath();
+
+  private:
+	const Backend &Measure(const float width, const float height, const Simulation &current,
+	                       const TuningWorkload &workload) const;
+	void Load();
+	void Save() const;
+
+  private:
+	std::filesystem::path _cachePath;
+	std::string _host; // CPU model and number of threads, as either changes which backend is fastest
+
+	// Name of the chosen backend by host, with any workload, and bucket. Decisions for other hosts are kept so saving
+	// doesn't drop them, such as for a home directory shared between machines.
+	std::map<std::pair<std::string, unsigned>, std::string> _decisions;
+};
+
+/// Runs whichever backend `AutoTuner` finds fastest for the current number of bodies, moving the bodies to another
+/// backend when `SetNumBodies()` crosses into a bucket where a different one wins, or when forces, obstacles or bounce
+/// events are turned on or off. Tuning happens on the calling thread, so either can take a moment the first time a
+/// bucket and workload are seen on a host.
+class AutoTunedSim final : public Simulation
+{
+  public:
+	/// @param numBodies The number of bodies to initially add to the simulation
+	/// @param tuner Tuner to choose backends with
+	AutoTunedSim(const float width, const float height, const size_t numBodies, AutoTuner tuner = AutoTuner());
+
+	/// @param toCopy Simulation containing the bodies to initially copy to this simulation. The originals will not be
+	/// modified.
+	/// @param tuner Tuner to choose backends with
+	AutoTunedSim(const float width, const float height, const Simulation &toCopy, AutoTuner tuner = AutoTuner());
+
+	void Update(const float deltaTime) override;
+	void Draw() const override;
+	void SetNumBodies(const size_t totalNumBodies) override;
+	size_t GetNumBodies() const override;
+	std::vector<Body> GetBodies() const override;
+	std::vector<float> GetRadii() const override;
+	void CopyFrame(BodyFrame &frame) const override;
+	void SetBounds(const float width, const float height) override;
+	void SetBounceEvents(BounceEvents *events) override;
+	void SetObstacles(const ObstacleGrid *obstacles) override;
+	void SetForces(const Forces *forces) override;
+	void SetSpatialIndex(SpatialIndex *index) override;
+
+	/// @returns Name of the backend currently running the simulation
+	const std::string &GetBackendName() const;
+
+  private:
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+	/// Nothing to do, as the backend rebuilds the index itself whenever bodies are added or removed
+	void RebuildSpatialIndex() override;
+
+	/// Move the bodies to a backend without a limit on their number, if the current one can't hold `totalNumBodies`
+	void MakeRoom(const size_t totalNumBodies);
+
+	/// Choose the backend for the current number of bodies and workload, and move the bodies to it if it's a different
+	/// one
+	void Tune();
+
+  private:
+	AutoTuner _tuner;
+	const Backend *_backend;
+	std::unique_ptr<Simulation> _simulation;
+	unsigned _bucket;
+};
+} // namespace kinematics
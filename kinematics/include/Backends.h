@@ -0,0 +1,43 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Creates a simulation with the given bounds that starts with a copy of the bodies in `toCopy`
+using BackendFactory =
+	std::function<std::unique_ptr<Simulation>(const float width, const float height, const Simulation &toCopy)>;
+
+/// A `Simulation` implementation that can be chosen by name at runtime
+struct Backend
+{
+	std::string name;
+	BackendFactory create;
+	size_t bytesPerBody;                                   // memory `Update()` streams through for each body
+	size_t maxBodies = std::numeric_limits<size_t>::max(); // largest number of bodies it can hold
+
+	// Must be created, used and destroyed on the thread with the OpenGL context. Such backends may also be unable to
+	// copy bodies, and instead start with as many random ones.
+	bool requiresOpenGl = false;
+
+	// Moves bodies exactly as the others that are tunable do, differing only in layout and how it loops over them, so
+	// `AutoTuner` can swap it in without changing what the simulation does
+	bool tunable = true;
+};
+
+/// @returns Every registered backend, starting with those built in. References stay valid as more are registered.
+const std::deque<Backend> &GetBackends();
+
+/// Add a backend to the registry, replacing any with the same name. Registration isn't synchronized, so should be
+/// done before other threads use the registry.
+void RegisterBackend(Backend backend);
+
+/// @returns The backend called `name`, or `nullptr` if there's none
+const Backend *FindBackend(const std::string_view name);
+} // namespace kinematics
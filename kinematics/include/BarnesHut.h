@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kinematics
+{
+/// Quadtree over the positions of bodies for approximating the gravity between every pair of them in O(N log N)
+/// rather than O(N^2). Groups of bodies far enough away, relative to the size of the node holding them, attract as a
+/// single body at their center of mass.
+///
+/// Rebuilt from scratch every step, in parallel. Bodies are sorted by the Morton code of their position, which puts
+/// the bodies of every node next to each other, and nodes are stored depth first in a single array. Each node knows
+/// where its subtree ends, so walking the tree is a loop forwards through that array, skipping subtrees that are far
+/// enough away, with no stack or pointers to chase. The bodies of each leaf walk the tree together.
+class BarnesHutTree
+{
+  public:
+	/// Nodes with at most this many bodies, or at the deepest level, are leaves with their bodies summed directly
+	static constexpr uint32_t LEAF_SIZE = 32;
+
+	/// Rebuild the tree around the current positions of bodies `[0, numBodies)`
+	void Build(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies);
+
+	/// Find the acceleration of every body from the gravity of every other body, as of the last `Build()`
+	/// @param strength Acceleration towards a single body at a distance of 1, which is its mass times the gravitational
+	/// constant
+	/// @param theta Nodes smaller than `theta` times their distance from a body attract it as a single body. 0 visits
+	/// every body, and larger values are faster but less accurate, with 0.5 a typical balance.
+	/// @param softening Distance added to every pair, so bodies passing very close to each other don't fling apart
+	/// @param accelerationX Acceleration of each body, indexed the same as the positions given to `Build()`
+	void Accelerate(const float strength, const float theta, const float softening, float *__restrict__ accelerationX,
+	                float *__restrict__ accelerationY) const;
+
+	size_t GetNumNodes() const;
+
+  private:
+	struct Node
+	{
+		float x, y;        // center of mass
+		float count;       // number of bodies, as a float as it only ever scales the strength of gravity
+		float sizeSquared; // squared width of the node's square
+
+		// Index of the first node after this node's subtree, which is the next node for a leaf
+		uint32_t next;
+
+		// Bodies of the subtree are `[first, first + numBodies)` of the sorted positions
+		uint32_t first, numBodies;
+	};
+
+	/// Range of bodies, in sorted order, that share the Morton code of a node at `level` deep
+	struct Range
+	{
+		uint32_t first, last;
+		unsigned level;
+	};
+
+	void SortByMortonCode(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies);
+
+	/// Add the ranges of the subtrees that start at `stopLevel` to `_ranges`, in the order they appear in the tree
+	void FindSubtrees(const Range range, const unsigned stopLevel);
+
+	/// Append the subtree of `range` to `nodes`, starting with its root. Levels from `stopLevel` down are left to
+	/// `_subtrees`, appending the next of them instead of building them.
+	void Build(std::vector<Node> &nodes, const Range range, const unsigned stopLevel);
+
+	/// Append a single subtree of `_subtrees`, renumbered to start at the end of `nodes`
+	void AppendSubtree(std::vector<Node> &nodes);
+
+  private:
+	float _size = 0; // width of the root's square
+
+	// Bodies sorted by Morton code, with their original index
+	std::vector<uint32_t> _codes, _order;
+	std::vector<float> _x, _y;
+	std::vector<uint32_t> _scratchCodes, _scratchOrder;
+
+	std::vector<Node> _nodes;
+	std::vector<uint32_t> _leaves; // index of every leaf, in order
+
+	// Ranges that are built in parallel, in the order they appear in the tree, and the trees built for them
+	std::vector<Range> _ranges;
+	std::vector<std::vector<Node>> _subtrees;
+	size_t _nextSubtree = 0;
+};
+
+/// Find the acceleration of every body from the gravity of every other body by summing every pair directly, the same
+/// as `BarnesHutTree::Accelerate()` with a `theta` of 0. Takes O(N^2), so it's only practical for small counts or as a
+/// reference.
+void AccelerateDirectly(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies,
+                        const float strength, const float softening, float *__restrict__ accelerationX,
+                        float *__restrict__ accelerationY);
+} // namespace kinematics
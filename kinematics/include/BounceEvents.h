@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace kinematics
+{
+/// Wall of the simulation bounds that a body bounced off
+enum class Wall : uint32_t
+{
+	Left,
+	Right,
+	Top,
+	Bottom
+};
+
+/// A body reaching a wall and bouncing off it during a step. Exactly 8 bytes, so a register of body indices widened to
+/// 64 bits and combined with the wall is a register of events.
+struct BounceEvent
+{
+	uint32_t body; // index of the body
+	Wall wall;
+
+	bool operator==(const BounceEvent &) const = default;
+};
+static_assert(sizeof(BounceEvent) == 8);
+
+/// Events written by a single thread during a step, kept a cache line apart from the buffers of other threads
+class alignas(64) BounceBuffer
+{
+  public:
+	/// Remove every event, keeping the memory for the next step
+	void Clear();
+
+	/// Append a single event
+	void Add(const BounceEvent event);
+
+	/// @returns Where to write the next events, with room for at least `count` of them. Writes may go past the events
+	/// that are kept, such as whole SIMD registers of which only some lanes are events, until `Commit` is called.
+	BounceEvent *Reserve(const size_t count);
+
+	/// Keep `count` events written after the end of the buffer from `Reserve`
+	void Commit(const size_t count);
+
+	/// @returns Events in the order they were added
+	std::span<const BounceEvent> Get() const;
+
+  private:
+	std::vector<BounceEvent> _events; // only grows, with the first `_count` being events
+	size_t _count = 0;
+};
+
+/// Subscription to the bounces of every step of a `Simulation`, set with `Simulation::SetBounceEvents`. Holds the
+/// bounces of the most recent step only. Parallel implementations write to a buffer per thread so they never contend.
+class BounceEvents
+{
+  public:
+	/// Start a new step, removing the events of the previous one
+	/// @param numThreads Number of threads, and so buffers, that will write events during the step
+	void BeginStep(const size_t numThreads);
+
+	/// @returns Buffer for thread `thread` of the current step to write to
+	BounceBuffer &GetBuffer(const size_t thread);
+
+	/// @returns Every bounce of the most recent step. Threads each cover a contiguous range of bodies, so events are
+	/// in order of body apart from within a single SIMD register of bodies, where they are grouped by wall. Valid until
+	/// the next step.
+	std::span<const BounceEvent> Get();
+
+  private:
+	std::vector<BounceBuffer> _buffers;
+	size_t _numThreads = 0;
+
+	// Events of every buffer, joined on first read when more than one thread wrote events
+	std::vector<BounceEvent> _joined;
+	bool _isJoined = false;
+};
+
+/// Move bodies `[begin, end)` by `deltaTime` and bounce them off the walls of the bounds, the same as
+/// `Simulation::UpdateHelper`, appending an event to `buffer` for every bounce. Bounces are found as a mask per SIMD
+/// register and compacted into events with AVX-512 compress, an AVX2 shuffle table, or one body at a time, depending
+/// on what the target supports.
+void UpdateRecordingBounces(const float deltaTime, const float width, const float height, float *__restrict__ bodiesX,
+                            float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+                            float *__restrict__ bodiesVerticalSpeed, const size_t begin, const size_t end,
+                            BounceBuffer &buffer);
+} // namespace kinematics
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Renders bodies on the CPU by splatting each one into a single pixel of an image the size of the simulation. Meant
+/// for when there are more bodies than pixels, where drawing each body individually is both slow and unreadable.
+/// Each pixel is the average color of the bodies covering it, with more opaque pixels where bodies are more dense.
+///
+/// Bodies are first binned by tile (a band of rows) in parallel, then each thread accumulates whole tiles at a time
+/// in a tile-local buffer that stays in cache, before writing the finished tile into the image.
+class DensityRasterizer
+{
+  public:
+	DensityRasterizer(const int width, const int height);
+
+	/// Change the size of the produced image, typically to match the bounds of the simulation
+	void Resize(const int width, const int height);
+
+	/// Replace the image with the given bodies
+	void Rasterize(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+	               const size_t numBodies);
+
+	void Rasterize(const BodyFrame &frame);
+
+	/// @returns Pixels of the image in row-major order, ready to upload as an RGBA8 texture
+	std::span<const Color> GetPixels() const;
+
+	int GetWidth() const;
+	int GetHeight() const;
+
+	/// Save the image as a binary PPM, which needs no image library. Empty pixels are written as black.
+	/// @returns Whether the file was written
+	bool WritePpm(const std::string &fileName) const;
+
+	/// Save the image as a PNG
+	/// @returns Whether the file was written
+	bool WritePng(const std::string &fileName) const;
+
+  private:
+	/// A body that has been assigned to a tile
+	struct Splat
+	{
+		uint32_t pixel; // index of the pixel relative to the start of the tile
+		Color color;
+	};
+
+	/// Running totals for a single pixel of a tile
+	struct Accumulator
+	{
+		uint32_t r, g, b, count;
+	};
+
+	// Binning slows down drastically once each thread writes to more places than the CPU can track at once, so tiles
+	// are made taller as the image grows rather than more numerous
+	static constexpr int MAX_TILES = 32;
+	static constexpr int MIN_TILE_ROWS = 8;
+
+	int _width, _height, _tileRows, _numTiles;
+	std::vector<Color> _pixels;
+	std::vector<Splat> _splats;
+
+	// Per thread count of bodies, then offset into `_splats`, for each tile. The extra final tile collects bodies
+	// outside the image.
+	std::vector<std::vector<size_t>> _tileOffsets;
+};
+} // namespace kinematics
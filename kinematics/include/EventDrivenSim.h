@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Bodies that are only touched when they bounce. Between bounces a body moves in a straight line, so it's stored as
+/// its position at the time of its last bounce, and the time of its next bounce is known exactly. Those times are
+/// kept in a timing wheel, and a step only visits the slots of the wheel it covers and the bodies due in them, so
+/// costs as much as the number of bounces rather than the number of bodies. Positions are found when they're read.
+///
+/// Forces and obstacles change speeds between bounces, so while either is set every body is moved each step as by
+/// `Simulation::UpdateHelper`, and bounces are scheduled again once neither is.
+class EventDrivenSim final : public Simulation
+{
+  public:
+	/// Width of a slot of the timing wheel in seconds. Several slots make up a typical step.
+	static constexpr double SLOT_SECONDS = 1. / 256;
+
+	/// Number of slots of the timing wheel, which covers 16 seconds. Bounces further away than that stay in their
+	/// slot until the wheel comes round to them enough times.
+	static constexpr uint64_t NUM_SLOTS = 4'096;
+
+	/// Seconds between moving the stored position of every body up to the present, which keeps the time since each
+	/// was stored small enough to be exact as a `float`
+	static constexpr double REBASE_SECONDS = 60;
+
+	/// @param numBodies The number of bodies to initially add to the simulation
+	EventDrivenSim(const float width, const float height, const size_t numBodies);
+
+	/// @param toCopy Simulation containing the bodies to initially copy to this simulation. The originals will not be
+	/// modified.
+	EventDrivenSim(const float width, const float height, const Simulation &toCopy);
+
+	void Update(const float deltaTime) override;
+	void Draw() const override;
+	void SetNumBodies(const size_t totalNumBodies) override;
+	size_t GetNumBodies() const override;
+	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
+	void SetBounds(const float width, const float height) override;
+
+	/// @returns The number of bodies that bounced, or were otherwise visited, in the most recent step
+	size_t GetNumVisited() const;
+
+  private:
+	/// A body's next bounce, in seconds since the simulation was created
+	struct Event
+	{
+		double time;
+		uint32_t body;
+	};
+
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+	/// Find the position of every body at the present into `x` and `y`, which mustn't be the positions of the bodies
+	void FindPositions(float *__restrict__ x, float *__restrict__ y) const;
+
+	/// Store every body's position at the present, so they can be moved as a whole or rescheduled
+	void Rebase();
+
+	/// Add the next bounce of `body` to the wheel
+	void Schedule(const uint32_t body);
+
+	/// Empty the wheel and schedule the next bounce of every body
+	void ScheduleAll();
+
+	/// Move every body by `deltaTime` as `Simulation::UpdateHelper` does, for steps with forces or obstacles
+	void Sweep(const float deltaTime);
+
+	/// @returns The wheel's slot for `time`
+	static uint64_t GetTick(const double time);
+
+  private:
+	struct Bodies
+	{
+		std::vector<float> x, y; // center position as of `time`
+		std::vector<float> horizontalSpeed, verticalSpeed;
+		std::vector<float> time; // seconds since `_epoch` that the position was stored
+		std::vector<Color> color;
+	};
+	Bodies _bodies;
+
+	double _now = 0;   // seconds since the simulation was created
+	double _epoch = 0; // time that body times are relative to
+
+	// Events of slot `s` are those due at a tick equal to `s` modulo `NUM_SLOTS`. Slots up to `_tick` have been
+	// visited, and the wheel is only valid while `_isScheduled`.
+	std::vector<std::vector<Event>> _wheel;
+	uint64_t _tick = 0;
+	bool _isScheduled = false;
+
+	std::vector<uint32_t> _due; // bodies due in the current step
+	size_t _numVisited = 0;
+
+	// Positions found for drawing or the spatial index
+	mutable std::vector<float> _presentX, _presentY;
+};
+} // namespace kinematics
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+namespace kinematics
+{
+/// Force field around a point, such as an attractor following the mouse. Bodies within `range` of the center
+/// accelerate towards it, by `strength` at the center falling off linearly to nothing at `range`. A negative
+/// `strength` pushes bodies away instead.
+struct RadialField
+{
+	float x, y;     // center
+	float strength; // acceleration at the center, in units per second squared
+	float range;
+};
+
+/// Accelerations applied to bodies on every step, set with `Simulation::SetForces`. Velocities are updated before
+/// positions (semi-implicit Euler) in the same loop that moves and bounces bodies, so forces don't add passes over
+/// memory of their own.
+struct Forces
+{
+	Vector2 gravity = {0, 0}; // acceleration of every body, in units per second squared
+	float drag = 0;           // linear drag, as the fraction of its speed a body loses per second
+
+	// Acceleration of each body on top of everything else, indexed by body, or `nullptr` for none. Both or neither
+	// must be set, with at least as many entries as there are bodies.
+	const float *accelerationX = nullptr, *accelerationY = nullptr;
+
+	std::vector<RadialField> fields;
+};
+
+/// Accelerate, move and bounce bodies `[begin, end)` in a single vectorized pass, the same as
+/// `Simulation::UpdateHelper` but with velocities updated by `forces` first
+void UpdateApplyingForces(const Forces &forces, const float deltaTime, const float width, const float height,
+                          float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                          const size_t begin, const size_t end);
+
+/// Same as above, for bodies with a radius each rather than `BODY_RADIUS`
+void UpdateApplyingForces(const Forces &forces, const float deltaTime, const float width, const float height,
+                          float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                          const float *__restrict__ bodiesRadius, const size_t begin, const size_t end);
+
+/// Same as above, for bodies with a radius each in whole units
+void UpdateApplyingForces(const Forces &forces, const float deltaTime, const float width, const float height,
+                          float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed,
+                          const uint8_t *__restrict__ bodiesRadius, const size_t begin, const size_t end);
+
+/// Update the velocities of bodies `[begin, end)` by `forces` without moving them, for steps that move bodies in a
+/// loop of their own such as while recording bounces
+void Accelerate(const Forces &forces, const float deltaTime, const float *__restrict__ bodiesX,
+                const float *__restrict__ bodiesY, float *__restrict__ bodiesHorizontalSpeed,
+                float *__restrict__ bodiesVerticalSpeed, const size_t begin, const size_t end);
+
+/// Update the velocity of a single body, for layouts that don't keep fields in separate arrays
+/// @param body Index of the body, for its own acceleration
+void Accelerate(const Forces &forces, const float deltaTime, const float x, const float y, float &horizontalSpeed,
+                float &verticalSpeed, const size_t body);
+} // namespace kinematics
@@ -0,0 +1,161 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Where a `FrameServer` listens or a `FrameClient` connects to, either a TCP host/port or a Unix domain socket path
+struct StreamAddress
+{
+	enum class Kind
+	{
+		Tcp,
+		Unix
+	};
+
+	Kind kind;
+	std::string host; // IPv4 address for `Kind::Tcp`, socket path for `Kind::Unix`
+	uint16_t port;    // Only used for `Kind::Tcp`, 0 lets the server pick an ephemeral port
+
+	static StreamAddress Tcp(const std::string &host, const uint16_t port);
+	static StreamAddress Unix(const std::string &path);
+};
+
+/// A body as seen by a streaming client. Positions are quantized to whole screen-space pixels, which is all `Draw()`
+/// makes use of anyway.
+struct StreamedBody
+{
+	uint32_t index; // index of the body in the simulation that was published
+	uint16_t x, y;  // truncated center position
+	Color color;
+};
+
+/// Running totals describing how much data a stream moved
+struct StreamStats
+{
+	uint64_t frames = 0;        // frames encoded (server) or applied (client)
+	uint64_t keyframes = 0;     // subset of `frames` that were full keyframes
+	uint64_t droppedFrames = 0; // frames skipped for a client due to backpressure
+	uint64_t bodies = 0;        // sum of bodies in the viewport over all `frames`
+	uint64_t bytes = 0;         // bytes put on (server) or taken off (client) the wire
+
+	/// @returns Average wire cost of a visible body in a single frame
+	double BytesPerBodyPerFrame() const { return bodies ? static_cast<double>(bytes) / static_cast<double>(bodies) : 0; }
+};
+
+/// Streams simulation state to any number of `FrameClient`s. Each client only receives the bodies inside its
+/// subscribed viewport. A client periodically receives a keyframe with every visible body, and otherwise a delta that
+/// only contains bodies entering or leaving its viewport and a pair of 8-bit offsets for every other body.
+///
+/// The server never blocks: frames that would grow a slow client's send queue beyond `maxPendingBytes` are dropped
+/// for that client and it receives a keyframe once the queue drains.
+class FrameServer
+{
+  public:
+	/// @param address Address to listen on
+	/// @param keyframeInterval Number of frames between keyframes sent to each client
+	/// @param maxPendingBytes Amount of unsent data a client may have queued before frames are dropped for it
+	FrameServer(const StreamAddress &address, const size_t keyframeInterval = 120,
+	            const size_t maxPendingBytes = 8 * 1024 * 1024);
+	~FrameServer();
+
+	FrameServer(const FrameServer &) = delete;
+	FrameServer &operator=(const FrameServer &) = delete;
+
+	/// Encode and queue a new frame for every subscribed client, then send as much queued data as possible
+	/// @param bodies State of the simulation to publish
+	void Publish(std::span<const Body> bodies);
+
+	/// Accept new clients, process subscriptions, and send as much queued data as possible without a new frame
+	void Poll();
+
+	/// @returns The port being listened on, which is useful when asking for an ephemeral port
+	uint16_t GetPort() const;
+
+	/// @returns The number of connected clients that have subscribed to a viewport
+	size_t GetNumSubscribers() const;
+
+	/// @returns Totals across every client
+	const StreamStats &GetStats() const;
+
+  private:
+	struct Client
+	{
+		int socket = -1;
+		bool subscribed = false;
+		bool needsKeyframe = true;
+		uint32_t framesSinceKeyframe = 0;
+		Rectangle viewport{};
+		std::vector<StreamedBody> sent;   // last state the client was sent, sorted by index
+		std::vector<std::byte> received;  // partially received messages
+		std::vector<std::byte> pending;   // encoded messages not yet sent
+		size_t pendingOffset = 0;         // amount of `pending` already sent
+	};
+
+	void Accept();
+	bool Receive(Client &client);
+	bool Flush(Client &client);
+	void Encode(Client &client);
+	void Disconnect(Client &client);
+
+  private:
+	StreamAddress _address;
+	int _listenSocket;
+	size_t _keyframeInterval, _maxPendingBytes;
+	uint32_t _frameIndex;
+	std::vector<StreamedBody> _frame; // quantized copy of the latest published bodies
+	std::vector<StreamedBody> _visible, _added;
+	std::vector<uint32_t> _removed;
+	std::vector<int8_t> _moves;
+	std::vector<Client> _clients;
+	StreamStats _stats;
+};
+
+/// Receives frames from a `FrameServer` and reconstructs the bodies inside the subscribed viewport
+class FrameClient
+{
+  public:
+	/// @param address Address of the server to connect to
+	/// @param viewport Area, in screen-space pixels, of the simulation to receive bodies for
+	FrameClient(const StreamAddress &address, const Rectangle viewport);
+	~FrameClient();
+
+	FrameClient(const FrameClient &) = delete;
+	FrameClient &operator=(const FrameClient &) = delete;
+
+	/// Change the area of the simulation to receive. The next frame received will be a keyframe.
+	void Subscribe(const Rectangle viewport);
+
+	/// Apply every complete frame that is available, waiting up to `timeoutMilliseconds` for data to arrive
+	/// @returns Whether at least one frame was applied
+	bool Receive(const int timeoutMilliseconds = 0);
+
+	/// @returns Whether the server is still connected
+	bool IsConnected() const;
+
+	/// @returns Index of the last frame applied, as counted by the server
+	uint32_t GetFrameIndex() const;
+
+	/// @returns The bodies inside the viewport as of the last frame applied, sorted by index
+	std::span<const StreamedBody> GetBodies() const;
+
+	const StreamStats &GetStats() const;
+
+  private:
+	bool Apply(const uint32_t type, std::span<const std::byte> payload);
+
+  private:
+	int _socket;
+	uint32_t _frameIndex;
+	std::vector<StreamedBody> _bodies, _retained, _added;
+	std::vector<uint32_t> _removed;
+	std::vector<std::byte> _received;
+	StreamStats _stats;
+};
+} // namespace kinematics
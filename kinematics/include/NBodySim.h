@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+#include "BarnesHut.h"
+#include "Forces.h"
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Bodies that attract each other as well as bouncing off the bounds. Uses the same layout as `StructOfVectorSim`,
+/// with gravity between every pair of bodies approximated by a `BarnesHutTree` rebuilt from the positions each step.
+/// The result is an acceleration per body, applied on top of any `Forces` in the usual pass that moves bodies.
+class NBodySim final : public StructOfVectorSim
+{
+  public:
+	/// Acceleration towards every body at once at a distance of 1. It's shared between bodies, so the pull of the
+	/// whole simulation is the same however many bodies there are.
+	static constexpr float TOTAL_STRENGTH = 1e7f;
+
+	/// @param numBodies The number of bodies to initially add to the simulation
+	/// @param theta Accuracy of the approximation, as for `BarnesHutTree::Accelerate()`
+	NBodySim(const float width, const float height, const size_t numBodies, const float theta = 0.5f);
+
+	/// @param toCopy Simulation containing the bodies to initially copy to this simulation. The originals will not be
+	/// modified.
+	/// @param theta Accuracy of the approximation, as for `BarnesHutTree::Accelerate()`
+	NBodySim(const float width, const float height, const Simulation &toCopy, const float theta = 0.5f);
+
+	/// Set the accuracy of the approximation from the next step on, as for `BarnesHutTree::Accelerate()`
+	void SetTheta(const float theta);
+	float GetTheta() const;
+
+  protected:
+	void UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+	                  float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed) override;
+
+  private:
+	float _theta;
+	BarnesHutTree _tree;
+	std::vector<float> _accelerationX, _accelerationY;
+	Forces _combined; // any forces that are set, plus gravity between bodies
+};
+} // namespace kinematics
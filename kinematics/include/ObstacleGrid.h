@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <vector>
+
+namespace kinematics
+{
+/// Static axis-aligned rectangles that bodies bounce off, in addition to the bounds of the simulation. Obstacles are
+/// binned into a uniform grid of cells, so each body only tests the few obstacles overlapping the cell it's in rather
+/// than all of them.
+///
+/// Bodies are treated as points against each obstacle grown by `BODY_RADIUS`. Like the bounds, a body only bounces
+/// when moving further in, off the nearest side, so bodies that start inside an obstacle make their way out.
+class ObstacleGrid
+{
+  public:
+	/// @param obstacles Rectangles for bodies to bounce off, which may overlap each other
+	/// @param cellSize Width and height of each cell of the grid. Cells smaller than a typical obstacle cost memory, as
+	/// each obstacle is copied into every cell it covers, but keep the number of candidates of each body small, which
+	/// matters more as a block of bodies takes as many passes as the most candidates of any of them.
+	explicit ObstacleGrid(std::vector<Rectangle> obstacles, const float cellSize = 8);
+
+	/// Bounce every body of `[begin, end)` that has moved into an obstacle. Bodies are taken a block at a time, with
+	/// each body of the block testing its first candidate obstacle, then its second, and so on, so the loop over the
+	/// block vectorizes with gathers.
+	void Collide(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY,
+	             float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed, const size_t begin,
+	             const size_t end) const;
+
+	/// Bounce a single body if it has moved into an obstacle, for layouts that don't keep fields in separate arrays
+	void Collide(const float x, const float y, float &horizontalSpeed, float &verticalSpeed) const;
+
+	/// @returns The obstacles, as given
+	std::span<const Rectangle> GetObstacles() const;
+
+	/// @returns The number of obstacles stored across every cell, which is at least the number of obstacles
+	size_t GetNumEntries() const;
+
+  private:
+	/// @returns Index of the cell containing the point, or `_numCells` for a cell without obstacles when outside
+	uint32_t GetCell(const float x, const float y) const;
+
+	/// Bounce a single body off the obstacles of `cell`, in order, stopping at the first one it's inside of
+	void Collide(const uint32_t cell, const float x, const float y, float &horizontalSpeed, float &verticalSpeed) const;
+
+  private:
+	std::vector<Rectangle> _obstacles;
+
+	float _originX, _originY; // top left of the grid, which covers every grown obstacle
+	float _inverseCellSize;
+	int _columns, _rows;
+	uint32_t _numCells;
+
+	// Obstacles of cell `c` are entries `_cellStart[c]` up to `_cellStart[c + 1]`. There is one more cell than in the
+	// grid, which is always empty, for points outside of it.
+	std::vector<uint32_t> _cellStart;
+
+	// Each entry is a copy of an obstacle grown by `BODY_RADIUS`, so a body's candidates are contiguous and need one
+	// gather per field rather than two. The last entry is empty, for bodies with fewer candidates than others.
+	std::vector<float> _left, _top, _right, _bottom;
+	uint32_t _emptyEntry;
+};
+} // namespace kinematics
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <external/glad.h>
+#include <raylib.h>
+#include <span>
+
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Draws bodies held in CPU memory as point sprites with a single draw call, rather than queueing a textured quad per
+/// body through raylib's batch. Positions and colors are packed straight into a mapped vertex buffer each frame.
+/// Requires a window (and so an OpenGL context) to exist for the lifetime of the renderer.
+class PointRenderer
+{
+  public:
+	PointRenderer();
+	~PointRenderer();
+
+	PointRenderer(const PointRenderer &) = delete;
+	PointRenderer &operator=(const PointRenderer &) = delete;
+
+	/// Draw bodies stored as parallel arrays
+	void Draw(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+	          const size_t numBodies);
+
+	/// Draw bodies stored as parallel arrays, each with a radius of its own
+	void Draw(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+	          const float *__restrict__ radius, const size_t numBodies);
+
+	/// Draw bodies stored as parallel arrays, each with a radius of its own in whole units
+	void Draw(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+	          const uint8_t *__restrict__ radius, const size_t numBodies);
+
+	/// Draw bodies stored as an array of `Body`
+	void Draw(std::span<const Body> bodies);
+
+	void Draw(const BodyFrame &frame);
+
+  private:
+	/// Matches the vertex attributes given to the shader
+	struct Vertex
+	{
+		float x, y;
+		Color color;
+	};
+
+	/// Draw bodies stored as parallel arrays, with radii as given to `SetRadii`
+	void DrawArrays(const float *__restrict__ x, const float *__restrict__ y, const Color *__restrict__ color,
+	                const void *radius, const GLenum type, const size_t size, const size_t numBodies);
+
+	/// Map room for `numBodies` (more than zero) vertices, growing the buffer if needed
+	Vertex *Map(const size_t numBodies);
+
+	/// Use `radius` of `type` as the radius of each of the next `numBodies` bodies drawn, or `BODY_RADIUS` for every
+	/// body when it's `nullptr`. Radii are uploaded as is to a buffer of their own, so bodies without radii pay
+	/// nothing extra per vertex.
+	void SetRadii(const void *radius, const GLenum type, const size_t size, const size_t numBodies);
+
+	/// Unmap and draw the first `numBodies` vertices
+	void UnmapAndDraw(const size_t numBodies);
+
+  private:
+	Shader _shader;
+	GLuint _vao, _vbo;
+	size_t _capacity;
+	GLuint _radiusVbo;
+	GLint _radiusLocation;
+};
+} // namespace kinematics
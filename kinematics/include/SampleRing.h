@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace kinematics
+{
+/// Summary of a set of samples, such as frame times, where the tail matters more than the average
+struct SampleStats
+{
+	float p50 = 0, p95 = 0, p99 = 0, max = 0;
+
+	/// @returns Nearest-rank percentiles of `samples`, which are reordered in the process
+	static SampleStats Compute(std::vector<float> &samples)
+	{
+		if (samples.empty())
+			return {};
+
+		std::sort(samples.begin(), samples.end());
+		const auto percentile = [&samples](const float fraction) {
+			const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<float>(samples.size())));
+			return samples[std::max<size_t>(rank, 1) - 1];
+		};
+		return {.p50 = percentile(0.50f), .p95 = percentile(0.95f), .p99 = percentile(0.99f), .max = samples.back()};
+	}
+};
+
+/// Keeps the most recent `N` samples written by one thread, such as the time taken by each step, so any thread can
+/// look at their distribution rather than only the latest value. Writing never waits or allocates. A reader that
+/// copies while the writer laps it may see a few samples newer than the rest, which is harmless for statistics.
+template <typename T, size_t N> class SampleRing
+{
+	static_assert(std::atomic<T>::is_always_lock_free);
+
+  public:
+	/// Add a sample, replacing the oldest once full. Must only be called by a single thread.
+	void Push(const T value)
+	{
+		const auto count = _count.load(std::memory_order_relaxed);
+		_samples[count % N].store(value, std::memory_order_relaxed);
+		_count.store(count + 1, std::memory_order_release);
+	}
+
+	/// Overwrite `samples` with the retained samples, oldest first. Reuses the memory already held by `samples`.
+	void Copy(std::vector<T> &samples) const
+	{
+		const auto count = _count.load(std::memory_order_acquire);
+		const auto retained = std::min(count, N);
+
+		samples.resize(retained);
+		for (size_t i = 0; i < retained; i++)
+			samples[i] = _samples[(count - retained + i) % N].load(std::memory_order_relaxed);
+	}
+
+	/// @returns Number of samples pushed in total, including those since replaced
+	size_t GetCount() const { return _count.load(std::memory_order_relaxed); }
+
+	static constexpr size_t GetCapacity() { return N; }
+
+  private:
+	alignas(64) std::atomic<size_t> _count{0};
+	alignas(64) std::array<std::atomic<T>, N> _samples{};
+};
+} // namespace kinematics
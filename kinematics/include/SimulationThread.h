@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "Backends.h"
+#include "Forces.h"
+#include "SampleRing.h"
+#include "TripleBuffer.h"
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// The two most recent steps of a `SimulationThread`, so a renderer can interpolate between them
+struct SteppedFrame
+{
+	BodyFrame previous, current;
+	uint64_t step = 0; // number of steps taken as of `current`
+
+	// Wall clock time `current` was published and the time since the publish before it
+	std::chrono::steady_clock::time_point time;
+	std::chrono::steady_clock::duration interval{};
+
+	float stepMicroseconds = 0; // average time spent in `Simulation::Update` for the most recent steps
+	float stepsPerSecond = 0;
+
+	std::string backend;         // name of the backend running the simulation
+	float swapMilliseconds = 0; // time taken to move the bodies to that backend, if it was swapped to
+};
+
+/// Runs a `Simulation` on a dedicated thread using a fixed time step, independent of how quickly frames are drawn.
+/// Wall clock time is accumulated and consumed in whole steps, so a slow frame results in more steps rather than one
+/// large one. If the simulation can't keep up it drops the excess time and runs at the rate it can sustain instead.
+///
+/// Other threads never touch the `Simulation` directly. Changes are queued and applied between steps, while state is
+/// read back through a lock-free `TripleBuffer`.
+class SimulationThread
+{
+  public:
+	static constexpr size_t STEP_HISTORY = 1024;
+	using StepTimes = SampleRing<float, STEP_HISTORY>;
+
+	/// @param simulation Simulation to take ownership of and update on the new thread
+	/// @param timeStep Time in seconds to progress the simulation by in each step
+	/// @param backend Name of the backend `simulation` is, to report in each frame
+	SimulationThread(std::unique_ptr<Simulation> simulation, const float timeStep, std::string backend = "");
+	~SimulationThread();
+
+	/// Set the number of bodies before the next step, up to the most the current backend can hold
+	void SetNumBodies(const size_t totalNumBodies);
+
+	/// Set the bounds of the simulation before the next step
+	void SetBounds(const float width, const float height);
+
+	/// Set the forces applied to bodies from the next step on, or none if empty. Kept by the thread, including across
+	/// backend swaps, so `forces` may be a temporary. Per body accelerations must stay valid while they're in use.
+	void SetForces(std::optional<Forces> forces);
+
+	/// Stop or resume taking steps
+	void SetPaused(const bool paused);
+
+	/// Move the bodies to a simulation created by `create` before the next step, so a different backend continues
+	/// from exactly the same state. Must not be a backend that requires OpenGL, as it's created on the simulation
+	/// thread. Backends registered with fewer `maxBodies` than the current number of bodies are ignored.
+	/// @param name Name of the backend to report in each frame, and to find it by in the registry
+	/// @param create Creates the new simulation from the current one
+	void SetBackend(std::string name, BackendFactory create);
+
+	/// @returns The most recently published frame, which stays valid until the next `AcquireFrame()` or `Interpolate()`
+	const SteppedFrame &AcquireFrame();
+
+	/// Fill `frame` with the positions of the bodies at time `now`. Rendering is kept one step behind the simulation
+	/// so positions can be interpolated between the two most recent steps rather than extrapolated.
+	/// @returns The published frame that was interpolated
+	const SteppedFrame &Interpolate(BodyFrame &frame, const std::chrono::steady_clock::time_point now);
+
+	float GetTimeStep() const;
+
+	/// @returns Microseconds spent in `Simulation::Update` by each of the most recent steps, which any thread can read
+	const StepTimes &GetStepTimes() const;
+
+  private:
+	void Run(std::stop_token stopToken);
+	bool ApplyRequests();
+
+  private:
+	static constexpr int MAX_STEPS_PER_PUBLISH = 4;
+
+	std::unique_ptr<Simulation> _simulation;
+	const float _timeStep;
+	TripleBuffer<SteppedFrame> _frames;
+	StepTimes _stepTimes;
+
+	std::mutex _requestMutex;
+	std::optional<size_t> _requestedNumBodies;
+	std::optional<std::pair<float, float>> _requestedBounds;
+	std::optional<std::pair<std::string, BackendFactory>> _requestedBackend;
+	std::optional<std::optional<Forces>> _requestedForces;
+	std::atomic<bool> _paused;
+
+	// Only used by the simulation thread, after construction
+	std::string _backend;
+	float _swapMilliseconds;
+	std::optional<Forces> _forces;
+
+	// Declared last so the thread stops before anything it uses is destroyed
+	std::jthread _thread;
+};
+} // namespace kinematics
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kinematics
+{
+/// Refers to a single body for as long as it exists, however bodies are reordered around it. Once the body is removed
+/// the handle is stale, and stays stale even after its slot is reused by another body.
+struct BodyHandle
+{
+	uint32_t slot;
+	uint32_t generation; // times the slot had been freed when the handle was given out
+
+	bool operator==(const BodyHandle &) const = default;
+};
+
+/// Maps handles to indices of elements kept densely in separate arrays, such as a Structure of Arrays, and back. The
+/// arrays themselves belong to the caller: elements are added at the end, and removing one moves the last element into
+/// its place, so the caller does the same to each of its arrays and they stay dense with no gaps to skip.
+///
+/// Each handle has a slot, which holds the element's index and counts how many times the slot has been freed. A handle
+/// only matches its slot until then, so adding, looking up and removing are all constant time.
+class SlotMap
+{
+  public:
+	/// @returns Handle for a new element at index `GetSize()`, which the caller adds to the end of its arrays
+	BodyHandle Add();
+
+	/// Remove the element of `handle`, moving the last element into its index
+	/// @returns Index the element was at, which the caller moves its last element into before removing that. Must only
+	/// be called with a handle that `Contains` the element.
+	size_t Remove(const BodyHandle handle);
+
+	/// Add elements to, or remove them from, the end until there are `size`
+	void Resize(const size_t size);
+
+	/// @returns Whether `handle` refers to an element that hasn't been removed
+	bool Contains(const BodyHandle handle) const;
+
+	/// @returns Index of the element of `handle`, which must be one that `Contains` it
+	size_t GetIndex(const BodyHandle handle) const;
+
+	/// @returns Handle of the element at `index`
+	BodyHandle GetHandle(const size_t index) const;
+
+	/// @returns Number of elements, which are at indices `[0, GetSize())`
+	size_t GetSize() const;
+
+  private:
+	/// Marks the end of the list of free slots
+	static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+	struct Slot
+	{
+		uint32_t index;      // of the element while in use, otherwise the next free slot
+		uint32_t generation; // times the slot has been freed
+	};
+
+	std::vector<Slot> _slots;
+	std::vector<uint32_t> _slotOfIndex; // slot of the element at each index
+	uint32_t _firstFree = NO_SLOT;      // most recently freed slot, which is reused first
+};
+} // namespace kinematics
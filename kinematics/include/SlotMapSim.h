@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+
+#include "SlotMap.h"
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Bodies that can be referred to by handles that stay valid as bodies are added and removed, and that any single body
+/// can be removed from. Bodies are kept densely in a Structure of Arrays exactly as `StructOfVectorSim` keeps them, so
+/// `Update()` is its loop unchanged. Removing a body moves the last body into its place.
+///
+/// Indices, such as those of bounce events or the spatial index, are those of the arrays, and `GetHandle` finds the
+/// handle of the body at one.
+class SlotMapSim final : public StructOfVectorSim
+{
+  public:
+	/// @param numBodies The number of bodies to initially add to the simulation
+	SlotMapSim(const float width, const float height, const size_t numBodies);
+
+	/// @param toCopy Simulation containing the bodies to initially copy to this simulation. The originals will not be
+	/// modified.
+	SlotMapSim(const float width, const float height, const Simulation &toCopy);
+
+	/// Add or remove bodies at the end. Handles of removed bodies become stale.
+	void SetNumBodies(const size_t totalNumBodies) override;
+
+	/// @returns Handle of `body`, added after every other body. Handles of bodies added with `AddBodies()` are found
+	/// with `GetHandle`.
+	BodyHandle AddBody(const Body body);
+
+	/// Remove the body of `handle`, moving the last body into its place
+	/// @returns Whether there was a body to remove, which there isn't if `handle` is stale
+	bool RemoveBody(const BodyHandle handle);
+
+	/// @returns Whether the body of `handle` hasn't been removed
+	bool Contains(const BodyHandle handle) const;
+
+	/// @returns Body of `handle`, which must be one the simulation `Contains`
+	Body GetBody(const BodyHandle handle) const;
+
+	/// @returns Index into `GetBodies()` of the body of `handle`, which must be one the simulation `Contains`
+	size_t GetIndex(const BodyHandle handle) const;
+
+	/// @returns Handle of the body at `index` into `GetBodies()`
+	BodyHandle GetHandle(const size_t index) const;
+
+  private:
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+  private:
+	SlotMap _handles;
+};
+} // namespace kinematics
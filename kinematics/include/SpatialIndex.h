@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <vector>
+
+#include "kinematics.h"
+
+namespace kinematics
+{
+/// Positions of bodies binned into a uniform grid, for finding the bodies in an area without scanning all of them.
+/// Set with `Simulation::SetSpatialIndex` to have it rebuilt after every step.
+///
+/// Bodies are sorted by cell, with cells in rows, so the bodies of a row of cells are contiguous along with a copy of
+/// their positions. A query scans one contiguous range per row it covers. Queries write the indices of bodies into a
+/// buffer given by the caller and return the part of it they filled, so they never allocate.
+class SpatialIndex
+{
+  public:
+	/// Average number of bodies per cell the grid is sized for
+	static constexpr float BODIES_PER_CELL = 4;
+
+	/// Rebuild the index around the positions of bodies `[0, numBodies)`, with cells covering `width` by `height`.
+	/// Bodies outside of that are kept in the nearest cell, so they're still found.
+	void Build(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY, const size_t numBodies,
+	           const float width, const float height);
+
+	/// Same as above, for layouts that don't keep fields in separate arrays
+	void Build(std::span<const Body> bodies, const float width, const float height);
+
+	/// @returns Indices of the bodies inside `area`, in order of cell rather than of body. Stops once `results` is
+	/// full, so a full span may be missing bodies.
+	std::span<const uint32_t> QueryRectangle(const Rectangle &area, std::span<uint32_t> results) const;
+
+	/// @returns Indices of the bodies within `radius` of `center`, in order of cell rather than of body. Stops once
+	/// `results` is full, so a full span may be missing bodies.
+	std::span<const uint32_t> QueryRadius(const Vector2 center, const float radius, std::span<uint32_t> results) const;
+
+	/// @returns Indices of the `results.size()` bodies nearest to `point`, nearest first, or of every body if there
+	/// are fewer
+	std::span<const uint32_t> FindNearest(const Vector2 point, std::span<uint32_t> results) const;
+
+	/// Answer many queries at once, in parallel. Each query has an equal share of `results` to fill, and `found[i]` is
+	/// set to the results of the `i`th query, as for a single query with that share.
+	void QueryRectangles(std::span<const Rectangle> areas, std::span<uint32_t> results,
+	                     std::span<std::span<const uint32_t>> found) const;
+
+	/// Same as `QueryRectangles`, for `QueryRadius` of each of `centers`
+	void QueryRadii(std::span<const Vector2> centers, const float radius, std::span<uint32_t> results,
+	                std::span<std::span<const uint32_t>> found) const;
+
+	/// Same as `QueryRectangles`, for `FindNearest` of each of `points` with as many bodies as its share of `results`
+	void FindNearest(std::span<const Vector2> points, std::span<uint32_t> results,
+	                 std::span<std::span<const uint32_t>> found) const;
+
+	size_t GetNumBodies() const;
+
+  private:
+	/// @returns Column or row of the cell containing `position`, clamped to the grid
+	int GetCell(const float position, const int numCells) const;
+
+	/// Build from positions given by `getX(i)` and `getY(i)`
+	template <typename GetX, typename GetY>
+	void BuildFrom(const GetX &getX, const GetY &getY, const size_t numBodies, const float width, const float height);
+
+	/// Call `function(begin, end)` with the sorted bodies of each row of cells covered by `area`, until it returns
+	/// false
+	template <typename Function>
+	void ForEachRow(const Rectangle &area, const Function &function) const;
+
+  private:
+	float _inverseCellSize = 1, _cellSize = 1;
+	int _columns = 0, _rows = 0;
+
+	// Bodies of cell `c` are `[_cellStart[c], _cellStart[c + 1])` of the sorted bodies
+	std::vector<uint32_t> _cellStart;
+
+	// Bodies sorted by cell, as their original index and a copy of their position. Positions are kept together as
+	// they're always read together, so building scatters each body to one fewer place.
+	std::vector<uint32_t> _indices;
+	std::vector<Vector2> _positions;
+
+	std::vector<uint32_t> _cells; // cell of each body in its original order, kept for its memory
+};
+} // namespace kinematics
@@ -0,0 +1,52 @@
+#pragma once
+
+/// Spans of time on each thread, written as a Chrome trace event file that can be opened in Perfetto or
+/// `chrome://tracing` to see where time goes across the simulation, OpenMP and drawing threads.
+///
+/// Tracing is only compiled in when `KINEMATICS_TRACING` is defined, such as by configuring with
+/// `-DKINEMATICS_TRACING=ON`. Otherwise every macro expands to nothing. When enabled, each thread records into a buffer
+/// of its own and the trace is written when the program exits, to the path in the `KINEMATICS_TRACE_FILE` environment
+/// variable or `kinematics-trace.json` in the working directory.
+#ifdef KINEMATICS_TRACING
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace kinematics::tracing
+{
+/// Records the time between its construction and destruction on the calling thread
+class Span
+{
+  public:
+	/// @param name Must outlive the program, such as a string literal, as only the pointer is kept
+	explicit Span(const char *name) : _name(name), _start(std::chrono::steady_clock::now()) {}
+	~Span();
+
+	Span(const Span &) = delete;
+	Span &operator=(const Span &) = delete;
+
+  private:
+	const char *_name;
+	std::chrono::steady_clock::time_point _start;
+};
+
+/// Name the calling thread in the trace, rather than showing it by number alone
+void SetThreadName(std::string name);
+
+/// Write every span recorded so far to `path`, in addition to the trace written on exit
+/// @returns Whether the file could be written
+bool WriteTrace(const std::string &path);
+} // namespace kinematics::tracing
+
+#define KINEMATICS_TRACE_CONCAT_IMPL(a, b) a##b
+#define KINEMATICS_TRACE_CONCAT(a, b) KINEMATICS_TRACE_CONCAT_IMPL(a, b)
+
+/// Record a span named `name` from here to the end of the enclosing scope
+#define KINEMATICS_TRACE_SCOPE(name) const ::kinematics::tracing::Span KINEMATICS_TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+/// Name the calling thread in the trace
+#define KINEMATICS_TRACE_THREAD(name) ::kinematics::tracing::SetThreadName(name)
+#else
+#define KINEMATICS_TRACE_SCOPE(name) static_cast<void>(0)
+#define KINEMATICS_TRACE_THREAD(name) static_cast<void>(0)
+#endif
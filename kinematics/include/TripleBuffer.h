@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace kinematics
+{
+/// Hands the latest version of a `T` from one writer thread to one reader thread without either waiting on the other.
+/// The writer fills in `Back()` and calls `Publish()`, while the reader calls `Acquire()` to get the newest published
+/// buffer, which it may keep using until its next `Acquire()`. A third buffer sits between the two so neither ever
+/// has to wait for the other to finish, at the cost of the reader skipping versions it was too slow to see.
+template <typename T> class TripleBuffer
+{
+  public:
+	TripleBuffer() : _back(0), _middle(1), _front(2) {}
+
+	/// @returns The buffer owned by the writer, which readers can't see until `Publish()`
+	T &Back() { return _buffers[_back]; }
+
+	/// Make the back buffer the newest version for the reader. The writer gets an older buffer to reuse as the new
+	/// back buffer, so its contents should be overwritten rather than assumed.
+	void Publish() { _back = _middle.exchange(_back | NEW_FLAG, std::memory_order_acq_rel) & INDEX_MASK; }
+
+	/// @returns Whether something was published since the last `Acquire()`
+	bool HasNew() const { return _middle.load(std::memory_order_relaxed) & NEW_FLAG; }
+
+	/// @returns The newest published buffer, which won't be modified until the next call to `Acquire()`
+	const T &Acquire()
+	{
+		if (HasNew())
+			_front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX_MASK;
+		return _buffers[_front];
+	}
+
+  private:
+	static constexpr uint8_t INDEX_MASK = 0b011;
+	static constexpr uint8_t NEW_FLAG = 0b100;
+
+	// Keep the indices owned by each thread, and the shared one, on separate cache lines to avoid false sharing
+	alignas(64) uint8_t _back;
+	alignas(64) std::atomic<uint8_t> _middle;
+	alignas(64) uint8_t _front;
+	std::array<T, 3> _buffers;
+};
+} // namespace kinematics
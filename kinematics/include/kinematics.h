@@ -1,9 +1,14 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <external/glad.h>
+#include <memory>
 #include <raylib.h>
+#include <span>
 #include <vector>
 
+#include "TripleBuffer.h"
+
 #if __has_cpp_attribute(assume)
 #define ASSUME(...) [[assume(__VA_ARGS__)]]
 #else
@@ -23,6 +28,21 @@ struct Body
 	Color color;
 };
 
+/// Positions and colors of every body at a single point in time, which is everything needed to draw or export them.
+/// Stored as parallel arrays so they can be copied in bulk from Structure of Arrays layouts.
+struct BodyFrame
+{
+	std::vector<float> x, y; // center position
+	std::vector<Color> color;
+	std::vector<float> radius = {}; // empty when every body has a radius of `BODY_RADIUS`
+};
+
+class BounceEvents;
+struct Forces;
+class ObstacleGrid;
+class PointRenderer;
+class SpatialIndex;
+
 /// Describes how the simulated "world" behaves. This includes multiple `Body` objects that bounce around the screen.
 class Simulation
 {
@@ -47,29 +67,105 @@ class Simulation
 	/// @totalNumBodies The amount of bodies to have in the simulation
 	virtual void SetNumBodies(const size_t totalNumBodies) = 0;
 
+	/// Add `bodies` after every existing body. They're handed to the implementation a batch at a time rather than a
+	/// body at a time, so adding many at once, such as from a spawner every frame, costs little more than a copy.
+	void AddBodies(std::span<const Body> bodies);
+
+	/// Same as above, from a separate array of `numBodies` values for each field
+	void AddBodies(const float *x, const float *y, const float *horizontalSpeed, const float *verticalSpeed,
+	               const Color *color, const size_t numBodies);
+
 	/// @returns The number of bodies in the simulation
 	virtual size_t GetNumBodies() const = 0;
 
 	/// @returns A vector of copies of the contained bodies
 	virtual std::vector<Body> GetBodies() const = 0;
 
+	/// @returns The radius of every body, or nothing when every body has a radius of `BODY_RADIUS`. Only
+	/// `VariableRadiusSim` keeps a radius per body, so no other implementation pays memory for them.
+	virtual std::vector<float> GetRadii() const;
+
+	/// Overwrite `frame` with the current position, color and radius of every body. Reuses the memory already held by
+	/// `frame`.
+	virtual void CopyFrame(BodyFrame &frame) const;
+
+	/// Copy the current state into the back buffer of `frames` and publish it, so another thread can draw or export
+	/// it while this simulation continues to update
+	void PublishFrame(TripleBuffer<BodyFrame> &frames) const;
+
 	/// Set the bounds of the simulation
-	void SetBounds(const float width, const float height);
+	virtual void SetBounds(const float width, const float height);
+
+	float GetWidth() const;
+	float GetHeight() const;
+
+	/// Record the bounces of every following step into `events`, or stop recording with `nullptr`. Steps only look for
+	/// bounces to record while subscribed. `ShaderSim` keeps its bodies on the GPU and records nothing.
+	/// @param events Where to record bounces, which must outlive the subscription
+	virtual void SetBounceEvents(BounceEvents *events);
+
+	/// Bounce bodies off every obstacle of `obstacles` as well as the bounds, or only the bounds with `nullptr`.
+	/// `ShaderSim` keeps its bodies on the GPU and ignores obstacles.
+	/// @param obstacles Obstacles to bounce off, which must outlive their use by this simulation
+	virtual void SetObstacles(const ObstacleGrid *obstacles);
+
+	/// Accelerate bodies by `forces` on every following step, or move them at constant speeds with `nullptr`. Forces
+	/// can be changed between steps, such as to move a field with the mouse. `ShaderSim` keeps its bodies on the GPU
+	/// and ignores forces.
+	/// @param forces Forces to apply, which must outlive their use by this simulation
+	virtual void SetForces(const Forces *forces);
+
+	/// Keep `index` up to date with the positions of bodies, rebuilding it now, after every following step and whenever
+	/// bodies are added or removed, or stop with `nullptr`. Queries on the index then answer for the most recent step
+	/// without scanning every body. `ShaderSim` keeps its bodies on the GPU and never updates the index.
+	/// @param index Index to keep up to date, which must outlive the subscription
+	virtual void SetSpatialIndex(SpatialIndex *index);
 
   protected:
 	Body GenerateRandomBody() const;
 
+	/// Add `numBodies` bodies from `GenerateRandomBody()` after every existing body, a batch at a time
+	void AddRandomBodies(const size_t numBodies);
+
+	/// @returns Renderer shared by CPU implementations to draw all bodies at once, created on the first call. Must only
+	/// be called from the thread with the OpenGL context.
+	PointRenderer &GetRenderer() const;
+
 	// TODO: there's probably a better place for these
 	bool BounceCheck(const float position, const float speed, const float bounds) const;
 	virtual void UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
 	                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed);
 
+	/// Same as `UpdateHelper` on the calling thread, also recording every bounce into `_bounceEvents`
+	void UpdateAndRecordBounces(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+	                            float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed);
+
+	/// Same as `UpdateHelper` on the calling thread, also accelerating bodies by `_forces`
+	void UpdateAndApplyForces(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
+	                          float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed);
+
+	/// Rebuild `_spatialIndex`, if any, around the positions of every body after a step
+	void UpdateSpatialIndex(const float *__restrict__ bodiesX, const float *__restrict__ bodiesY);
+
+	/// Rebuild `_spatialIndex`, if any, from a copy of the bodies after they're added or removed between steps, so
+	/// queries never answer with indices of bodies that are gone
+	virtual void RebuildSpatialIndex();
+
   private:
-	virtual void AddRandomBody() = 0;
+	/// Copy `numBodies` bodies, given as a separate array for each field, after every existing body in one go
+	virtual void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                          const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                          const Color *__restrict__ color, const size_t numBodies) = 0;
 
   protected:
 	float _width, _height;
-	RenderTexture2D _bodyRender;
+	BounceEvents *_bounceEvents = nullptr; // subscriber to bounces, if any
+	const ObstacleGrid *_obstacles = nullptr;
+	const Forces *_forces = nullptr;
+	SpatialIndex *_spatialIndex = nullptr; // subscriber to positions, if any
+
+  private:
+	mutable std::unique_ptr<PointRenderer> _renderer;
 };
 
 class VectorOfStructSim final : public Simulation
@@ -87,9 +183,12 @@ class VectorOfStructSim final : public Simulation
 	void SetNumBodies(const size_t totalNumBodies) override;
 	size_t GetNumBodies() const override;
 	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
 
   private:
-	void AddRandomBody() override;
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
 
   private:
 	std::vector<Body> _bodies;
@@ -110,12 +209,13 @@ class StructOfVectorSim : public Simulation
 	void SetNumBodies(const size_t totalNumBodies) override;
 	size_t GetNumBodies() const override;
 	std::vector<Body> GetBodies() const override;
-
-  private:
-	void AddBody(const Body body); // TODO: should this be on base class?
-	void AddRandomBody() override;
+	void CopyFrame(BodyFrame &frame) const override;
 
   protected:
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
 	struct Bodies
 	{
 		std::vector<float> x, y; // center position
@@ -169,10 +269,15 @@ class StructOfPointerSim final : public Simulation
 	void SetNumBodies(const size_t totalNumBodies) override;
 	size_t GetNumBodies() const override;
 	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
 
   private:
-	void AddBody(const Body body);
-	void AddRandomBody() override;
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+	/// Move the bodies to memory that can fit `maxBodies` of them
+	void Reallocate(const size_t maxBodies);
 
   private:
 	struct Bodies
@@ -203,13 +308,18 @@ class StructOfAlignedSim final : public Simulation
 	void SetNumBodies(const size_t totalNumBodies) override;
 	size_t GetNumBodies() const override;
 	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
 
 	void UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
 	                  float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed) final;
 
   private:
-	void AddBody(const Body body);
-	void AddRandomBody() override;
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+	/// Move the bodies to memory that can fit `maxBodies` of them
+	void Reallocate(const size_t maxBodies);
 
   private:
 	struct Bodies
@@ -240,13 +350,18 @@ class StructOfOversizedSim final : public Simulation
 	void SetNumBodies(const size_t totalNumBodies) override;
 	size_t GetNumBodies() const override;
 	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
 
 	void UpdateHelper(const float deltaTime, float *__restrict__ bodiesX, float *__restrict__ bodiesY,
 	                  float *__restrict__ bodiesHorizontalSpeed, float *__restrict__ bodiesVerticalSpeed) final;
 
   private:
-	void AddBody(const Body body);
-	void AddRandomBody() override;
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+	/// Move the bodies to memory that can fit `maxBodies` of them
+	void Reallocate(const size_t maxBodies);
 
   private:
 	struct Bodies
@@ -276,10 +391,12 @@ template <size_t MAX_SIZE> class StructOfArraySim final : public Simulation
 	void SetNumBodies(const size_t totalNumBodies) override;
 	size_t GetNumBodies() const override;
 	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
 
   private:
-	void AddBody(const Body body);
-	void AddRandomBody() override;
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
 
   private:
 	struct Bodies
@@ -292,6 +409,95 @@ template <size_t MAX_SIZE> class StructOfArraySim final : public Simulation
 	size_t _numBodies;
 };
 
+/// Structure of Arrays layout with a radius per body, kept as a column of its own next to positions and speeds so the
+/// update still vectorizes. `float` radii are exact, while `uint8_t` radii are rounded to whole units up to 255 but
+/// stream a quarter of the memory. Obstacles are still tested at `BODY_RADIUS`, and bodies added with `AddBodies()`
+/// have that radius, while random bodies have a random one.
+template <typename RadiusType> class VariableRadiusSim final : public Simulation
+{
+  public:
+	/// Range of radii given to random bodies
+	static constexpr int MIN_RADIUS = 4, MAX_RADIUS = 16;
+
+	/// @param numBodies The number of bodies to initially add to the simulation
+	VariableRadiusSim(const float width, const float height, const size_t numBodies);
+
+	/// @param toCopy Simulation containing the bodies, and radii if it has any, to initially copy to this simulation.
+	/// The originals will not be modified.
+	VariableRadiusSim(const float width, const float height, const Simulation &toCopy);
+
+	void Update(const float deltaTime) override;
+	void Draw() const override;
+	void SetNumBodies(const size_t totalNumBodies) override;
+	size_t GetNumBodies() const override;
+	std::vector<Body> GetBodies() const override;
+	std::vector<float> GetRadii() const override;
+	void CopyFrame(BodyFrame &frame) const override;
+
+  private:
+	void AddBody(const Body body, const float radius);
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+  private:
+	struct Bodies
+	{
+		std::vector<float> x, y; // center position
+		std::vector<float> horizontalSpeed, verticalSpeed;
+		std::vector<Color> color;
+		std::vector<RadiusType> radius;
+	};
+	Bodies _bodies;
+};
+
+/// Structure of Arrays layout with positions and speeds stored as `Scalar`, instantiated for `float` and `double`.
+/// `double` keeps long runs from drifting, at half as many bodies per SIMD register and twice the memory per body,
+/// while `float` is the same as `StructOfVectorSim`. Bodies are still read as `Body`, so are rounded to `float` on the
+/// way out. Forces and obstacles are given in `float`, so are applied a body at a time, with only the change they make
+/// to a speed rounded to `float`.
+template <typename Scalar> class PrecisionSim final : public Simulation
+{
+  public:
+	/// @param numBodies The number of bodies to initially add to the simulation
+	PrecisionSim(const float width, const float height, const size_t numBodies);
+
+	/// @param toCopy Simulation containing the bodies to initially copy to this simulation. The originals will not be
+	/// modified.
+	PrecisionSim(const float width, const float height, const Simulation &toCopy);
+
+	void Update(const float deltaTime) override;
+	void Draw() const override;
+	void SetNumBodies(const size_t totalNumBodies) override;
+	size_t GetNumBodies() const override;
+	std::vector<Body> GetBodies() const override;
+	void CopyFrame(BodyFrame &frame) const override;
+
+  private:
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
+
+	/// Same as `Update`, a body at a time, accelerating by `_forces`, recording bounces into `_bounceEvents` and
+	/// colliding with `_obstacles` for whichever are set
+	void UpdateOneAtATime(const float deltaTime);
+
+	/// Round the position of every body to `float` into `_roundedX` and `_roundedY`
+	void RoundPositions() const;
+
+  private:
+	struct Bodies
+	{
+		std::vector<Scalar> x, y; // center position
+		std::vector<Scalar> horizontalSpeed, verticalSpeed;
+		std::vector<Color> color;
+	};
+	Bodies _bodies;
+
+	// Positions rounded to `float`, for drawing and the spatial index
+	mutable std::vector<float> _roundedX, _roundedY;
+};
+
 class ShaderSim final : public Simulation
 {
   public:
@@ -307,7 +513,9 @@ class ShaderSim final : public Simulation
 	std::vector<Body> GetBodies() const override;
 
   private:
-	void AddRandomBody() override;
+	void AppendBodies(const float *__restrict__ x, const float *__restrict__ y,
+	                  const float *__restrict__ horizontalSpeed, const float *__restrict__ verticalSpeed,
+	                  const Color *__restrict__ color, const size_t numBodies) override;
 
   private:
 	size_t _numBodies;
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <raylib.h>
+#include <string>
+#include <thread>
+
+#include <FrameStream.h>
+#include <kinematics.h>
+
+/// Parse an address argument, which is either a TCP port or a path to a Unix domain socket
+/// @returns The address, or nothing for a port outside [1, 65535]
+std::optional<kinematics::StreamAddress> ParseAddress(const std::string &argument)
+{
+	if (!argument.empty() && argument.find_first_not_of("0123456789") == std::string::npos)
+	{
+		// Checking the length first keeps `stoi` from throwing on ports too long for an `int`
+		const int port = argument.size() <= 5 ? std::stoi(argument) : 0;
+		if (port < 1 || port > UINT16_MAX)
+			return std::nullopt;
+
+		return kinematics::StreamAddress::Tcp("0.0.0.0", static_cast<uint16_t>(port));
+	}
+
+	return kinematics::StreamAddress::Unix(argument);
+}
+
+void Run(const size_t startingNumBodies, const kinematics::StreamAddress &address)
+{
+	constexpr float TIME_STEP = 1.f / 60.f;
+	constexpr auto FRAME_DURATION = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<float>(TIME_STEP));
+
+	kinematics::OmpForSim simulation(800, 600, startingNumBodies);
+	kinematics::FrameServer server(address);
+
+	auto nextFrame = std::chrono::steady_clock::now();
+	auto nextReport = nextFrame + std::chrono::seconds(1);
+	kinematics::StreamStats lastStats;
+	while (true)
+	{
+		simulation.Update(TIME_STEP);
+		server.Publish(simulation.GetBodies());
+
+		// Keep sending queued data to slow clients while waiting for the next frame
+		nextFrame += FRAME_DURATION;
+		while (std::chrono::steady_clock::now() < nextFrame)
+		{
+			server.Poll();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		if (nextFrame >= nextReport)
+		{
+			const auto &stats = server.GetStats();
+			const kinematics::StreamStats interval{.frames = stats.frames - lastStats.frames,
+			                                       .keyframes = stats.keyframes - lastStats.keyframes,
+			                                       .droppedFrames = stats.droppedFrames - lastStats.droppedFrames,
+			                                       .bodies = stats.bodies - lastStats.bodies,
+			                                       .bytes = stats.bytes - lastStats.bytes};
+			std::printf("clients: %zu\tframes: %lu\tkeyframes: %lu\tdropped: %lu\tKiB: %lu\tbytes/body/frame: %.2f\n",
+			            server.GetNumSubscribers(), interval.frames, interval.keyframes, interval.droppedFrames,
+			            interval.bytes / 1024, interval.BytesPerBodyPerFrame());
+			std::fflush(stdout);
+
+			lastStats = stats;
+			nextReport += std::chrono::seconds(1);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const size_t startingNumBodies = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 1;
+	const std::string addressArgument = argc > 2 ? argv[2] : "7420";
+	const auto address = ParseAddress(addressArgument);
+	if (!address)
+	{
+		std::fprintf(stderr, "Invalid port %s, which must be from 1 to 65535\n", addressArgument.c_str());
+		return EXIT_FAILURE;
+	}
+
+	// There is no window to seed the random number generator
+	SetRandomSeed(static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count()));
+
+	Run(startingNumBodies, *address);
+	return 0;
+}
@@ -0,0 +1,22 @@
+#version 430 core
+
+// Input vertex attributes, matching the names raylib looks up for its default shader
+in vec3 vertexPosition;
+in vec4 vertexColor;
+
+// Radius of each body, or the same for every body when given as a constant rather than an array
+in float vertexRadius;
+
+uniform mat4 mvp;
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+	fragTexCoord = vec2(0);
+	fragColor = vertexColor;
+	gl_Position = mvp * vec4(vertexPosition, 1);
+	gl_PointSize = 2 * vertexRadius;
+}
@@ -0,0 +1,359 @@
+#!/usr/bin/env python3
+"""Store benchmark results and compare them for statistically significant regressions.
+
+Results are stored as JSON files under a results directory, one per combination of CPU model, compiler and git
+commit, so runs of the same commit built with a different compiler (or on a different machine) never overwrite each
+other:
+
+    <results>/<cpu>/<compiler>/<commit>.json
+
+Understands the output of:
+  * the `[update]` harness of `kinematics-demo-bench`, written with `--json <file>`
+  * any other Catch2 benchmark of `kinematics-demo-bench`, written with `--reporter xml::out=<file>`
+  * Google benchmark programs such as `videos/lto` and `videos/false-sharing`, written with
+    `--benchmark_out=<file> --benchmark_out_format=json`. Use `--benchmark_repetitions` so there is a spread of
+    samples to test, and `--suite` to tell apart programs with generic names such as `default` and `lto`.
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import json
+import math
+import re
+import subprocess
+import sys
+import xml.etree.ElementTree as ElementTree
+from datetime import datetime, timezone
+from pathlib import Path
+
+DEFAULT_RESULTS = Path(__file__).resolve().parent.parent / "bench-results"
+
+TIME_UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+# Benchmark names in `kinematics-demo-bench` look like "Draw OmpForSim: 1000"
+CATCH_NAME = re.compile(r"^(?P<operation>.+?) (?P<backend>\S+): (?P<size>\d+)$")
+
+
+def record(suite, operation, backend, size, mean, stddev, n, samples=None):
+    """A single result in the form every input is converted to. Times are in seconds."""
+    return {
+        "suite": suite,
+        "operation": operation,
+        "backend": backend,
+        "size": size,
+        "mean": mean,
+        "stddev": stddev,
+        "n": n,
+        "samples": samples or [],
+    }
+
+
+def result_key(result):
+    return (result["suite"], result["operation"], result["backend"], result["size"])
+
+
+def summarize(samples):
+    mean = sum(samples) / len(samples)
+    if len(samples) < 2:
+        return mean, 0.0
+    return mean, math.sqrt(sum((sample - mean) ** 2 for sample in samples) / (len(samples) - 1))
+
+
+def load_harness(document):
+    """Results of the `[update]` harness, which come with every sample"""
+    results = []
+    for result in document["results"]:
+        samples = result["samples"]
+        mean, stddev = summarize(samples)
+        results.append(
+            record(
+                "kinematics-demo-bench",
+                result["benchmark"],
+                result["implementation"],
+                result["numBodies"],
+                mean,
+                stddev,
+                len(samples),
+                samples,
+            )
+        )
+    host = document.get("host", {})
+    return results, {"cpu": host.get("cpu"), "compiler": host.get("compiler")}
+
+
+def load_google(document, suite):
+    """Results of a Google benchmark program. Repetitions are used as samples when available, otherwise the
+    aggregates reported for them."""
+    runs = {}
+    aggregates = {}
+    for benchmark in document.get("benchmarks", []):
+        name = benchmark.get("run_name", benchmark["name"])
+        seconds = benchmark["real_time"] * TIME_UNITS[benchmark.get("time_unit", "ns")]
+        if benchmark.get("run_type") == "aggregate":
+            aggregates.setdefault(name, {})[benchmark["aggregate_name"]] = seconds
+            aggregates[name]["repetitions"] = benchmark.get("repetitions", 1)
+        else:
+            runs.setdefault(name, []).append(seconds)
+
+    results = []
+    for name in sorted(set(runs) | set(aggregates)):
+        # Names look like "namespace::function/size[/more arguments]"
+        parts = name.split("/")
+        size = next((int(part) for part in parts[1:] if part.isdigit()), 0)
+        backend, _, operation = parts[0].rpartition("::")
+
+        if name in runs:
+            mean, stddev = summarize(runs[name])
+            results.append(record(suite, operation, backend or suite, size, mean, stddev, len(runs[name]), runs[name]))
+        elif "mean" in aggregates[name]:
+            aggregate = aggregates[name]
+            results.append(
+                record(
+                    suite,
+                    operation,
+                    backend or suite,
+                    size,
+                    aggregate["mean"],
+                    aggregate.get("stddev", 0.0),
+                    aggregate["repetitions"],
+                )
+            )
+    return results, {}
+
+
+def load_catch_xml(path):
+    """Results of Catch2 `BENCHMARK`s from its XML reporter, which only has summary statistics"""
+    results = []
+    for benchmark in ElementTree.parse(path).iter("BenchmarkResults"):
+        name = benchmark.get("name")
+        match = CATCH_NAME.match(name)
+        if match:
+            operation, backend, size = match["operation"], match["backend"], int(match["size"])
+        else:
+            operation, backend, size = name, "", 0
+
+        mean = float(benchmark.find("mean").get("value")) * TIME_UNITS["ns"]
+        stddev = float(benchmark.find("standardDeviation").get("value")) * TIME_UNITS["ns"]
+        results.append(
+            record("kinematics-demo-bench", operation, backend, size, mean, stddev, int(benchmark.get("samples")))
+        )
+    return results, {}
+
+
+def load(path, suite=None):
+    """Convert any supported output into results, along with whatever the file says about where it was run"""
+    text = Path(path).read_text()
+    if text.lstrip().startswith("<"):
+        return load_catch_xml(path)
+
+    document = json.loads(text)
+    if "results" in document and "host" in document:
+        return load_harness(document)
+    if "benchmarks" in document:
+        return load_google(document, suite or Path(document.get("context", {}).get("executable", path)).name)
+    raise ValueError(f"{path}: not a recognized benchmark output")
+
+
+def host_cpu():
+    try:
+        for line in Path("/proc/cpuinfo").read_text().splitlines():
+            if line.startswith("model name"):
+                return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return "unknown"
+
+
+def git_commit():
+    try:
+        commit = subprocess.run(
+            ["git", "rev-parse", "--short=12", "HEAD"], capture_output=True, text=True, check=True
+        ).stdout.strip()
+        dirty = subprocess.run(
+            ["git", "status", "--porcelain", "--untracked-files=no"], capture_output=True, text=True, check=True
+        ).stdout.strip()
+        return commit + ("-dirty" if dirty else "")
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def slug(text):
+    return re.sub(r"[^A-Za-z0-9.+-]+", "-", text).strip("-").lower() or "unknown"
+
+
+def store(args):
+    results, cpu, compiler = [], args.cpu, args.compiler
+    for path in args.inputs:
+        loaded, host = load(path, args.suite)
+        results += loaded
+        cpu = cpu or host.get("cpu")
+        compiler = compiler or host.get("compiler")
+
+    if not compiler:
+        sys.exit("error: the compiler isn't recorded in these results, so it must be given with --compiler")
+    cpu = cpu or host_cpu()
+    commit = args.commit or git_commit()
+
+    path = args.results / slug(cpu) / slug(compiler) / f"{slug(commit)}.json"
+    entry = {"commit": commit, "compiler": compiler, "cpu": cpu, "results": []}
+    if path.exists():
+        entry = json.loads(path.read_text())
+
+    # Newer results replace older ones for the same benchmark, so a suite can be rerun on its own
+    merged = {result_key(result): result for result in entry["results"]}
+    merged.update({result_key(result): result for result in results})
+    entry["results"] = sorted(merged.values(), key=lambda result: tuple(str(part) for part in result_key(result)))
+    entry["updated"] = datetime.now(timezone.utc).isoformat(timespec="seconds")
+
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_text(json.dumps(entry, indent=1) + "\n")
+    print(f"Stored {len(results)} results in {path}")
+
+
+def find_entry(results_dir, selector, cpu):
+    """A stored entry from either its path or `commit[@compiler]`, looked up for the given CPU"""
+    if Path(selector).is_file():
+        return json.loads(Path(selector).read_text())
+
+    commit, _, compiler = selector.partition("@")
+    pattern = f"{slug(compiler) if compiler else '*'}/{slug(commit)}*.json"
+    matches = sorted((results_dir / slug(cpu)).glob(pattern))
+    if len(matches) != 1:
+        found = ", ".join(str(match.relative_to(results_dir)) for match in matches) or "nothing"
+        sys.exit(f"error: '{selector}' should match one stored result for '{cpu}', but found {found}")
+    return json.loads(matches[0].read_text())
+
+
+def incomplete_beta(x, a, b):
+    """Regularized incomplete beta function, evaluated with a continued fraction"""
+    if x <= 0:
+        return 0.0
+    if x >= 1:
+        return 1.0
+    if x > (a + 1) / (a + b + 2):
+        return 1.0 - incomplete_beta(1.0 - x, b, a)
+
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) + a * math.log(x) + b * math.log(1 - x)) / a
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    fraction = d
+    for m in range(1, 300):
+        for numerator in (
+            m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+            -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1)),
+        ):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            fraction *= c * d
+        if abs(c * d - 1.0) < 1e-12:
+            break
+    return front * fraction
+
+
+def welch_p_value(baseline, candidate):
+    """Two-sided p-value of Welch's t-test that the means differ, or None if there aren't enough samples"""
+    if baseline["n"] < 2 or candidate["n"] < 2:
+        return None
+
+    baseline_error = baseline["stddev"] ** 2 / baseline["n"]
+    candidate_error = candidate["stddev"] ** 2 / candidate["n"]
+    error = baseline_error + candidate_error
+    if error == 0:
+        return 0.0 if baseline["mean"] != candidate["mean"] else 1.0
+
+    t = (candidate["mean"] - baseline["mean"]) / math.sqrt(error)
+    degrees = error**2 / (
+        baseline_error**2 / (baseline["n"] - 1) + candidate_error**2 / (candidate["n"] - 1)
+    )
+    return incomplete_beta(degrees / (degrees + t * t), degrees / 2, 0.5)
+
+
+def compare(args):
+    cpu = args.cpu or host_cpu()
+    baseline = find_entry(args.results, args.baseline, cpu)
+    candidate = find_entry(args.results, args.candidate, cpu)
+    print(f"Baseline:  {baseline['commit']} built with {baseline['compiler']} on {baseline['cpu']}")
+    print(f"Candidate: {candidate['commit']} built with {candidate['compiler']} on {candidate['cpu']}")
+
+    baseline_results = {result_key(result): result for result in baseline["results"]}
+    regressions = 0
+    suite = None
+    for result in candidate["results"]:
+        key = result_key(result)
+        if key not in baseline_results:
+            continue
+        before = baseline_results[key]
+
+        change = result["mean"] / before["mean"] - 1 if before["mean"] else 0.0
+        p = welch_p_value(before, result)
+        significant = p is not None and p < args.alpha and abs(change) >= args.threshold
+        if significant and change > 0:
+            status, regressions = "REGRESSION", regressions + 1
+        elif significant:
+            status = "improvement"
+        elif p is None and abs(change) >= args.threshold:
+            status = "untested"  # too few samples to tell noise apart from a change
+        else:
+            status = ""
+
+        if args.all or status:
+            if key[0] != suite:
+                suite = key[0]
+                print(f"\n{suite}")
+            name = f"{result['operation']} {result['backend']}: {result['size']}"
+            p_text = f"{p:.4f}" if p is not None else "-"
+            print(
+                f"  {name:<48} {before['mean'] * 1e6:>12.3f} us {result['mean'] * 1e6:>12.3f} us {change:>+8.1%}"
+                f"  p={p_text:<7} {status}"
+            )
+
+    print(f"\n{regressions} significant regression(s)")
+    return 1 if regressions else 0
+
+
+def list_entries(args):
+    for path in sorted(args.results.glob("*/*/*.json")):
+        entry = json.loads(path.read_text())
+        print(f"{entry['commit']:<20} {entry['compiler']:<32} {entry['cpu']:<48} {len(entry['results'])} results")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--results", type=Path, default=DEFAULT_RESULTS, help="directory results are stored in")
+    parser.add_argument("--cpu", help="CPU model, instead of the one recorded in the results or of this host")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    store_parser = commands.add_parser("store", help="add benchmark output to the results")
+    store_parser.add_argument("inputs", nargs="+", help="benchmark output files")
+    store_parser.add_argument("--commit", help="commit the results are for, instead of the current one")
+    store_parser.add_argument("--compiler", help="compiler used, such as 'gcc 14.2', when not in the results")
+    store_parser.add_argument(
+        "--suite", help="name for Google benchmark results, such as 'lto-default', instead of the executable's name"
+    )
+    store_parser.set_defaults(run=store)
+
+    compare_parser = commands.add_parser(
+        "compare", help="flag significant differences, exiting with 1 if anything regressed"
+    )
+    compare_parser.add_argument("baseline", help="stored file, or commit[@compiler] to look up")
+    compare_parser.add_argument("candidate", help="stored file, or commit[@compiler] to look up")
+    compare_parser.add_argument("--alpha", type=float, default=0.01, help="significance level of Welch's t-test")
+    compare_parser.add_argument(
+        "--threshold", type=float, default=0.05, help="smallest relative change worth reporting"
+    )
+    compare_parser.add_argument("--all", action="store_true", help="show unchanged benchmarks too")
+    compare_parser.set_defaults(run=compare)
+
+    list_parser = commands.add_parser("list", help="show stored results")
+    list_parser.set_defaults(run=list_entries)
+
+    args = parser.parse_args()
+    sys.exit(args.run(args))
+
+
+if __name__ == "__main__":
+    main()